@@ -0,0 +1,159 @@
+#include "allies.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace UT {
+namespace {
+
+constexpr auto Ignored = -std::numeric_limits<float>::infinity();
+
+constexpr bool Less(const Allies::Entry& lhs, const Allies::Entry& rhs) noexcept
+{
+  return lhs.score < rhs.score;
+}
+
+}  // namespace
+
+void Allies::Update(std::uint32_t id, const Triage::Member& member, const Triage::Thresholds& thresholds) noexcept
+{
+  const auto score = GetScore(member, thresholds);
+  const auto index = Find(id);
+  if (index < size_) {
+    if (score == Ignored) {
+      Erase(index);
+      return;
+    }
+    const auto previous = entries_[index].score;
+    entries_[index] = { id, score, true, member };
+    if (score > previous) {
+      SiftUp(index);
+    } else {
+      SiftDown(index);
+    }
+    return;
+  }
+  if (score == Ignored) {
+    return;
+  }
+  if (size_ < Capacity) {
+    entries_[size_] = { id, score, true, member };
+    SiftUp(size_++);
+    return;
+  }
+
+  // Replace the lowest score, which is always a leaf.
+  auto lowest = size_ / 2;
+  for (auto i = lowest + 1; i < size_; i++) {
+    if (entries_[i].score < entries_[lowest].score) {
+      lowest = i;
+    }
+  }
+  if (score > entries_[lowest].score) {
+    entries_[lowest] = { id, score, true, member };
+    SiftUp(lowest);
+  }
+}
+
+void Allies::Remove(std::uint32_t id) noexcept
+{
+  if (const auto index = Find(id); index < size_) {
+    Erase(index);
+  }
+}
+
+void Allies::Prune() noexcept
+{
+  const auto begin = entries_.begin();
+  const auto end = std::remove_if(begin, begin + size_, [](const Entry& entry) noexcept {
+    return !entry.sampled;
+  });
+  size_ = static_cast<std::size_t>(end - begin);
+  std::make_heap(begin, end, Less);
+  for (auto it = begin; it != end; ++it) {
+    it->sampled = false;
+  }
+}
+
+void Allies::Clear() noexcept
+{
+  size_ = 0;
+}
+
+const Allies::Entry* Allies::Top() const noexcept
+{
+  return size_ ? &entries_[0] : nullptr;
+}
+
+std::size_t Allies::GetSize() const noexcept
+{
+  return size_;
+}
+
+float Allies::GetScore(const Triage::Member& member, const Triage::Thresholds& thresholds) noexcept
+{
+  if (
+    !member.present || member.dead || member.health <= thresholds.floor || member.distance >= thresholds.range ||
+    thresholds.range <= 0.0f)
+  {
+    return Ignored;
+  }
+
+  // Same condition as a triage time within the lookahead.
+  const auto deficit = thresholds.ally - member.health;
+  const auto predicted = std::max(member.rate, 0.0f) * thresholds.lookahead;
+  if (deficit + predicted < 0.0f) {
+    return Ignored;
+  }
+  return deficit + predicted - Distance * member.distance / thresholds.range;
+}
+
+std::size_t Allies::Find(std::uint32_t id) const noexcept
+{
+  std::size_t index = 0;
+  while (index < size_ && entries_[index].id != id) {
+    index++;
+  }
+  return index;
+}
+
+void Allies::Erase(std::size_t index) noexcept
+{
+  if (index != --size_) {
+    entries_[index] = entries_[size_];
+    SiftUp(index);
+    SiftDown(index);
+  }
+}
+
+void Allies::SiftUp(std::size_t index) noexcept
+{
+  while (index) {
+    const auto parent = (index - 1) / 2;
+    if (!Less(entries_[parent], entries_[index])) {
+      break;
+    }
+    std::swap(entries_[parent], entries_[index]);
+    index = parent;
+  }
+}
+
+void Allies::SiftDown(std::size_t index) noexcept
+{
+  while (true) {
+    auto largest = index;
+    for (const auto child : { 2 * index + 1, 2 * index + 2 }) {
+      if (child < size_ && Less(entries_[largest], entries_[child])) {
+        largest = child;
+      }
+    }
+    if (largest == index) {
+      break;
+    }
+    std::swap(entries_[largest], entries_[index]);
+    index = largest;
+  }
+}
+
+}  // namespace UT
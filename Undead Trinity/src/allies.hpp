@@ -0,0 +1,59 @@
+#pragma once
+#include <triage.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace UT {
+
+// Bounded priority queue of nearby allies that need healing.
+//
+// Allies are updated one at a time as they are sampled and only the ones with the highest score
+// are kept, so the cost of an update does not depend on the number of allies around the player.
+// The score adds the health deficit below the ally threshold and the damage predicted over the
+// lookahead, minus a penalty that grows with the distance to the warlock.
+class Allies {
+public:
+  static constexpr std::size_t Capacity = 8;
+
+  // Score penalty at the maximum heal range.
+  static constexpr float Distance = 0.1f;
+
+  struct Entry {
+    std::uint32_t id{ 0 };
+    float score{ 0.0f };
+    bool sampled{ false };  // updated since the last call to Prune
+    Triage::Member member;
+  };
+
+  // Inserts, moves or removes the ally depending on its score.
+  void Update(std::uint32_t id, const Triage::Member& member, const Triage::Thresholds& thresholds = {}) noexcept;
+
+  // Removes the ally from the queue.
+  void Remove(std::uint32_t id) noexcept;
+
+  // Removes allies that were not updated since the last call.
+  void Prune() noexcept;
+
+  void Clear() noexcept;
+
+  // Returns the ally that needs healing the most or nullptr.
+  const Entry* Top() const noexcept;
+
+  std::size_t GetSize() const noexcept;
+
+  // Returns the score of an ally or a negative infinity when it does not need healing or can not be healed.
+  static float GetScore(const Triage::Member& member, const Triage::Thresholds& thresholds = {}) noexcept;
+
+private:
+  std::size_t Find(std::uint32_t id) const noexcept;
+  void Erase(std::size_t index) noexcept;
+  void SiftUp(std::size_t index) noexcept;
+  void SiftDown(std::size_t index) noexcept;
+
+  std::array<Entry, Capacity> entries_{};
+  std::size_t size_{ 0 };
+};
+
+}  // namespace UT
@@ -0,0 +1,32 @@
+#include "conditions.hpp"
+
+#include <algorithm>
+
+namespace UT {
+
+void Conditions::Sync(std::span<const float> skills)
+{
+  if (std::ranges::equal(skills, skills_)) {
+    return;
+  }
+  outcomes_.clear();
+  skills_.assign(skills.begin(), skills.end());
+}
+
+Conditions::Stats Conditions::GetStats() const noexcept
+{
+  auto stats = stats_;
+  if (stats.misses) {
+    stats.saved = stats.evaluated / static_cast<double>(stats.misses) * static_cast<double>(stats.hits);
+  }
+  return stats;
+}
+
+void Conditions::Clear() noexcept
+{
+  outcomes_.clear();
+  skills_.clear();
+  stats_ = {};
+}
+
+}  // namespace UT
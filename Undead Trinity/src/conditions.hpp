@@ -0,0 +1,70 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace UT {
+
+// Cache of perk condition outcomes.
+//
+// Outcomes are keyed by the perk form id and dropped when any synced skill value changes.
+// Only conditions that read nothing but the synced skill values can be cached.
+class Conditions {
+public:
+  struct Stats {
+    std::uint64_t hits{ 0 };
+    std::uint64_t misses{ 0 };
+    double evaluated{ 0.0 };  // seconds spent evaluating conditions
+    double saved{ 0.0 };      // estimated seconds saved by hits
+
+    Stats& operator+=(const Stats& other) noexcept
+    {
+      hits += other.hits;
+      misses += other.misses;
+      evaluated += other.evaluated;
+      saved += other.saved;
+      return *this;
+    }
+  };
+
+  // Drops all outcomes when the skill values differ from the previous call.
+  void Sync(std::span<const float> skills);
+
+  // Returns the cached outcome or evaluates the condition and caches its outcome.
+  template <class Condition>
+  bool Evaluate(std::uint32_t id, Condition&& condition)
+  {
+    if (const auto it = outcomes_.find(id); it != outcomes_.end()) {
+      stats_.hits++;
+      return it->second;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool outcome = condition();
+    stats_.evaluated += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats_.misses++;
+    outcomes_.emplace(id, outcome);
+    return outcome;
+  }
+
+  // Returns the statistics since the last call to Clear. Saved time is estimated with the
+  // average time of an evaluation.
+  Stats GetStats() const noexcept;
+
+  std::size_t GetSize() const noexcept
+  {
+    return outcomes_.size();
+  }
+
+  // Drops all outcomes, skill values and statistics.
+  void Clear() noexcept;
+
+private:
+  std::unordered_map<std::uint32_t, bool> outcomes_;
+  std::vector<float> skills_;
+  Stats stats_;
+};
+
+}  // namespace UT
@@ -0,0 +1,118 @@
+#pragma once
+#include <equip.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <variant>
+
+namespace UT::Engine {
+
+// Form types that are checked while forms are loaded or passed to script functions.
+enum class FormType : std::uint8_t {
+  Other,
+  NPC,
+  Perk,
+  Spell,
+  Package,
+};
+
+struct Form {
+  std::uint32_t id{ 0 };  // load order form id
+  FormType type{ FormType::Other };
+  bool named{ false };
+};
+
+struct Position {
+  float x{ 0.0f };
+  float y{ 0.0f };
+  float z{ 0.0f };
+};
+
+// Item that an actor can equip. Spell tomes are represented by the spell they teach.
+struct Item {
+  Form form;
+  Equip::Category category{ Equip::Category::None };
+};
+
+// Load order and form lookups of the data handler.
+//
+// The plugin forwards to TESDataHandler. Tools use an in-memory implementation, so that the form
+// tables can be built and measured without the game.
+class Data {
+public:
+  virtual ~Data() = default;
+
+  // Returns the form with the file local id.
+  virtual std::optional<Form> LookupForm(std::uint32_t id, std::string_view file) const = 0;
+
+  // Returns true if the file is part of the load order.
+  virtual bool IsLoaded(std::string_view file) const = 0;
+};
+
+// Actor reference. The plugin wraps RE::Actor, tools use an in-memory implementation.
+class Actor {
+public:
+  virtual ~Actor() = default;
+
+  virtual std::uint32_t GetFormID() const = 0;
+
+  // Returns the form id of the actor base or zero.
+  virtual std::uint32_t GetBaseID() const = 0;
+
+  virtual bool IsDead() const = 0;
+
+  // Returns the health ratio.
+  virtual float GetHealth() const = 0;
+
+  virtual Position GetPosition() const = 0;
+
+  // Returns the weapon or spell in the left or right hand.
+  virtual std::optional<Item> GetEquipped(bool left) const = 0;
+
+  // Adds the spell unless the actor knows it already. Returns false if it could not be added.
+  virtual bool AddSpell(const Form& spell) = 0;
+
+  // Unequips worn armor that shares a slot with the armor.
+  virtual void UnequipConflicts(const Form& armor) = 0;
+
+  // Evaluates the package stack after package overrides changed.
+  virtual void EvaluatePackage() = 0;
+};
+
+// Value passed to a script function. Forms are passed as the script type of their form type.
+using Argument = std::variant<bool, std::int32_t, float, Form, Actor*>;
+
+// Called on a script thread when a dispatched function returned.
+using Callback = std::function<void()>;
+
+// Function calls on the Papyrus VM.
+//
+// Calls are queued and return immediately. Callbacks of calls that were dispatched before a
+// game was loaded are dropped, so that they never touch actors of the unloaded game.
+class VM {
+public:
+  virtual ~VM() = default;
+
+  // Returns the generation of the running game. It changes every time a game is loaded.
+  virtual std::uint32_t GetGeneration() const = 0;
+
+  // Calls a global function. Returns false if the call could not be dispatched.
+  virtual bool DispatchStaticCall(
+    std::string_view script,
+    std::string_view function,
+    std::span<const Argument> arguments,
+    Callback callback = {}) = 0;
+
+  // Calls a function of the script that is bound to the actor. The actor is only used during the call.
+  virtual bool DispatchMethodCall(
+    Actor& actor,
+    std::string_view script,
+    std::string_view function,
+    std::span<const Argument> arguments,
+    Callback callback = {}) = 0;
+};
+
+}  // namespace UT::Engine
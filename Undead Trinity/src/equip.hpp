@@ -0,0 +1,82 @@
+#pragma once
+#include <policy.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace UT::Equip {
+
+// Item categories that trinity members can equip.
+enum class Category : std::uint8_t {
+  None,
+  Clothing,
+  LightArmor,
+  HeavyArmor,
+  Shield,
+  OneHanded,
+  Dagger,
+  TwoHanded,
+  Bow,
+  Staff,
+  Spell,
+};
+
+constexpr std::size_t Categories = 11;
+
+// Equip permissions indexed by class and category.
+constexpr auto Matrix = []() {
+  std::array<std::array<bool, Categories>, Policy::Classes> matrix{};
+  const auto allow = [&](Policy::Class member, std::initializer_list<Category> categories) {
+    for (const auto category : categories) {
+      matrix[static_cast<std::size_t>(member)][static_cast<std::size_t>(category)] = true;
+    }
+  };
+  using enum Category;
+  allow(Policy::Class::Guard, { Clothing, HeavyArmor, Shield, OneHanded, Dagger });
+  allow(Policy::Class::Knight, { Clothing, LightArmor, HeavyArmor, OneHanded, Dagger, TwoHanded });
+  allow(Policy::Class::Warlock, { Clothing, Dagger, Staff, Spell });
+  return matrix;
+}();
+
+constexpr bool CanEquip(Policy::Class member, Category category) noexcept
+{
+  return Matrix[static_cast<std::size_t>(member)][static_cast<std::size_t>(category)];
+}
+
+static_assert(CanEquip(Policy::Class::Guard, Category::Shield));
+static_assert(!CanEquip(Policy::Class::Knight, Category::Shield));
+static_assert(!CanEquip(Policy::Class::Warlock, Category::TwoHanded));
+static_assert(!CanEquip(Policy::Class::Knight, Category::None));
+
+constexpr const char* GetName(Category category) noexcept
+{
+  switch (category) {
+  case Category::None:
+    return "none";
+  case Category::Clothing:
+    return "clothing";
+  case Category::LightArmor:
+    return "light armor";
+  case Category::HeavyArmor:
+    return "heavy armor";
+  case Category::Shield:
+    return "shield";
+  case Category::OneHanded:
+    return "one-handed";
+  case Category::Dagger:
+    return "dagger";
+  case Category::TwoHanded:
+    return "two-handed";
+  case Category::Bow:
+    return "bow";
+  case Category::Staff:
+    return "staff";
+  case Category::Spell:
+    return "spell";
+  }
+  return "unknown";
+}
+
+}  // namespace UT::Equip
@@ -0,0 +1,457 @@
+#include "forms.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace UT::Forms {
+namespace {
+
+std::string Describe(const char* error, std::uint32_t id, std::string_view file)
+{
+  char buffer[16];
+  std::snprintf(buffer, sizeof(buffer), "0x%06X", id);
+  return std::string{ error } + ": " + buffer + " from " + std::string{ file };
+}
+
+// Loads the tables of one mod into a new object. Looks the forms up in the data handler, or only
+// records the requests when there is no data handler.
+class Loader {
+public:
+  Loader(const Engine::Data* data, std::vector<Request>* requests) noexcept : data_(data), requests_(requests) {}
+
+  Tables Load(Mods mod);
+
+private:
+  Engine::Form LF(std::uint32_t id, std::string_view file, Engine::FormType type = Engine::FormType::Other);
+  void LP(std::uint32_t id, std::string_view file, Skill skill, std::vector<std::uint32_t> forms);
+  Spell GS(std::uint32_t id, std::string_view file, Skill skill, float min, float max);
+  void LS(std::uint32_t id, std::string_view file, Skill skill, float min, float max);
+
+  template <Mods Mod>
+  void LoadSkills();
+
+  template <Mods Mod>
+  void LoadPerks();
+
+  template <Mods Mod>
+  void LoadSpells();
+
+  const Engine::Data* data_{ nullptr };
+  std::vector<Request>* requests_{ nullptr };
+  Tables tables_;
+};
+
+Engine::Form Loader::LF(std::uint32_t id, std::string_view file, Engine::FormType type)
+{
+  if (requests_) {
+    requests_->push_back({ id, file, type });
+    return { 0, type, true };
+  }
+  const auto form = data_->LookupForm(id, file);
+  if (!form) {
+    throw std::runtime_error(Describe("Could not load form", id, file));
+  }
+  return *form;
+}
+
+void Loader::LP(std::uint32_t id, std::string_view file, Skill skill, std::vector<std::uint32_t> forms)
+{
+  const auto perk = LF(id, file, Engine::FormType::Perk);
+  if (perk.type != Engine::FormType::Perk) {
+    throw std::runtime_error(Describe("Form is not a perk", id, file));
+  }
+  if (!perk.named) {
+    throw std::runtime_error(Describe("Perk has no name", id, file));
+  }
+  for (const auto form : forms) {
+    tables_.perks[form][skill].emplace_back(perk.id);
+  }
+}
+
+Spell Loader::GS(std::uint32_t id, std::string_view file, Skill skill, float min, float max)
+{
+  const auto spell = LF(id, file, Engine::FormType::Spell);
+  if (spell.type != Engine::FormType::Spell) {
+    throw std::runtime_error(Describe("Form is not a spell", id, file));
+  }
+  if (!spell.named) {
+    throw std::runtime_error(Describe("Spell has no name", id, file));
+  }
+  return { spell.id, skill, min, max };
+}
+
+void Loader::LS(std::uint32_t id, std::string_view file, Skill skill, float min, float max)
+{
+  tables_.spells.emplace_back(GS(id, file, skill, min, max));
+}
+
+template <>
+void Loader::LoadSkills<Mods::Skyrim>()
+{
+  const auto Guard = tables_.guard;
+  const auto Knight = tables_.knight;
+
+  tables_.skills[Guard].emplace_back(Skill::Block);
+  tables_.skills[Guard].emplace_back(Skill::OneHanded);
+  tables_.skills[Guard].emplace_back(Skill::HeavyArmor);
+  tables_.skills[Guard].emplace_back(Skill::Alteration);
+
+  tables_.skills[Knight].emplace_back(Skill::OneHanded);
+  tables_.skills[Knight].emplace_back(Skill::TwoHanded);
+  tables_.skills[Knight].emplace_back(Skill::HeavyArmor);
+  tables_.skills[Knight].emplace_back(Skill::LightArmor);
+  tables_.skills[Knight].emplace_back(Skill::Alteration);
+}
+
+template <>
+void Loader::LoadSkills<Mods::Requiem>()
+{
+  const auto Warlock = tables_.warlock;
+
+  LoadSkills<Mods::Skyrim>();
+
+  tables_.skills[Warlock].emplace_back(Skill::OneHanded);
+  tables_.skills[Warlock].emplace_back(Skill::LightArmor);
+  tables_.skills[Warlock].emplace_back(Skill::Alteration);
+  tables_.skills[Warlock].emplace_back(Skill::Conjuration);
+  tables_.skills[Warlock].emplace_back(Skill::Destruction);
+  tables_.skills[Warlock].emplace_back(Skill::Restoration);
+  tables_.skills[Warlock].emplace_back(Skill::Enchanting);
+}
+
+template <>
+void Loader::LoadPerks<Mods::Skyrim>()
+{
+  const auto Guard = tables_.guard;
+  const auto Knight = tables_.knight;
+
+  // clang-format off
+
+  // Block
+  constexpr auto Block = Skill::Block;
+
+  LP(0x0BCCAE, Skyrim, Block, { Guard });  // ShieldWall00            |   0
+  LP(0x079355, Skyrim, Block, { Guard });  // ShieldWall20            |  20
+  LP(0x0D8C33, Skyrim, Block, { Guard });  // QuickReflexes           |  30
+  LP(0x058F68, Skyrim, Block, { Guard });  // DeflectArrows           |  30
+  LP(0x058F67, Skyrim, Block, { Guard });  // PowerBashPerk           |  30
+  LP(0x079356, Skyrim, Block, { Guard });  // ShieldWall40            |  40
+  LP(0x058F69, Skyrim, Block, { Guard });  // ElementalProtection     |  50
+  LP(0x05F594, Skyrim, Block, { Guard });  // DeadlyBash              |  50
+  LP(0x079357, Skyrim, Block, { Guard });  // ShieldWall60            |  60
+  LP(0x106253, Skyrim, Block, { Guard });  // BlockRunner             |  70
+  LP(0x058F66, Skyrim, Block, { Guard });  // DisarmingBash           |  70
+  LP(0x079358, Skyrim, Block, { Guard });  // ShieldWall80            |  80
+  LP(0x058F6A, Skyrim, Block, { Guard });  // ShieldCharge            | 100
+
+  // One-Handed
+  constexpr auto OneHanded = Skill::OneHanded;
+
+  LP(0x0BABE4, Skyrim, OneHanded, { Guard, Knight });  // Armsman00               |   0
+  LP(0x079343, Skyrim, OneHanded, { Guard, Knight });  // Armsman20               |  20
+  LP(0x052D50, Skyrim, OneHanded, { Guard, Knight });  // FightingStance          |  20
+  LP(0x106256, Skyrim, OneHanded, {        Knight });  // DualFlurry30            |  30
+  LP(0x05F56F, Skyrim, OneHanded, { Guard, Knight });  // Bladesman30             |  30
+  LP(0x05F592, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker30           |  30
+  LP(0x03FFFA, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash30          |  30
+  LP(0x079342, Skyrim, OneHanded, { Guard, Knight });  // Armsman40               |  40
+  LP(0x106257, Skyrim, OneHanded, {        Knight });  // DualFlurry50            |  50
+  LP(0x0CB406, Skyrim, OneHanded, { Guard, Knight });  // CriticalCharge          |  50
+  LP(0x03AF81, Skyrim, OneHanded, { Guard, Knight });  // SavageStrike            |  50
+  LP(0x079344, Skyrim, OneHanded, { Guard, Knight });  // Armsman60               |  60
+  LP(0x0C1E90, Skyrim, OneHanded, { Guard, Knight });  // Bladesman60             |  60
+  LP(0x0C1E92, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker60           |  60
+  LP(0x0C3678, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash60          |  60
+  LP(0x106258, Skyrim, OneHanded, {        Knight });  // DualSavagery            |  70
+  LP(0x079345, Skyrim, OneHanded, { Guard, Knight });  // Armsman80               |  80
+  LP(0x0C1E91, Skyrim, OneHanded, { Guard, Knight });  // Bladesman90             |  90
+  LP(0x0C1E93, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker90           |  90
+  LP(0x0C3679, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash90          |  90
+  LP(0x03AFA6, Skyrim, OneHanded, { Guard, Knight });  // ParalyzingStrike        | 100
+
+  // Two-Handed
+  constexpr auto TwoHanded = Skill::TwoHanded;
+
+  LP(0x0BABE8, Skyrim, TwoHanded, { Knight });  // Barbarian00             |   0
+  LP(0x079346, Skyrim, TwoHanded, { Knight });  // Barbarian20             |  20
+  LP(0x052D51, Skyrim, TwoHanded, { Knight });  // ChampionsStance         |  20
+  LP(0x03AF83, Skyrim, TwoHanded, { Knight });  // DeepWounds30            |  30
+  LP(0x0C5C05, Skyrim, TwoHanded, { Knight });  // Limbsplitter30          |  30
+  LP(0x03AF84, Skyrim, TwoHanded, { Knight });  // Skullcrusher30          |  30
+  LP(0x079347, Skyrim, TwoHanded, { Knight });  // Barbarian40             |  40
+  LP(0x052D52, Skyrim, TwoHanded, { Knight });  // DevastatingBlow         |  50
+  LP(0x0CB407, Skyrim, TwoHanded, { Knight });  // GreatCriticalCharge     |  50
+  LP(0x079348, Skyrim, TwoHanded, { Knight });  // Barbarian60             |  60
+  LP(0x0C1E94, Skyrim, TwoHanded, { Knight });  // DeepWounds60            |  60
+  LP(0x0C5C06, Skyrim, TwoHanded, { Knight });  // Limbsplitter60          |  60
+  LP(0x0C1E96, Skyrim, TwoHanded, { Knight });  // Skullcrusher60          |  60
+  LP(0x03AF9E, Skyrim, TwoHanded, { Knight });  // Sweep                   |  70
+  LP(0x079349, Skyrim, TwoHanded, { Knight });  // Barbarian80             |  80
+  LP(0x0C1E95, Skyrim, TwoHanded, { Knight });  // DeepWounds90            |  90
+  LP(0x0C5C07, Skyrim, TwoHanded, { Knight });  // Limbsplitter90          |  90
+  LP(0x0C1E97, Skyrim, TwoHanded, { Knight });  // Skullcrusher90          |  90
+  LP(0x03AFA7, Skyrim, TwoHanded, { Knight });  // Warmaster               | 100
+
+  // Heavy Armor
+  constexpr auto HeavyArmor = Skill::HeavyArmor;
+
+  LP(0x0BCD2A, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut00            |   0
+  LP(0x07935E, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut20            |  20
+  LP(0x058F6E, Skyrim, HeavyArmor, { Guard, Knight });  // FistsOfSteel            |  30
+  LP(0x058F6F, Skyrim, HeavyArmor, { Guard, Knight });  // WellFitted              |  30
+  LP(0x079361, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut40            |  40
+  LP(0x0BCD2B, Skyrim, HeavyArmor, { Guard, Knight });  // Cushioned               |  50
+  LP(0x058F6C, Skyrim, HeavyArmor, { Guard, Knight });  // TowerOfStrength         |  50
+  LP(0x079362, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut60            |  60
+  LP(0x058F6D, Skyrim, HeavyArmor, { Guard, Knight });  // Conditioning            |  70
+  LP(0x107832, Skyrim, HeavyArmor, { Guard, Knight });  // MatchingSetHeavy        |  70
+  LP(0x079374, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut80            |  80
+  LP(0x105F33, Skyrim, HeavyArmor, { Guard, Knight });  // ReflectBlows            | 100
+
+  // Light Armor
+  constexpr auto LightArmor = Skill::LightArmor;
+
+  LP(0x0BE123, Skyrim, LightArmor, { Knight });  // AgileDefender00         |   0
+  LP(0x079376, Skyrim, LightArmor, { Knight });  // AgileDefender20         |  20
+  LP(0x051B1B, Skyrim, LightArmor, { Knight });  // CustomFit               |  30
+  LP(0x079389, Skyrim, LightArmor, { Knight });  // AgileDefender40         |  40
+  LP(0x051B1C, Skyrim, LightArmor, { Knight });  // Unhindered              |  50
+  LP(0x079391, Skyrim, LightArmor, { Knight });  // AgileDefender60         |  60
+  LP(0x105F22, Skyrim, LightArmor, { Knight });  // WindWalker              |  60
+  LP(0x051B17, Skyrim, LightArmor, { Knight });  // MatchingSet             |  70
+  LP(0x079392, Skyrim, LightArmor, { Knight });  // AgileDefender80         |  80
+  LP(0x107831, Skyrim, LightArmor, { Knight });  // DeftMovement            | 100
+
+  // Alteration
+  constexpr auto Alteration = Skill::Alteration;
+
+  LP(0x053128, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance30       |  30
+  LP(0x053129, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance50       |  50
+  LP(0x05312A, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance70       |  70
+  LP(0x0581F7, Skyrim, Alteration, { Guard, Knight });  //  atronach                | 100
+
+  // clang-format on
+}
+
+template <>
+void Loader::LoadPerks<Mods::Requiem>()
+{
+  const auto Guard = tables_.guard;
+  const auto Knight = tables_.knight;
+  const auto Warlock = tables_.warlock;
+
+  // clang-format off
+
+  // Block
+  constexpr auto Block = Skill::Block;
+
+  LP(0x0BCCAE, Skyrim, Block, { Guard });  // REQ_Block_ImprovedBlocking             |   0
+  LP(0x058F68, Skyrim, Block, { Guard });  // REQ_Block_StrongGrip                   |  15
+  LP(0x079355, Skyrim, Block, { Guard });  // REQ_Block_ExperiencedBlocking          |  20
+  LP(0x058F67, Skyrim, Block, { Guard });  // REQ_Block_PowerfulBashes               |  25
+  LP(0x058F69, Skyrim, Block, { Guard });  // REQ_Block_ElementalProtection          |  50
+  LP(0x05F594, Skyrim, Block, { Guard });  // REQ_Block_OverpoweringBashes           |  50
+  LP(0x106253, Skyrim, Block, { Guard });  // REQ_Block_DefensiveStance              |  75
+  LP(0x058F66, Skyrim, Block, { Guard });  // REQ_Block_DisarmingBash                |  75
+  LP(0x058F6A, Skyrim, Block, { Guard });  // REQ_Block_UnstoppableCharge            | 100
+
+  // One-Handed
+  constexpr auto OneHanded = Skill::OneHanded;
+
+  LP(0x0BABE4, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_WeaponMastery1           |   0
+  LP(0x079343, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_WeaponMastery2           |   0
+  LP(0x052D50, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_PenetratingStrikes       |  20
+  LP(0xAD399A, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus1             |  25
+  LP(0x03FFFA, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus1             |  25
+  LP(0x05F592, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus1               |  25
+  LP(0x05F56F, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus1              |  25
+  LP(0x106256, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_Flurry1                  |  25
+  LP(0xAD3999, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus2             |  50
+  LP(0x0C3678, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus2             |  50
+  LP(0x0C1E92, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus2               |  50
+  LP(0x0C1E90, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus2              |  50
+  LP(0x03AF81, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_PowerfulStrike           |  50
+  LP(0x0CB406, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_PowerfulCharge           |  50
+  LP(0x106257, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_Flurry2                  |  50
+  LP(0xAD3998, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus3             |  75
+  LP(0x0C3679, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus3             |  75
+  LP(0x0C1E93, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus3               |  75
+  LP(0x0C1E91, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus3              |  75
+  LP(0x106258, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_StormOfSteel             |  75
+  LP(0x03AFA6, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_StunningCharge           | 100
+
+  // Two-Handed
+  constexpr auto TwoHanded = Skill::TwoHanded;
+
+  LP(0x0BABE8, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatWeaponMastery1      |   0
+  LP(0x079346, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatWeaponMastery2      |   0
+  LP(0x052D51, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BarbaricMight            |  20
+  LP(0xADDFB0, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus1       |  25
+  LP(0x0C5C05, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus1          |  25
+  LP(0x03AF83, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus1         |  25
+  LP(0x03AF84, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus1          |  25
+  LP(0xADDFB1, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus2       |  50
+  LP(0x0C5C06, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus2          |  50
+  LP(0x0C1E94, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus2         |  50
+  LP(0x0C1E96, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus2          |  50
+  LP(0x0CB407, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingCharge        |  50
+  LP(0x052D52, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingStrike        |  50
+  LP(0xADDFB2, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus3       |  75
+  LP(0x0C5C07, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus3          |  75
+  LP(0x0C1E95, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus3         |  75
+  LP(0x0C1E97, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus3          |  75
+  LP(0x03AF9E, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_Cleave                   |  75
+  LP(0x03AFA7, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingCleave        | 100
+  LP(0x182F9B, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_MightyStrike             | 100
+
+  // Heavy Armor
+  constexpr auto HeavyArmor = Skill::HeavyArmor;
+
+  LP(0x0BCD2A, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Conditioning            |   0
+  LP(0x07935E, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_RelentlessOnslaught     |  20
+  LP(0x058F6F, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_CombatTraining          |  25
+  LP(0x058F6C, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Fortitude               |  50
+  LP(0x107832, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_PowerOfTheCombatant     |  75
+  LP(0x105F33, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Juggernaut              | 100
+
+  // Evasion
+  constexpr auto Evasion = Skill::LightArmor;
+
+  LP(0x0BE123, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Agility                    |   0
+  LP(0x079376, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Dodge                      |  20
+  LP(0x051B1B, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Finesse                    |  25
+  LP(0x18A66F, Requiem, Evasion, {         Warlock });  // REQ_Evasion_AgileSpellcasting          |  30
+  LP(0x051B1C, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Dexterity                  |  50
+  LP(0x18F5A8, Requiem, Evasion, { Knight, Warlock });  // REQ_Evasion_VexingFlanker              |  50
+  LP(0x105F22, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_WindWalker                 |  75
+  LP(0x051B17, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_CombatReflexes             |  75
+  LP(0x107831, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_MeteoricReflexes           | 100
+
+  // Alteration
+  constexpr auto Alteration = Skill::Alteration;
+
+  LP(0x0D7999, Skyrim,  Alteration, {                Warlock });  // REQ_Alteration_ImprovedMageArmor       |  25
+  LP(0x053128, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance1        |  25
+  LP(0x0581FC, Skyrim,  Alteration, {                Warlock });  // REQ_Alteration_Stability               |  50
+  LP(0x053129, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance2        |  50
+  LP(0x21792B, Requiem, Alteration, {                Warlock });  // REQ_Alteration_MetamagicalThesis       |  75
+  LP(0x21792A, Requiem, Alteration, {                Warlock });  // REQ_Alteration_SpellArmor              |  75
+  LP(0x05312A, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance3        |  75
+  LP(0x21792C, Requiem, Alteration, {                Warlock });  // REQ_Alteration_MetamagicalEmpowerment  | 100
+  LP(0x0581F7, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicalAbsorption       | 100
+
+  // Conjuration
+  constexpr auto Conjuration = Skill::Conjuration;
+
+  LP(0x105F30, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_StabilizedBinding      |  25
+  LP(0xAD385A, Requiem, Conjuration, { Warlock });  // REQ_Conjuration_SpiritualBinding       |  35
+  LP(0x0CB419, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_ExtendedBinding        |  50
+  LP(0x0CB41A, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_ElementalBinding       |  75
+
+  // Destruction
+  constexpr auto Destruction = Skill::Destruction;
+
+  LP(0x0581E7, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Pyromancy1             |  25
+  LP(0x0581EA, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cyromancy1             |  25
+  LP(0x058200, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Electromancy1          |  25
+  LP(0x10FCF8, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Pyromancy2             |  50
+  LP(0x10FCF9, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cyromancy2             |  50
+  LP(0x10FCFA, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Electromancy2          |  50
+  LP(0x0153D2, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Impact                 |  50
+  LP(0x0F392E, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cremation              |  75
+  LP(0x0F3933, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_DeepFreeze             |  75
+  LP(0x0F3F0E, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_ElectrostaticDischarge |  75
+  LP(0x179121, Requiem, Destruction, { Warlock });  // REQ_Destruction_FireMastery            | 100
+  LP(0x179123, Requiem, Destruction, { Warlock });  // REQ_Destruction_FrostMastery           | 100
+  LP(0x179124, Requiem, Destruction, { Warlock });  // REQ_Destruction_LightningMastery       | 100
+
+  // Restoration
+  constexpr auto Restoration = Skill::Restoration;
+
+  LP(0x0581F4, Skyrim, Restoration, { Warlock });  // REQ_Restoration_FocusedMind            |  25
+  LP(0x068BCC, Skyrim, Restoration, { Warlock });  // REQ_Restoration_ImprovedWards          |  75
+
+  // Enchanting
+  constexpr auto Enchanting = Skill::Enchanting;
+
+  LP(0x0BEE97, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantersInsight1      |   0
+  LP(0x0C367C, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantersInsight2      |  20
+  LP(0x058F80, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ElementalLore           |  25
+  LP(0x058F7C, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_SoulGemMastery          |  25
+  LP(0x058F81, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_CorpusLore              |  50
+  LP(0x058F7E, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ArcaneExperimentation   |  50
+  LP(0x058F82, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_SkillLore               |  75
+  LP(0x058F7D, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ArtificersInsight       |  75
+  LP(0x058F7F, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantmentMastery      | 100
+
+  // clang-format on
+}
+
+template <>
+void Loader::LoadSpells<Mods::Requiem>()
+{
+  // clang-format off
+  constexpr auto Conjuration = Skill::Conjuration;
+  constexpr auto Destruction = Skill::Destruction;
+  constexpr auto Restoration = Skill::Restoration;
+
+  // Conjuration
+  LS(0x0204C5, Skyrim, Conjuration,  75.0f, 100.0f);  // Summon Storm Atronach
+
+  // Destruction
+  LS(0x012FCD, Skyrim, Destruction,   0.0f,  74.0f);  // Flames
+  LS(0x02B96B, Skyrim, Destruction,   0.0f,  74.0f);  // Frostbite
+  LS(0x02DD2A, Skyrim, Destruction,   0.0f,  74.0f);  // Sparks
+  LS(0x012FD0, Skyrim, Destruction,  25.0f,  74.0f);  // Firebolt
+  LS(0x02B96C, Skyrim, Destruction,  25.0f,  74.0f);  // Ice Spike
+  LS(0x02DD29, Skyrim, Destruction,  25.0f,  74.0f);  // Lightning Bolt
+  LS(0x01C789, Skyrim, Destruction,  50.0f, 100.0f);  // Fireball
+  LS(0x045F9C, Skyrim, Destruction,  50.0f, 100.0f);  // Ice Storm
+  LS(0x045F9D, Skyrim, Destruction,  50.0f, 100.0f);  // Chain Lightning
+  LS(0x10F7ED, Skyrim, Destruction,  75.0f, 100.0f);  // Incinerate
+  LS(0x10F7EC, Skyrim, Destruction,  75.0f, 100.0f);  // Icy Spear
+  LS(0x10F7EE, Skyrim, Destruction,  75.0f, 100.0f);  // Thunderbolt
+
+  // Restoration
+  LS(0x225F3B, Requiem, Restoration,   0.0f,  24.0f);  // Arcane Ward (Rank I)
+  LS(0x013018, Skyrim,  Restoration,  25.0f,  49.0f);  // Arcane Ward (Rank II)
+  LS(0x0211F1, Skyrim,  Restoration,  50.0f, 100.0f);  // Arcane Ward (Rank III)
+  LS(0x0211F0, Skyrim,  Restoration,  75.0f, 100.0f);  // Arcane Ward (Rank IV)
+
+  // clang-format on
+}
+
+Tables Loader::Load(Mods mod)
+{
+  tables_.mod = mod;
+  tables_.guard = LF(0x000031, Trinity, Engine::FormType::NPC).id;
+  tables_.knight = LF(0x000032, Trinity, Engine::FormType::NPC).id;
+  tables_.warlock = LF(0x000033, Trinity, Engine::FormType::NPC).id;
+  if (mod == Mods::Requiem) {
+    LoadSkills<Mods::Requiem>();
+    LoadPerks<Mods::Requiem>();
+    LoadSpells<Mods::Requiem>();
+  } else {
+    LoadSkills<Mods::Skyrim>();
+    LoadPerks<Mods::Skyrim>();
+  }
+  return std::move(tables_);
+}
+
+}  // namespace
+
+Tables Load(const Engine::Data& data)
+{
+  return Loader{ &data, nullptr }.Load(data.IsLoaded(Requiem) ? Mods::Requiem : Mods::Skyrim);
+}
+
+std::vector<Request> GetRequests(Mods mod)
+{
+  std::vector<Request> requests;
+  Loader{ nullptr, &requests }.Load(mod);
+  return requests;
+}
+
+}  // namespace UT::Forms
@@ -0,0 +1,68 @@
+#pragma once
+#include <engine.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+namespace UT::Forms {
+
+enum class Mods {
+  Skyrim,
+  Requiem,
+};
+
+constexpr std::string_view Skyrim{ "Skyrim.esm" };
+constexpr std::string_view Dawnguard{ "Dawnguard.esm" };
+constexpr std::string_view Requiem{ "Requiem.esp" };
+constexpr std::string_view Trinity{ "Undead Trinity.esp" };
+
+// Skills use the actor value numbers of the game.
+enum class Skill : std::uint32_t {
+  OneHanded = 6,
+  TwoHanded = 7,
+  Block = 9,
+  HeavyArmor = 11,
+  LightArmor = 12,
+  Alteration = 18,
+  Conjuration = 19,
+  Destruction = 20,
+  Restoration = 22,
+  Enchanting = 23,
+};
+
+struct Spell {
+  std::uint32_t id{ 0 };
+  Skill skill{ Skill::OneHanded };
+  float min{ 0.0f };
+  float max{ 0.0f };
+};
+
+// Skills, perks and spells that trinity members get from the player.
+// All maps are keyed by the form id of the trinity member actor base.
+struct Tables {
+  Mods mod{ Mods::Skyrim };
+  std::uint32_t guard{ 0 };
+  std::uint32_t knight{ 0 };
+  std::uint32_t warlock{ 0 };
+  std::map<std::uint32_t, std::vector<Skill>> skills;
+  std::map<std::uint32_t, std::map<Skill, std::vector<std::uint32_t>>> perks;
+  std::vector<Spell> spells;
+};
+
+// Form looked up by Load.
+struct Request {
+  std::uint32_t id{ 0 };  // file local form id
+  std::string_view file;
+  Engine::FormType type{ Engine::FormType::Other };
+};
+
+// Loads the tables for the load order. Throws std::runtime_error if a form is missing or has
+// the wrong type.
+Tables Load(const Engine::Data& data);
+
+// Returns the forms that Load looks up for the mod, so that stand-in data handlers can provide them.
+std::vector<Request> GetRequests(Mods mod);
+
+}  // namespace UT::Forms
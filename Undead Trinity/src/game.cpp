@@ -14,6 +14,21 @@ std::vector<Spell> Spells;
 std::map<RE::FormID, std::vector<RE::ActorValue>> Skills;
 std::map<RE::FormID, std::map<RE::ActorValue, std::vector<RE::BGSPerk*>>> Perks;
 
+std::array<Policy::Table, Policy::Classes> Policies;
+std::array<std::vector<RE::TESPackage*>, Policy::Classes> PolicyPackages;
+std::vector<RE::TESPackage*> RulePackages;
+
+RE::BGSKeyword* WeapTypeStaff{ nullptr };
+RE::BGSKeyword* VendorItemSpellTome{ nullptr };
+std::unordered_map<RE::FormID, Equip::Category> Categories;
+std::atomic<std::uint32_t> Generation{ 0 };
+std::vector<std::pair<RE::BGSPerk*, int>> Counts;
+std::array<RE::TESRace*, 4> Races{};
+std::map<RE::FormID, Conditions> PerkConditions;
+std::map<RE::FormID, std::set<RE::FormID>> CachedPerks;
+std::array<RE::TESObjectREFR*, 3> Armors{};
+std::array<RE::TESObjectREFR*, 3> Inventories{};
+
 RE::TESForm* LF(RE::FormID id, std::string_view file)
 {
   const auto form = Data->LookupForm(id, file);
@@ -34,44 +49,15 @@ void LF(RE::FormID id, std::string_view file, T*& object)
   object = form->As<T>();
 }
 
-void LP(RE::FormID id, std::string_view file, RE::ActorValue skill, std::vector<RE::FormID> forms)
-{
-  const auto perk = LF(id, file);
-  if (perk->GetFormType() != RE::FormType::Perk) {
-    throw std::runtime_error(std::format("Form is not a perk: 0x{:06X} from {}", id, file));
-  }
-  if (const auto name = perk->GetName(); !name || std::string_view{ name }.empty()) {
-    throw std::runtime_error(std::format("Perk has no name: 0x{:06X} from {}", id, file));
-  }
-  for (const auto form : forms) {
-    Perks[form][skill].emplace_back(perk->As<RE::BGSPerk>());
-  }
-}
-
-Spell GS(RE::FormID id, std::string_view file, RE::ActorValue skill, float min, float max)
-{
-  auto spell = LF(id, file);
-  if (spell->GetFormType() != RE::FormType::Spell) {
-    throw std::runtime_error(std::format("Form is not a spell: 0x{:06X} from {}", id, file));
-  }
-  if (const auto name = spell->GetName(); !name || std::string_view{ name }.empty()) {
-    throw std::runtime_error(std::format("Spell has no name: 0x{:06X} from {}", id, file));
-  }
-  return { spell->As<RE::SpellItem>(), skill, min, max };
-}
-
-void LS(RE::FormID id, std::string_view file, RE::ActorValue skill, float min, float max)
-{
-  Spells.emplace_back(GS(id, file, skill, min, max));
-}
-
 class ResultCallback : public RE::BSScript::IStackCallbackFunctor {
 public:
   ResultCallback() = default;
 
-  ResultCallback(std::string function, std::function<void(RE::BSScript::Variable)> callback) :
+  ResultCallback(std::string function, Engine::Callback callback) :
     function_(function),
-    callback_(std::move(callback))
+    callback_(std::move(callback)),
+    flow_(Trace::FlowBegin(function_)),
+    generation_(GetGeneration())
   {}
 
   ResultCallback(ResultCallback&& other) = default;
@@ -81,9 +67,15 @@ public:
 
   void operator()(RE::BSScript::Variable result) override
   {
+    const Trace::Scope trace{ function_ };
+    Trace::FlowEnd(function_, flow_);
+    if (generation_ != GetGeneration()) {
+      UT_TRACE("UT: %s callback dropped after load.", function_.data());
+      return;
+    }
     if (callback_) {
       try {
-        callback_(std::move(result));
+        callback_();
       }
       catch (const std::exception& e) {
         UT_PRINT("UT: %s callback exception: %s", function_.data(), e.what());
@@ -98,11 +90,17 @@ public:
 
 private:
   std::string function_;
-  std::function<void(RE::BSScript::Variable)> callback_;
+  Engine::Callback callback_;
+  std::uint64_t flow_{ 0 };
+  std::uint32_t generation_{ 0 };
 };
 
-void UpdateContainerMenu(RE::BSScript::Variable result = {}) noexcept
+std::atomic_bool ContainerMenuPending{ false };
+
+void RefreshContainerMenu() noexcept
 {
+  const Trace::Scope trace{ "RefreshContainerMenu" };
+  ContainerMenuPending.store(false, std::memory_order_release);
   if (const auto ui = RE::UI::GetSingleton(); ui && ui->IsMenuOpen(RE::ContainerMenu::MENU_NAME)) {
     if (const auto menu = ui->GetMenu<RE::ContainerMenu>(); menu) {
       if (const auto& data = menu->GetRuntimeData(); data.itemList) {
@@ -112,434 +110,544 @@ void UpdateContainerMenu(RE::BSScript::Variable result = {}) noexcept
   }
 }
 
-template <Mods Mod>
-void LoadSkills();
-
-template <>
-void LoadSkills<Mods::Skyrim>()
-{
-  Skills[Guard].emplace_back(RE::ActorValue::kBlock);
-  Skills[Guard].emplace_back(RE::ActorValue::kOneHanded);
-  Skills[Guard].emplace_back(RE::ActorValue::kHeavyArmor);
-  Skills[Guard].emplace_back(RE::ActorValue::kAlteration);
-
-  Skills[Knight].emplace_back(RE::ActorValue::kOneHanded);
-  Skills[Knight].emplace_back(RE::ActorValue::kTwoHanded);
-  Skills[Knight].emplace_back(RE::ActorValue::kHeavyArmor);
-  Skills[Knight].emplace_back(RE::ActorValue::kLightArmor);
-  Skills[Knight].emplace_back(RE::ActorValue::kAlteration);
-}
-
-template <>
-void LoadSkills<Mods::Requiem>()
-{
-  LoadSkills<Mods::Skyrim>();
-
-  Skills[Warlock].emplace_back(RE::ActorValue::kOneHanded);
-  Skills[Warlock].emplace_back(RE::ActorValue::kLightArmor);
-  Skills[Warlock].emplace_back(RE::ActorValue::kAlteration);
-  Skills[Warlock].emplace_back(RE::ActorValue::kConjuration);
-  Skills[Warlock].emplace_back(RE::ActorValue::kDestruction);
-  Skills[Warlock].emplace_back(RE::ActorValue::kRestoration);
-  Skills[Warlock].emplace_back(RE::ActorValue::kEnchanting);
-}
-
-template <Mods Mod>
-void LoadPerks();
-
-template <>
-void LoadPerks<Mods::Skyrim>()
-{
-  // clang-format off
-
-  // Block
-  constexpr auto Block = RE::ActorValue::kBlock;
-
-  LP(0x0BCCAE, Skyrim, Block, { Guard });  // ShieldWall00            |   0
-  LP(0x079355, Skyrim, Block, { Guard });  // ShieldWall20            |  20
-  LP(0x0D8C33, Skyrim, Block, { Guard });  // QuickReflexes           |  30
-  LP(0x058F68, Skyrim, Block, { Guard });  // DeflectArrows           |  30
-  LP(0x058F67, Skyrim, Block, { Guard });  // PowerBashPerk           |  30
-  LP(0x079356, Skyrim, Block, { Guard });  // ShieldWall40            |  40
-  LP(0x058F69, Skyrim, Block, { Guard });  // ElementalProtection     |  50
-  LP(0x05F594, Skyrim, Block, { Guard });  // DeadlyBash              |  50
-  LP(0x079357, Skyrim, Block, { Guard });  // ShieldWall60            |  60
-  LP(0x106253, Skyrim, Block, { Guard });  // BlockRunner             |  70
-  LP(0x058F66, Skyrim, Block, { Guard });  // DisarmingBash           |  70
-  LP(0x079358, Skyrim, Block, { Guard });  // ShieldWall80            |  80
-  LP(0x058F6A, Skyrim, Block, { Guard });  // ShieldCharge            | 100
-
-  // One-Handed
-  constexpr auto OneHanded = RE::ActorValue::kOneHanded;
-
-  LP(0x0BABE4, Skyrim, OneHanded, { Guard, Knight });  // Armsman00               |   0
-  LP(0x079343, Skyrim, OneHanded, { Guard, Knight });  // Armsman20               |  20
-  LP(0x052D50, Skyrim, OneHanded, { Guard, Knight });  // FightingStance          |  20
-  LP(0x106256, Skyrim, OneHanded, {        Knight });  // DualFlurry30            |  30
-  LP(0x05F56F, Skyrim, OneHanded, { Guard, Knight });  // Bladesman30             |  30
-  LP(0x05F592, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker30           |  30
-  LP(0x03FFFA, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash30          |  30
-  LP(0x079342, Skyrim, OneHanded, { Guard, Knight });  // Armsman40               |  40
-  LP(0x106257, Skyrim, OneHanded, {        Knight });  // DualFlurry50            |  50
-  LP(0x0CB406, Skyrim, OneHanded, { Guard, Knight });  // CriticalCharge          |  50
-  LP(0x03AF81, Skyrim, OneHanded, { Guard, Knight });  // SavageStrike            |  50
-  LP(0x079344, Skyrim, OneHanded, { Guard, Knight });  // Armsman60               |  60
-  LP(0x0C1E90, Skyrim, OneHanded, { Guard, Knight });  // Bladesman60             |  60
-  LP(0x0C1E92, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker60           |  60
-  LP(0x0C3678, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash60          |  60
-  LP(0x106258, Skyrim, OneHanded, {        Knight });  // DualSavagery            |  70
-  LP(0x079345, Skyrim, OneHanded, { Guard, Knight });  // Armsman80               |  80
-  LP(0x0C1E91, Skyrim, OneHanded, { Guard, Knight });  // Bladesman90             |  90
-  LP(0x0C1E93, Skyrim, OneHanded, { Guard, Knight });  // BoneBreaker90           |  90
-  LP(0x0C3679, Skyrim, OneHanded, { Guard, Knight });  // HackAndSlash90          |  90
-  LP(0x03AFA6, Skyrim, OneHanded, { Guard, Knight });  // ParalyzingStrike        | 100
-
-  // Two-Handed
-  constexpr auto TwoHanded = RE::ActorValue::kTwoHanded;
-
-  LP(0x0BABE8, Skyrim, TwoHanded, { Knight });  // Barbarian00             |   0
-  LP(0x079346, Skyrim, TwoHanded, { Knight });  // Barbarian20             |  20
-  LP(0x052D51, Skyrim, TwoHanded, { Knight });  // ChampionsStance         |  20
-  LP(0x03AF83, Skyrim, TwoHanded, { Knight });  // DeepWounds30            |  30
-  LP(0x0C5C05, Skyrim, TwoHanded, { Knight });  // Limbsplitter30          |  30
-  LP(0x03AF84, Skyrim, TwoHanded, { Knight });  // Skullcrusher30          |  30
-  LP(0x079347, Skyrim, TwoHanded, { Knight });  // Barbarian40             |  40
-  LP(0x052D52, Skyrim, TwoHanded, { Knight });  // DevastatingBlow         |  50
-  LP(0x0CB407, Skyrim, TwoHanded, { Knight });  // GreatCriticalCharge     |  50
-  LP(0x079348, Skyrim, TwoHanded, { Knight });  // Barbarian60             |  60
-  LP(0x0C1E94, Skyrim, TwoHanded, { Knight });  // DeepWounds60            |  60
-  LP(0x0C5C06, Skyrim, TwoHanded, { Knight });  // Limbsplitter60          |  60
-  LP(0x0C1E96, Skyrim, TwoHanded, { Knight });  // Skullcrusher60          |  60
-  LP(0x03AF9E, Skyrim, TwoHanded, { Knight });  // Sweep                   |  70
-  LP(0x079349, Skyrim, TwoHanded, { Knight });  // Barbarian80             |  80
-  LP(0x0C1E95, Skyrim, TwoHanded, { Knight });  // DeepWounds90            |  90
-  LP(0x0C5C07, Skyrim, TwoHanded, { Knight });  // Limbsplitter90          |  90
-  LP(0x0C1E97, Skyrim, TwoHanded, { Knight });  // Skullcrusher90          |  90
-  LP(0x03AFA7, Skyrim, TwoHanded, { Knight });  // Warmaster               | 100
-
-  // Heavy Armor
-  constexpr auto HeavyArmor = RE::ActorValue::kHeavyArmor;
-
-  LP(0x0BCD2A, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut00            |   0
-  LP(0x07935E, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut20            |  20
-  LP(0x058F6E, Skyrim, HeavyArmor, { Guard, Knight });  // FistsOfSteel            |  30
-  LP(0x058F6F, Skyrim, HeavyArmor, { Guard, Knight });  // WellFitted              |  30
-  LP(0x079361, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut40            |  40
-  LP(0x0BCD2B, Skyrim, HeavyArmor, { Guard, Knight });  // Cushioned               |  50
-  LP(0x058F6C, Skyrim, HeavyArmor, { Guard, Knight });  // TowerOfStrength         |  50
-  LP(0x079362, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut60            |  60
-  LP(0x058F6D, Skyrim, HeavyArmor, { Guard, Knight });  // Conditioning            |  70
-  LP(0x107832, Skyrim, HeavyArmor, { Guard, Knight });  // MatchingSetHeavy        |  70
-  LP(0x079374, Skyrim, HeavyArmor, { Guard, Knight });  // Juggernaut80            |  80
-  LP(0x105F33, Skyrim, HeavyArmor, { Guard, Knight });  // ReflectBlows            | 100
-
-  // Light Armor
-  constexpr auto LightArmor = RE::ActorValue::kLightArmor;
-
-  LP(0x0BE123, Skyrim, LightArmor, { Knight });  // AgileDefender00         |   0
-  LP(0x079376, Skyrim, LightArmor, { Knight });  // AgileDefender20         |  20
-  LP(0x051B1B, Skyrim, LightArmor, { Knight });  // CustomFit               |  30
-  LP(0x079389, Skyrim, LightArmor, { Knight });  // AgileDefender40         |  40
-  LP(0x051B1C, Skyrim, LightArmor, { Knight });  // Unhindered              |  50
-  LP(0x079391, Skyrim, LightArmor, { Knight });  // AgileDefender60         |  60
-  LP(0x105F22, Skyrim, LightArmor, { Knight });  // WindWalker              |  60
-  LP(0x051B17, Skyrim, LightArmor, { Knight });  // MatchingSet             |  70
-  LP(0x079392, Skyrim, LightArmor, { Knight });  // AgileDefender80         |  80
-  LP(0x107831, Skyrim, LightArmor, { Knight });  // DeftMovement            | 100
-
-  // Alteration
-  constexpr auto Alteration = RE::ActorValue::kAlteration;
-
-  LP(0x053128, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance30       |  30
-  LP(0x053129, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance50       |  50
-  LP(0x05312A, Skyrim, Alteration, { Guard, Knight });  //  MagicResistance70       |  70
-  LP(0x0581F7, Skyrim, Alteration, { Guard, Knight });  //  atronach                | 100
-
-  // clang-format on
-}
-
-template <>
-void LoadPerks<Mods::Requiem>()
-{
-  // clang-format off
-
-  // Block
-  constexpr auto Block = RE::ActorValue::kBlock;
-
-  LP(0x0BCCAE, Skyrim, Block, { Guard });  // REQ_Block_ImprovedBlocking             |   0
-  LP(0x058F68, Skyrim, Block, { Guard });  // REQ_Block_StrongGrip                   |  15
-  LP(0x079355, Skyrim, Block, { Guard });  // REQ_Block_ExperiencedBlocking          |  20
-  LP(0x058F67, Skyrim, Block, { Guard });  // REQ_Block_PowerfulBashes               |  25
-  LP(0x058F69, Skyrim, Block, { Guard });  // REQ_Block_ElementalProtection          |  50
-  LP(0x05F594, Skyrim, Block, { Guard });  // REQ_Block_OverpoweringBashes           |  50
-  LP(0x106253, Skyrim, Block, { Guard });  // REQ_Block_DefensiveStance              |  75
-  LP(0x058F66, Skyrim, Block, { Guard });  // REQ_Block_DisarmingBash                |  75
-  LP(0x058F6A, Skyrim, Block, { Guard });  // REQ_Block_UnstoppableCharge            | 100
-
-  // One-Handed
-  constexpr auto OneHanded = RE::ActorValue::kOneHanded;
-
-  LP(0x0BABE4, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_WeaponMastery1           |   0
-  LP(0x079343, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_WeaponMastery2           |   0
-  LP(0x052D50, Skyrim,  OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_PenetratingStrikes       |  20
-  LP(0xAD399A, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus1             |  25
-  LP(0x03FFFA, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus1             |  25
-  LP(0x05F592, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus1               |  25
-  LP(0x05F56F, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus1              |  25
-  LP(0x106256, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_Flurry1                  |  25
-  LP(0xAD3999, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus2             |  50
-  LP(0x0C3678, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus2             |  50
-  LP(0x0C1E92, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus2               |  50
-  LP(0x0C1E90, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus2              |  50
-  LP(0x03AF81, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_PowerfulStrike           |  50
-  LP(0x0CB406, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_PowerfulCharge           |  50
-  LP(0x106257, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_Flurry2                  |  50
-  LP(0xAD3998, Requiem, OneHanded, { Guard, Knight, Warlock });  // REQ_OneHanded_DaggerFocus3             |  75
-  LP(0x0C3679, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_WarAxeFocus3             |  75
-  LP(0x0C1E93, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_MaceFocus3               |  75
-  LP(0x0C1E91, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_SwordFocus3              |  75
-  LP(0x106258, Skyrim,  OneHanded, {        Knight          });  // REQ_OneHanded_StormOfSteel             |  75
-  LP(0x03AFA6, Skyrim,  OneHanded, { Guard, Knight          });  // REQ_OneHanded_StunningCharge           | 100
-
-  // Two-Handed
-  constexpr auto TwoHanded = RE::ActorValue::kTwoHanded;
-
-  LP(0x0BABE8, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatWeaponMastery1      |   0
-  LP(0x079346, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatWeaponMastery2      |   0
-  LP(0x052D51, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BarbaricMight            |  20
-  LP(0xADDFB0, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus1       |  25
-  LP(0x0C5C05, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus1          |  25
-  LP(0x03AF83, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus1         |  25
-  LP(0x03AF84, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus1          |  25
-  LP(0xADDFB1, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus2       |  50
-  LP(0x0C5C06, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus2          |  50
-  LP(0x0C1E94, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus2         |  50
-  LP(0x0C1E96, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus2          |  50
-  LP(0x0CB407, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingCharge        |  50
-  LP(0x052D52, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingStrike        |  50
-  LP(0xADDFB2, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_QuarterstaffFocus3       |  75
-  LP(0x0C5C07, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_BattleAxeFocus3          |  75
-  LP(0x0C1E95, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_GreatswordFocus3         |  75
-  LP(0x0C1E97, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_WarhammerFocus3          |  75
-  LP(0x03AF9E, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_Cleave                   |  75
-  LP(0x03AFA7, Skyrim,  TwoHanded, { Knight });  // REQ_TwoHanded_DevastatingCleave        | 100
-  LP(0x182F9B, Requiem, TwoHanded, { Knight });  // REQ_TwoHanded_MightyStrike             | 100
-
-  // Heavy Armor
-  constexpr auto HeavyArmor = RE::ActorValue::kHeavyArmor;
-
-  LP(0x0BCD2A, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Conditioning            |   0
-  LP(0x07935E, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_RelentlessOnslaught     |  20
-  LP(0x058F6F, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_CombatTraining          |  25
-  LP(0x058F6C, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Fortitude               |  50
-  LP(0x107832, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_PowerOfTheCombatant     |  75
-  LP(0x105F33, Skyrim, HeavyArmor, { Guard, Knight });  // REQ_HeavyArmor_Juggernaut              | 100
-
-  // Evasion
-  constexpr auto Evasion = RE::ActorValue::kLightArmor;
-
-  LP(0x0BE123, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Agility                    |   0
-  LP(0x079376, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Dodge                      |  20
-  LP(0x051B1B, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Finesse                    |  25
-  LP(0x18A66F, Requiem, Evasion, {         Warlock });  // REQ_Evasion_AgileSpellcasting          |  30
-  LP(0x051B1C, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_Dexterity                  |  50
-  LP(0x18F5A8, Requiem, Evasion, { Knight, Warlock });  // REQ_Evasion_VexingFlanker              |  50
-  LP(0x105F22, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_WindWalker                 |  75
-  LP(0x051B17, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_CombatReflexes             |  75
-  LP(0x107831, Skyrim,  Evasion, { Knight, Warlock });  // REQ_Evasion_MeteoricReflexes           | 100
-
-  // Alteration
-  constexpr auto Alteration = RE::ActorValue::kAlteration;
-
-  LP(0x0D7999, Skyrim,  Alteration, {                Warlock });  // REQ_Alteration_ImprovedMageArmor       |  25
-  LP(0x053128, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance1        |  25
-  LP(0x0581FC, Skyrim,  Alteration, {                Warlock });  // REQ_Alteration_Stability               |  50
-  LP(0x053129, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance2        |  50
-  LP(0x21792B, Requiem, Alteration, {                Warlock });  // REQ_Alteration_MetamagicalThesis       |  75
-  LP(0x21792A, Requiem, Alteration, {                Warlock });  // REQ_Alteration_SpellArmor              |  75
-  LP(0x05312A, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicResistance3        |  75
-  LP(0x21792C, Requiem, Alteration, {                Warlock });  // REQ_Alteration_MetamagicalEmpowerment  | 100
-  LP(0x0581F7, Skyrim,  Alteration, { Guard, Knight, Warlock });  // REQ_Alteration_MagicalAbsorption       | 100
-
-  // Conjuration
-  constexpr auto Conjuration = RE::ActorValue::kConjuration;
-
-  LP(0x105F30, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_StabilizedBinding      |  25
-  LP(0xAD385A, Requiem, Conjuration, { Warlock });  // REQ_Conjuration_SpiritualBinding       |  35
-  LP(0x0CB419, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_ExtendedBinding        |  50
-  LP(0x0CB41A, Skyrim,  Conjuration, { Warlock });  // REQ_Conjuration_ElementalBinding       |  75
-
-  // Destruction
-  constexpr auto Destruction = RE::ActorValue::kDestruction;
-
-  LP(0x0581E7, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Pyromancy1             |  25
-  LP(0x0581EA, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cyromancy1             |  25
-  LP(0x058200, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Electromancy1          |  25
-  LP(0x10FCF8, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Pyromancy2             |  50
-  LP(0x10FCF9, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cyromancy2             |  50
-  LP(0x10FCFA, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Electromancy2          |  50
-  LP(0x0153D2, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Impact                 |  50
-  LP(0x0F392E, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_Cremation              |  75
-  LP(0x0F3933, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_DeepFreeze             |  75
-  LP(0x0F3F0E, Skyrim,  Destruction, { Warlock });  // REQ_Destruction_ElectrostaticDischarge |  75
-  LP(0x179121, Requiem, Destruction, { Warlock });  // REQ_Destruction_FireMastery            | 100
-  LP(0x179123, Requiem, Destruction, { Warlock });  // REQ_Destruction_FrostMastery           | 100
-  LP(0x179124, Requiem, Destruction, { Warlock });  // REQ_Destruction_LightningMastery       | 100
-
-  // Restoration
-  constexpr auto Restoration = RE::ActorValue::kRestoration;
-
-  LP(0x0581F4, Skyrim, Restoration, { Warlock });  // REQ_Restoration_FocusedMind            |  25
-  LP(0x068BCC, Skyrim, Restoration, { Warlock });  // REQ_Restoration_ImprovedWards          |  75
-
-  // Enchanting
-  constexpr auto Enchanting = RE::ActorValue::kEnchanting;
-
-  LP(0x0BEE97, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantersInsight1      |   0
-  LP(0x0C367C, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantersInsight2      |  20
-  LP(0x058F80, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ElementalLore           |  25
-  LP(0x058F7C, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_SoulGemMastery          |  25
-  LP(0x058F81, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_CorpusLore              |  50
-  LP(0x058F7E, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ArcaneExperimentation   |  50
-  LP(0x058F82, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_SkillLore               |  75
-  LP(0x058F7D, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_ArtificersInsight       |  75
-  LP(0x058F7F, Skyrim, Enchanting, { Warlock });  // REQ_Enchanting_EnchantmentMastery      | 100
-
-  // clang-format on
-}
-
-template <Mods Mod>
-void LoadSpells();
-
-template <>
-void LoadSpells<Mods::Requiem>()
-{
-  // clang-format off
-  constexpr auto Conjuration = RE::ActorValue::kConjuration;
-  constexpr auto Destruction = RE::ActorValue::kDestruction;
-  constexpr auto Restoration = RE::ActorValue::kRestoration;
-
-  // Conjuration
-  LS(0x0204C5, Skyrim, Conjuration,  75.0f, 100.0f);  // Summon Storm Atronach
-
-  // Destruction
-  LS(0x012FCD, Skyrim, Destruction,   0.0f,  74.0f);  // Flames
-  LS(0x02B96B, Skyrim, Destruction,   0.0f,  74.0f);  // Frostbite
-  LS(0x02DD2A, Skyrim, Destruction,   0.0f,  74.0f);  // Sparks
-  LS(0x012FD0, Skyrim, Destruction,  25.0f,  74.0f);  // Firebolt
-  LS(0x02B96C, Skyrim, Destruction,  25.0f,  74.0f);  // Ice Spike
-  LS(0x02DD29, Skyrim, Destruction,  25.0f,  74.0f);  // Lightning Bolt
-  LS(0x01C789, Skyrim, Destruction,  50.0f, 100.0f);  // Fireball
-  LS(0x045F9C, Skyrim, Destruction,  50.0f, 100.0f);  // Ice Storm
-  LS(0x045F9D, Skyrim, Destruction,  50.0f, 100.0f);  // Chain Lightning
-  LS(0x10F7ED, Skyrim, Destruction,  75.0f, 100.0f);  // Incinerate
-  LS(0x10F7EC, Skyrim, Destruction,  75.0f, 100.0f);  // Icy Spear
-  LS(0x10F7EE, Skyrim, Destruction,  75.0f, 100.0f);  // Thunderbolt
-
-  // Restoration
-  LS(0x225F3B, Requiem, Restoration,   0.0f,  24.0f);  // Arcane Ward (Rank I)
-  LS(0x013018, Skyrim,  Restoration,  25.0f,  49.0f);  // Arcane Ward (Rank II)
-  LS(0x0211F1, Skyrim,  Restoration,  50.0f, 100.0f);  // Arcane Ward (Rank III)
-  LS(0x0211F0, Skyrim,  Restoration,  75.0f, 100.0f);  // Arcane Ward (Rank IV)
-
-  // clang-format on
+// Returns the form for the engine layer.
+Engine::Form GetForm(const RE::TESForm* form) noexcept
+{
+  Engine::Form result{ form->GetFormID() };
+  switch (form->GetFormType()) {
+  case RE::FormType::NPC:
+    result.type = Engine::FormType::NPC;
+    break;
+  case RE::FormType::Perk:
+    result.type = Engine::FormType::Perk;
+    break;
+  case RE::FormType::Spell:
+    result.type = Engine::FormType::Spell;
+    break;
+  case RE::FormType::Package:
+    result.type = Engine::FormType::Package;
+    break;
+  default:
+    break;
+  }
+  const auto name = form->GetName();
+  result.named = name && *name;
+  return result;
 }
 
-}  // namespace
-
-void Load()
+// Returns the handle of the actor in the VM or zero.
+RE::VMHandle GetHandle(RE::Actor* actor) noexcept
 {
-  // Get singletons.
-  Papyrus = SKSE::GetPapyrusInterface();
-  if (!Papyrus) {
-    throw std::runtime_error("Could not get papyrus interface.");
+  const auto policy = VirtualMachine->GetObjectHandlePolicy();
+  if (!policy) {
+    UT_PRINT("UT: Could not get object handle policy.");
+    return 0;
   }
+  const auto handle = policy->GetHandleForObject(actor->GetFormType(), actor);
+  if (handle == policy->EmptyHandle()) {
+    UT_PRINT("UT: Could not get object handle: %08X", actor->GetFormID());
+    return 0;
+  }
+  return handle;
+}
 
-  VirtualMachine = RE::BSScript::Internal::VirtualMachine::GetSingleton();
-  if (!VirtualMachine) {
-    throw std::runtime_error("Could not get virtual machine.");
+// Packs the arguments of the engine layer like RE::MakeFunctionArguments.
+class Arguments final : public RE::BSScript::IFunctionArguments {
+public:
+  explicit Arguments(std::span<const Engine::Argument> arguments) :
+    arguments_(arguments.begin(), arguments.end())
+  {}
+
+  bool operator()(RE::BSScrapArray<RE::BSScript::Variable>& destination) const override
+  {
+    destination.resize(static_cast<std::uint32_t>(arguments_.size()));
+    for (std::size_t i = 0; i < arguments_.size(); i++) {
+      auto& variable = destination[static_cast<std::uint32_t>(i)];
+      std::visit([&](const auto& value) { Pack(variable, value); }, arguments_[i]);
+    }
+    return true;
   }
 
-  Player = RE::PlayerCharacter::GetSingleton();
-  if (!Player) {
-    throw std::runtime_error("Could not get player singleton.");
+private:
+  template <class T>
+  static void Pack(RE::BSScript::Variable& variable, T value) noexcept
+  {
+    variable.Pack(value);
   }
 
-  Data = RE::TESDataHandler::GetSingleton();
-  if (!Data) {
-    throw std::runtime_error("Could not get TES data handler.");
+  static void Pack(RE::BSScript::Variable& variable, Engine::Actor* actor) noexcept
+  {
+    variable.Pack(actor ? static_cast<Actor*>(actor)->Get() : nullptr);
   }
 
-  // Load actors.
-  Guard = LF(0x000031, Trinity)->GetFormID();
-  Knight = LF(0x000032, Trinity)->GetFormID();
-  Warlock = LF(0x000033, Trinity)->GetFormID();
+  // Forms are packed as the script type of their form type, so that functions with spell and
+  // package parameters accept them.
+  static void Pack(RE::BSScript::Variable& variable, const Engine::Form& form) noexcept
+  {
+    switch (form.type) {
+    case Engine::FormType::Spell:
+      variable.Pack(RE::TESForm::LookupByID<RE::SpellItem>(form.id));
+      break;
+    case Engine::FormType::Package:
+      variable.Pack(RE::TESForm::LookupByID<RE::TESPackage>(form.id));
+      break;
+    default:
+      variable.Pack(RE::TESForm::LookupByID(form.id));
+      break;
+    }
+  }
 
-  // Load packages.
-  LF(0xF00004, Trinity, Heal);
-  LF(0xF00005, Trinity, HealGuard);
-  LF(0xF00006, Trinity, HealKnight);
-  LF(0xF00007, Trinity, HealSelf);
+  std::vector<Engine::Argument> arguments_;
+};
 
-  // Load skills, perks and spells forms.
-  if (Data->GetModIndex(Requiem)) {
-    Mod = Mods::Requiem;
-    LoadSkills<Mods::Requiem>();
-    LoadPerks<Mods::Requiem>();
-    LoadSpells<Mods::Requiem>();
-  } else {
-    Mod = Mods::Skyrim;
-    LoadSkills<Mods::Skyrim>();
-    LoadPerks<Mods::Skyrim>();
+// Dispatches the script calls of the engine layer to the Papyrus VM.
+class Dispatcher final : public Engine::VM {
+public:
+  std::uint32_t GetGeneration() const override
+  {
+    return Game::GetGeneration();
+  }
+
+  bool DispatchStaticCall(
+    std::string_view script,
+    std::string_view function,
+    std::span<const Engine::Argument> arguments,
+    Engine::Callback callback) override
+  {
+    const auto name = std::format("{}.{}", script, function);
+    for (const auto& argument : arguments) {
+      if (const auto actor = std::get_if<Engine::Actor*>(&argument); actor && (!*actor || !GetHandle(Get(*actor)))) {
+        return false;
+      }
+    }
+    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result;
+    if (callback) {
+      result.reset(new ResultCallback(name, std::move(callback)));
+    }
+    const auto args = new Arguments{ arguments };
+    if (!VirtualMachine->DispatchStaticCall(RE::BSFixedString{ script }, RE::BSFixedString{ function }, args, result)) {
+      UT_PRINT("UT: Could not call script function: %s", name.data());
+      return false;
+    }
+    UT_TRACE("UT: %s", name.data());
+    return true;
+  }
+
+  bool DispatchMethodCall(
+    Engine::Actor& actor,
+    std::string_view script,
+    std::string_view function,
+    std::span<const Engine::Argument> arguments,
+    Engine::Callback callback) override
+  {
+    const auto name = std::format("{}.{}", script, function);
+    const auto target = Get(&actor);
+    const auto handle = GetHandle(target);
+    if (!handle) {
+      return false;
+    }
+    RE::BSTSmartPointer<RE::BSScript::Object> object;
+    if (!VirtualMachine->FindBoundObject(handle, std::string{ script }.data(), object)) {
+      UT_PRINT("UT: Could not find bound script object: %08X %s", target->GetFormID(), name.data());
+      return false;
+    }
+    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result;
+    if (callback) {
+      result.reset(new ResultCallback(name, std::move(callback)));
+    }
+    const auto args = new Arguments{ arguments };
+    if (!VirtualMachine->DispatchMethodCall1(object, RE::BSFixedString{ function }, args, result)) {
+      UT_PRINT("UT: Could not call script function: %08X %s", target->GetFormID(), name.data());
+      return false;
+    }
+    UT_TRACE("UT: %08X %s", target->GetFormID(), name.data());
+    return true;
+  }
+
+private:
+  static RE::Actor* Get(Engine::Actor* actor) noexcept
+  {
+    return static_cast<Actor*>(actor)->Get();
+  }
+};
+
+Dispatcher Scripts;
+
+std::size_t GetClass(RE::FormID id) noexcept
+{
+  if (id == Guard) {
+    return static_cast<std::size_t>(Policy::Class::Guard);
+  }
+  if (id == Knight) {
+    return static_cast<std::size_t>(Policy::Class::Knight);
   }
+  if (id == Warlock) {
+    return static_cast<std::size_t>(Policy::Class::Warlock);
+  }
+  return Policy::Classes;
 }
 
-void Initialize(RE::FormID id, RE::Actor* actor) noexcept
+Equip::Category Classify(RE::TESBoundObject* object) noexcept
 {
-  auto base = actor->GetActorBase();
-  if (!base) {
-    UT_PRINT("UT: [%s] Could not get actor base.", GetName(id));
-    return;
+  const auto id = object->GetFormID();
+  if (const auto it = Categories.find(id); it != Categories.end()) {
+    return it->second;
+  }
+
+  auto category = Equip::Category::None;
+  if (const auto armor = object->As<RE::TESObjectARMO>()) {
+    if (armor->IsShield()) {
+      category = Equip::Category::Shield;
+    } else {
+      switch (armor->GetArmorType()) {
+      case RE::BGSBipedObjectForm::ArmorType::kLightArmor:
+        category = Equip::Category::LightArmor;
+        break;
+      case RE::BGSBipedObjectForm::ArmorType::kHeavyArmor:
+        category = Equip::Category::HeavyArmor;
+        break;
+      case RE::BGSBipedObjectForm::ArmorType::kClothing:
+        category = Equip::Category::Clothing;
+        break;
+      }
+    }
+  } else if (const auto weapon = object->As<RE::TESObjectWEAP>()) {
+    if (weapon->HasKeyword(WeapTypeStaff)) {
+      category = Equip::Category::Staff;
+    } else {
+      switch (weapon->GetWeaponType()) {
+      case RE::WEAPON_TYPE::kOneHandSword:
+      case RE::WEAPON_TYPE::kOneHandAxe:
+      case RE::WEAPON_TYPE::kOneHandMace:
+        category = Equip::Category::OneHanded;
+        break;
+      case RE::WEAPON_TYPE::kOneHandDagger:
+        category = Equip::Category::Dagger;
+        break;
+      case RE::WEAPON_TYPE::kTwoHandSword:
+      case RE::WEAPON_TYPE::kTwoHandAxe:
+        category = Equip::Category::TwoHanded;
+        break;
+      case RE::WEAPON_TYPE::kBow:
+      case RE::WEAPON_TYPE::kCrossbow:
+        category = Equip::Category::Bow;
+        break;
+      default:
+        break;
+      }
+    }
+  } else if (const auto book = object->As<RE::TESObjectBOOK>()) {
+    if (book->TeachesSpell() && book->GetSpell() && book->HasKeyword(VendorItemSpellTome)) {
+      category = Equip::Category::Spell;
+    }
+  }
+
+  // Dynamic form ids are reused between saves.
+  if (!object->IsDynamicForm()) {
+    Categories.emplace(id, category);
   }
+  return category;
+}
 
-  auto pvo = Player->AsActorValueOwner();
-  if (!pvo) {
-    UT_PRINT("UT: [%s] Could not get player actor value owner.", GetName(id));
+void UnequipConflicts(RE::FormID id, RE::Actor* actor, RE::TESObjectARMO* armor) noexcept
+{
+  // Unequip armor with conflicting slot masks.
+  if (const auto mask = static_cast<unsigned>(armor->GetSlotMask())) {
+    if (const auto manager = RE::ActorEquipManager::GetSingleton()) {
+      for (const auto& e : actor->GetInventory()) {
+        if (const auto data = e.second.second.get(); data && data->IsWorn()) {
+          if (e.first && e.first->GetFormType() == RE::FormType::Armor) {
+            if (const auto equipped = e.first->As<RE::TESObjectARMO>()) {
+              if (mask & static_cast<unsigned>(equipped->GetSlotMask())) {
+                if (const auto extras = data->extraLists; extras && !extras->empty()) {
+                  UT_DEBUG("UT: [%s] R: %s", GetName(id), e.first->GetName());
+                  manager->UnequipObject(actor, e.first, extras->front(), 1, nullptr, false, false, false, true);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// The rules file is optional. Errors are reported and skip the rules they affect instead of failing the load.
+void LoadPolicies() noexcept
+{
+  std::ifstream file("Data/SKSE/Plugins/undead_trinity.rules", std::ios::binary);
+  if (!file) {
+    return;
+  }
+  std::vector<Policy::Rule> rules;
+  try {
+    const std::string text{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    rules = Policy::Parse(text);
+  }
+  catch (const std::exception& e) {
+    UT_PRINT("UT: Could not parse package rules: %s", e.what());
     return;
   }
 
-  auto avo = actor->AsActorValueOwner();
-  if (!avo) {
-    UT_PRINT("UT: [%s] Could not get %s actor value owner.", GetName(id), actor->GetName());
+  // Skip rules with packages that can not be loaded, so that rule indices match RulePackages.
+  std::vector<Policy::Rule> loaded;
+  for (auto& rule : rules) {
+    RE::TESPackage* package{ nullptr };
+    try {
+      LF(rule.form, rule.plugin, package);
+    }
+    catch (const std::exception& e) {
+      UT_PRINT("UT: Skipped package rule on line %zu: %s", rule.line, e.what());
+      continue;
+    }
+    RulePackages.push_back(package);
+    loaded.push_back(std::move(rule));
+  }
+
+  for (std::size_t i = 0; i < Policy::Classes; i++) {
+    const auto member = static_cast<Policy::Class>(i);
+    try {
+      Policies[i] = Policy::Table{ member, loaded };
+    }
+    catch (const std::exception& e) {
+      UT_PRINT("UT: Skipped package rules for %s: %s", Policy::GetName(member), e.what());
+      continue;
+    }
+    auto& packages = PolicyPackages[i];
+    for (const auto rule : Policies[i].GetRules()) {
+      if (std::find(packages.begin(), packages.end(), RulePackages[rule]) == packages.end()) {
+        packages.push_back(RulePackages[rule]);
+      }
+    }
+  }
+}
+
+// Forwards form lookups of the forms module to the data handler.
+class DataHandler final : public Engine::Data {
+public:
+  std::optional<Engine::Form> LookupForm(std::uint32_t id, std::string_view file) const override
+  {
+    const auto form = Game::Data->LookupForm(id, file);
+    if (!form) {
+      return std::nullopt;
+    }
+    return GetForm(form);
+  }
+
+  bool IsLoaded(std::string_view file) const override
+  {
+    return Game::Data->GetModIndex(file).has_value();
+  }
+};
+
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::OneHanded) == RE::ActorValue::kOneHanded);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::TwoHanded) == RE::ActorValue::kTwoHanded);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Block) == RE::ActorValue::kBlock);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::HeavyArmor) == RE::ActorValue::kHeavyArmor);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::LightArmor) == RE::ActorValue::kLightArmor);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Alteration) == RE::ActorValue::kAlteration);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Conjuration) == RE::ActorValue::kConjuration);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Destruction) == RE::ActorValue::kDestruction);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Restoration) == RE::ActorValue::kRestoration);
+static_assert(static_cast<RE::ActorValue>(Forms::Skill::Enchanting) == RE::ActorValue::kEnchanting);
+
+// Returns true if the perk conditions only compare base values of the synced skills of the actor they are
+// evaluated on. Other conditions can read state that changes without a skill change, like the actor level,
+// equipped items, active effects, perks or globals, and are evaluated every time.
+bool IsCacheable(const RE::BGSPerk* perk, const std::vector<RE::ActorValue>& skills) noexcept
+{
+  for (auto item = perk->perkConditions.head; item; item = item->next) {
+    const auto& data = item->data;
+    if (data.functionData.function.get() != RE::FUNCTION_DATA::FunctionID::kGetBaseActorValue || data.flags.global) {
+      return false;
+    }
+    const auto object = data.object.get();
+    if (object != RE::CONDITIONITEMOBJECT::kSelf && object != RE::CONDITIONITEMOBJECT::kTarget) {
+      return false;
+    }
+    const auto skill = static_cast<RE::ActorValue>(reinterpret_cast<std::uintptr_t>(data.functionData.params[0]));
+    if (std::ranges::find(skills, skill) == skills.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Resolves the form ids of the tables to game forms.
+void LoadTables(const Forms::Tables& tables)
+{
+  Mod = tables.mod;
+  Guard = tables.guard;
+  Knight = tables.knight;
+  Warlock = tables.warlock;
+  for (const auto& [id, skills] : tables.skills) {
+    for (const auto skill : skills) {
+      Skills[id].emplace_back(static_cast<RE::ActorValue>(skill));
+    }
+  }
+  for (const auto& [id, ladders] : tables.perks) {
+    for (const auto& [skill, perks] : ladders) {
+      auto& ladder = Perks[id][static_cast<RE::ActorValue>(skill)];
+      for (const auto perk : perks) {
+        ladder.emplace_back(RE::TESForm::LookupByID<RE::BGSPerk>(perk));
+      }
+    }
+  }
+  for (const auto& [id, ladders] : Perks) {
+    for (const auto& [skill, ladder] : ladders) {
+      for (const auto perk : ladder) {
+        if (perk && IsCacheable(perk, Skills[id])) {
+          CachedPerks[id].insert(perk->GetFormID());
+        }
+      }
+    }
+  }
+  for (const auto& spell : tables.spells) {
+    const auto form = RE::TESForm::LookupByID<RE::SpellItem>(spell.id);
+    Spells.push_back({ form, static_cast<RE::ActorValue>(spell.skill), spell.min, spell.max });
+  }
+}
+
+Scheduler Tasks;
+std::atomic_bool TasksPending{ false };
+
+void RunTasks() noexcept;
+
+void PumpTasks() noexcept
+{
+  if (TasksPending.exchange(true, std::memory_order_acq_rel)) {
     return;
   }
+  if (const auto tasks = SKSE::GetTaskInterface()) {
+    tasks->AddTask(RunTasks);
+  } else {
+    TasksPending.store(false, std::memory_order_release);
+    UT_PRINT("UT: Could not get task interface.");
+  }
+}
+
+void RunTasks() noexcept
+{
+  const Trace::Scope trace{ "RunTasks" };
+  TasksPending.store(false, std::memory_order_release);
+  if (Tasks.Run(ScheduleBudget)) {
+    PumpTasks();
+  }
+}
+
+// Synchronizes skills, perks and spells with the player. Every call runs one step and
+// perk ladders are granted one skill at a time, so that spawning several members at once
+// is spread over multiple frames.
+class Initializer {
+public:
+  Initializer(RE::FormID id, RE::Actor* actor) noexcept :
+    id_(id),
+    actor_(actor->GetHandle()),
+    perks_(Perks[id].cbegin()),
+    end_(Perks[id].cend())
+  {}
+
+  bool operator()() noexcept
+  {
+    const auto actor = actor_.get();
+    if (!actor || actor->IsDead()) {
+      return true;
+    }
+    switch (step_) {
+    case Step::Skills:
+      step_ = Step::Perks;
+      return !UpdateSkills(actor.get());
+    case Step::Perks:
+      if (perks_ != end_) {
+        UpdatePerks(actor.get(), *perks_++);
+        return false;
+      }
+#if !defined(NDEBUG) && UT_DEBUG_PERKS
+      UT_DEBUG("UT: [%s] PERK %d/%d (%d added)", GetName(id_), hasPerks_ + addPerks_, maxPerks_, addPerks_);
+#endif
+      step_ = Step::Spells;
+      return id_ != Warlock;
+    case Step::Spells:
+      UpdateSpells(actor.get());
+      return true;
+    }
+    return true;
+  }
+
+private:
+  enum class Step {
+    Skills,
+    Perks,
+    Spells,
+  };
+
+  using Ladder = std::map<RE::ActorValue, std::vector<RE::BGSPerk*>>::value_type;
 
-  const auto& skills = Skills[id];
-  boost::container::flat_map<RE::ActorValue, float> skillValues;
-  skillValues.reserve(skills.size());
+  bool UpdateSkills(RE::Actor* actor) noexcept
+  {
+    const Trace::Scope trace{ "Initialize Skills" };
+    auto pvo = Player->AsActorValueOwner();
+    if (!pvo) {
+      UT_PRINT("UT: [%s] Could not get player actor value owner.", GetName(id_));
+      return false;
+    }
+
+    auto avo = actor->AsActorValueOwner();
+    if (!avo) {
+      UT_PRINT("UT: [%s] Could not get %s actor value owner.", GetName(id_), actor->GetName());
+      return false;
+    }
+
+    const auto& skills = Skills[id_];
+    skillValues_.reserve(skills.size());
+
+    for (const auto skill : skills) {
+      const auto pv = std::min(pvo->GetBaseActorValue(skill), 100.0f);
+      const auto av = std::min(avo->GetBaseActorValue(skill), 100.0f);
+      if (pv > av + 0.5f) {
+        avo->SetBaseActorValue(skill, pv);
+        UT_TRACE("UT: [%s] SKIL %3.0f -> %3.0f %s", GetName(id_), av, pv, std::to_string(skill).data());
+      }
+      skillValues_[skill] = pv;
+    }
 
-  for (const auto skill : skills) {
-    const auto pv = std::min(pvo->GetBaseActorValue(skill), 100.0f);
-    const auto av = std::min(avo->GetBaseActorValue(skill), 100.0f);
-    if (pv > av + 0.5f) {
-      avo->SetBaseActorValue(skill, pv);
-      UT_TRACE("UT: [%s] SKIL %3.0f -> %3.0f %s", GetName(id), av, pv, std::to_string(skill).data());
+    // Reuse perk condition outcomes while the base skill values the cached conditions read do not change.
+    std::vector<float> values;
+    values.reserve(skills.size());
+    for (const auto skill : skills) {
+      values.push_back(avo->GetBaseActorValue(skill));
     }
-    skillValues[skill] = pv;
+    PerkConditions[id_].Sync(values);
+    return true;
   }
 
-  int hasPerks = 0;
-  int addPerks = 0;
-  for (const auto& perks : Perks[id]) {
+  void UpdatePerks(RE::Actor* actor, const Ladder& perks) noexcept
+  {
+    const Trace::Scope trace{ "Initialize Perks" };
+    auto base = actor->GetActorBase();
+    if (!base) {
+      UT_PRINT("UT: [%s] Could not get actor base.", GetName(id_));
+      return;
+    }
+#if !defined(NDEBUG) && UT_DEBUG_PERKS
+    maxPerks_ += static_cast<int>(perks.second.size());
+#endif
+    auto& conditions = PerkConditions[id_];
+    const auto& cached = CachedPerks[id_];
     for (const auto perk : perks.second) {
       if (actor->HasPerk(perk)) {
-        hasPerks++;
+        hasPerks_++;
         continue;
       }
-      if (!perk->perkConditions.IsTrue(actor, actor)) {
+      const auto condition = [&]() {
+        return perk->perkConditions.IsTrue(actor, actor);
+      };
+      const auto id = perk->GetFormID();
+      const auto met = cached.contains(id) ? conditions.Evaluate(id, condition) : condition();
+      if (!met) {
         UT_DEBUG(
           "UT: [%s] PERK %s: Conditions not met: %08X %s",
-          GetName(id),
+          GetName(id_),
           std::to_string(perks.first).data(),
           perk->GetFormID(),
           perk->GetName());
@@ -548,17 +656,17 @@ void Initialize(RE::FormID id, RE::Actor* actor) noexcept
       if (!base->AddPerk(perk, 1)) {
         UT_PRINT(
           "UT: [%s] PERK %s: Could not add: %08X %s",
-          GetName(id),
+          GetName(id_),
           std::to_string(perks.first).data(),
           perk->GetFormID(),
           perk->GetName());
         break;
       }
-      addPerks++;
+      addPerks_++;
 #if !defined(NDEBUG) && UT_DEBUG_PERKS
       UT_DEBUG(
         "UT: [%s] PERK %s: %08X %s",
-        GetName(id),
+        GetName(id_),
         std::to_string(perks.first).data(),
         perk->GetFormID(),
         perk->GetName());
@@ -566,21 +674,16 @@ void Initialize(RE::FormID id, RE::Actor* actor) noexcept
     }
   }
 
-#if !defined(NDEBUG) && UT_DEBUG_PERKS
-  const auto maxPerks = std::accumulate(Perks[id].begin(), Perks[id].end(), 0, [](int v, const auto& e) {
-    return v + static_cast<int>(e.second.size());
-  });
-  UT_DEBUG("UT: [%s] PERK %d/%d (%d added)", GetName(id), hasPerks + addPerks, maxPerks, addPerks);
-#endif
-
-  if (id == Warlock) {
+  void UpdateSpells(RE::Actor* actor) noexcept
+  {
+    const Trace::Scope trace{ "Initialize Spells" };
     UT_TRACE("UT: [W] Updating %u spells ...", static_cast<unsigned>(Spells.size()));
     for (const auto& spell : Spells) {
 #if !defined(NDEBUG) && UT_DEBUG_SPELL
       const auto form = spell.form->GetFormID();
       const auto name = spell.form->GetName();
       const auto info = std::to_string(spell.skill);
-      const auto skill = skillValues[spell.skill];
+      const auto skill = skillValues_[spell.skill];
       if (skill < spell.min) {
         UT_DEBUG("UT: [W] SPEL %.0f < %.0f %s: %08X %s", skill, spell.min, info.data(), form, name);
         continue;
@@ -602,96 +705,173 @@ void Initialize(RE::FormID id, RE::Actor* actor) noexcept
       }
       UT_DEBUG("UT: [W] SPEL %08X %s", form, name);
 #else
-      if (const auto skill = skillValues[spell.skill]; skill >= spell.min && skill <= spell.max) {
+      if (const auto skill = skillValues_[spell.skill]; skill >= spell.min && skill <= spell.max) {
         const auto form = spell.form;
         if (actor->HasSpell(form) || !Player->HasSpell(form)) {
           continue;
         }
         if (!actor->AddSpell(form)) {
-          UT_PRINT("UT: [%s] SPEL Could not add: %08X %s", GetName(id), form->GetFormID(), form->GetName());
+          UT_PRINT("UT: [%s] SPEL Could not add: %08X %s", GetName(id_), form->GetFormID(), form->GetName());
           break;
         }
-        UT_TRACE("UT: [%s] SPEL %08X %s", GetName(id), form->GetFormID(), form->GetName());
+        UT_TRACE("UT: [%s] SPEL %08X %s", GetName(id_), form->GetFormID(), form->GetName());
       }
 #endif
     }
   }
-}
 
-void Equip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object) noexcept
+  RE::FormID id_;
+  RE::ActorHandle actor_;
+  Step step_{ Step::Skills };
+  std::map<RE::ActorValue, std::vector<RE::BGSPerk*>>::const_iterator perks_;
+  std::map<RE::ActorValue, std::vector<RE::BGSPerk*>>::const_iterator end_;
+  boost::container::flat_map<RE::ActorValue, float> skillValues_;
+  int hasPerks_{ 0 };
+  int addPerks_{ 0 };
+#if !defined(NDEBUG) && UT_DEBUG_PERKS
+  int maxPerks_{ 0 };
+#endif
+};
+
+// Moves the items of the armor container to the actor and equips them, then moves the items of the
+// inventory container.
+void TakeItems(RE::Actor* actor, RE::TESObjectREFR* armor, RE::TESObjectREFR* inventory) noexcept
 {
-  // Only equip armor.
-  if (object->GetFormType() != RE::FormType::Armor) {
-    UT_TRACE("UT: [%s] Item is not armor.", GetName(id));
-    return;
-  }
-  const auto armor = object->As<RE::TESObjectARMO>();
-  if (!armor) {
-    UT_PRINT("UT: [%s] Could not get armor.", GetName(id));
-    return;
+  // Move all armor container items to inventory and equip them.
+  if (const auto manager = RE::ActorEquipManager::GetSingleton(); manager && armor) {
+    for (const auto& [object, data] : armor->GetInventory()) {
+      if (object && data.first > 0) {
+        armor->RemoveItem(object, 1, RE::ITEM_REMOVE_REASON::kStoreInContainer, nullptr, actor);
+        manager->EquipObject(actor, object, nullptr, 1, nullptr, false, true, false, true);
+      }
+    }
   }
 
-  // Unequip armor with conflicting slot masks.
-  if (const auto mask = static_cast<unsigned>(armor->GetSlotMask())) {
-    if (const auto manager = RE::ActorEquipManager::GetSingleton()) {
-      for (const auto& e : actor->GetInventory()) {
-        if (const auto data = e.second.second.get(); data && data->IsWorn()) {
-          if (e.first && e.first->GetFormType() == RE::FormType::Armor) {
-            if (const auto equipped = e.first->As<RE::TESObjectARMO>()) {
-              if (mask & static_cast<unsigned>(equipped->GetSlotMask())) {
-                if (const auto extras = data->extraLists; extras && !extras->empty()) {
-                  UT_DEBUG("UT: [%s] R: %s", GetName(id), e.first->GetName());
-                  manager->UnequipObject(actor, e.first, extras->front(), 1, nullptr, false, false, false, true);
-                }
-              }
-            }
-          }
-        }
+  // Move all inventory container items to inventory.
+  if (inventory) {
+    for (const auto& [object, data] : inventory->GetInventory()) {
+      if (object && data.first > 0) {
+        inventory->RemoveItem(object, data.first, RE::ITEM_REMOVE_REASON::kStoreInContainer, nullptr, actor);
       }
     }
   }
+}
 
-  // Equip armor.
-  const auto policy = VirtualMachine->GetObjectHandlePolicy();
-  if (!policy) {
-    UT_PRINT("UT: [%s] Could not get object handle policy.", GetName(id));
-    return;
+}  // namespace
+
+void Load()
+{
+  // Get singletons.
+  Papyrus = SKSE::GetPapyrusInterface();
+  if (!Papyrus) {
+    throw std::runtime_error("Could not get papyrus interface.");
   }
 
-  const auto handle = policy->GetHandleForObject(actor->GetFormType(), actor);
-  if (handle == policy->EmptyHandle()) {
-    UT_PRINT("UT: [%s] Could not get object handle: %08X UT_Actor", GetName(id), actor->GetFormID());
-    return;
+  VirtualMachine = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+  if (!VirtualMachine) {
+    throw std::runtime_error("Could not get virtual machine.");
   }
 
-  struct Script {
-    RE::BSFixedString name = "Actor";
-    RE::BSFixedString function = "EquipItemEx";
-    RE::BSTSmartPointer<RE::BSScript::Object> object;
-    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result{
-      new ResultCallback{ "Actor.EquipItemEx", UpdateContainerMenu }
-    };
-  } script;
+  Player = RE::PlayerCharacter::GetSingleton();
+  if (!Player) {
+    throw std::runtime_error("Could not get player singleton.");
+  }
 
-  if (!VirtualMachine->FindBoundObject(handle, script.name.c_str(), script.object)) {
-    UT_PRINT("UT: [%s] Could not find bound script object: %08X Actor", GetName(id), actor->GetFormID());
-    return;
+  Data = RE::TESDataHandler::GetSingleton();
+  if (!Data) {
+    throw std::runtime_error("Could not get TES data handler.");
   }
 
-  auto args = RE::MakeFunctionArguments(static_cast<RE::TESForm*>(object), 0, true, true);
-  if (!VirtualMachine->DispatchMethodCall1(script.object, script.function, args, script.result)) {
-    UT_PRINT("UT: [%s] Could not call script function: %08X Actor.EquipItemEx", GetName(id), actor->GetFormID());
-    return;
+  // Load actors and the skills, perks and spells they get from the player.
+  LoadTables(Forms::Load(DataHandler{}));
+
+  // Load packages.
+  LF(0xF00004, Trinity, Heal);
+  LF(0xF00005, Trinity, HealGuard);
+  LF(0xF00006, Trinity, HealKnight);
+  LF(0xF00007, Trinity, HealSelf);
+
+  // Load the spells that heal allies.
+  LF(0x000058, Trinity, HealAlly);
+  LF(0x000059, Trinity, HealUndead);
+
+  // Load skeleton races, armor and inventory containers.
+  LF(0x000010, Trinity, Races[0]);
+  LF(0x000011, Trinity, Races[1]);
+  LF(0x000012, Trinity, Races[2]);
+  LF(0x000013, Trinity, Races[3]);
+  LF(0x000F10, Trinity, Armors[0]);
+  LF(0x000F20, Trinity, Armors[1]);
+  LF(0x000F30, Trinity, Armors[2]);
+  LF(0x000F11, Trinity, Inventories[0]);
+  LF(0x000F21, Trinity, Inventories[1]);
+  LF(0x000F31, Trinity, Inventories[2]);
+
+  // Summon actors with the skeleton race instead of switching from the invisible race after the summon,
+  // so that their 3D is built once.
+  const std::array actors{ Guard, Knight, Warlock };
+  for (std::size_t i = 0; i < actors.size(); i++) {
+    if (const auto npc = RE::TESForm::LookupByID<RE::TESNPC>(actors[i])) {
+      npc->race = Races[i + 1];
+    }
+  }
+
+  // Load keywords.
+  LF(0x01E716, Skyrim, WeapTypeStaff);
+  LF(0x0937A5, Skyrim, VendorItemSpellTome);
+
+  // Load package rules.
+  LoadPolicies();
+
+  // Load perks that increase the number of summons.
+  if (Data->GetModIndex(Requiem)) {
+    Counts.emplace_back(nullptr, 3);
+    Counts.emplace_back(nullptr, 2);
+    LF(0x185737, Requiem, Counts[0].first);
+    LF(0x185736, Requiem, Counts[1].first);
   }
+  Counts.emplace_back(nullptr, 2);
+  LF(0x0D5F1C, Skyrim, Counts.back().first);
+}
+
+void Initialize(RE::FormID id, RE::Actor* actor) noexcept
+{
+  Schedule(Scheduler::Priority::Normal, Initializer{ id, actor });
+}
+
+std::uint32_t GetGeneration() noexcept
+{
+  return Generation.load(std::memory_order_acquire);
+}
+
+void Invalidate() noexcept
+{
+  Generation.fetch_add(1, std::memory_order_acq_rel);
+  Tasks.Clear();
 
-  UT_DEBUG("UT: [%s] E: %s", GetName(id), object->GetName());
+  // Perks of the actor bases depend on the loaded game.
+  PerkConditions.clear();
+}
+
+void Schedule(Scheduler::Priority priority, Scheduler::Job job) noexcept
+{
+  try {
+    Tasks.Post(priority, std::move(job));
+  }
+  catch (const std::exception& e) {
+    UT_PRINT("UT: Could not schedule task: %s", e.what());
+    return;
+  }
+  PumpTasks();
 }
 
 void Unequip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object, RE::ExtraDataList* extra) noexcept
 {
-  // Only unequip armor.
-  if (object->GetFormType() != RE::FormType::Armor) {
-    UT_TRACE("UT: [%s] Item is not armor.", GetName(id));
+  const Trace::Scope trace{ "Unequip" };
+
+  // Only unequip armor and weapons.
+  if (const auto category = Classify(object); category == Equip::Category::None || category == Equip::Category::Spell) {
+    UT_TRACE("UT: [%s] Item can not be unequipped.", GetName(id));
     return;
   }
 
@@ -702,7 +882,7 @@ void Unequip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object, RE::Ex
     return;
   }
 
-  // Unequip armor.
+  // Unequip item.
   UT_DEBUG("UT: [%s] U: %s", GetName(id), object->GetName());
   manager->UnequipObject(actor, object, extra);
 
@@ -710,131 +890,273 @@ void Unequip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object, RE::Ex
   UpdateContainerMenu();
 }
 
-bool CanEquip(RE::FormID id, RE::TESBoundObject* object) noexcept
+// Requests are collapsed into a single UI task, because equipping an item can unequip several
+// conflicting items and the item list has no way to update individual entries.
+void UpdateContainerMenu() noexcept
 {
-  if (object->GetFormType() == RE::FormType::Armor) {
-    if (const auto armor = object->As<RE::TESObjectARMO>()) {
-      if (armor->IsShield()) {
-        return id == Guard;
-      }
-      switch (armor->GetArmorType()) {
-      case RE::BGSBipedObjectForm::ArmorType::kLightArmor:
-        return id == Knight;
-      case RE::BGSBipedObjectForm::ArmorType::kHeavyArmor:
-        return id == Guard || id == Knight;
-      case RE::BGSBipedObjectForm::ArmorType::kClothing:
-        return true;
+  if (ContainerMenuPending.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  const Trace::Scope trace{ "UpdateContainerMenu" };
+  if (const auto tasks = SKSE::GetTaskInterface()) {
+    tasks->AddUITask(RefreshContainerMenu);
+  } else {
+    RefreshContainerMenu();
+  }
+}
+
+std::uint32_t Actor::GetFormID() const
+{
+  return actor_->GetFormID();
+}
+
+std::uint32_t Actor::GetBaseID() const
+{
+  const auto base = actor_->GetActorBase();
+  return base ? base->GetFormID() : 0;
+}
+
+bool Actor::IsDead() const
+{
+  return actor_->IsDead();
+}
+
+float Actor::GetHealth() const
+{
+  return Game::GetHealth(actor_);
+}
+
+Engine::Position Actor::GetPosition() const
+{
+  const auto position = actor_->GetPosition();
+  return { position.x, position.y, position.z };
+}
+
+std::optional<Engine::Item> Actor::GetEquipped(bool left) const
+{
+  const auto object = actor_->GetEquippedObject(left);
+  if (!object) {
+    return std::nullopt;
+  }
+  if (const auto spell = object->As<RE::SpellItem>()) {
+    return Engine::Item{ GetForm(spell), Equip::Category::Spell };
+  }
+  if (const auto bound = object->As<RE::TESBoundObject>()) {
+    return GetItem(bound);
+  }
+  return std::nullopt;
+}
+
+bool Actor::AddSpell(const Engine::Form& spell)
+{
+  const auto form = RE::TESForm::LookupByID<RE::SpellItem>(spell.id);
+  if (!form) {
+    return false;
+  }
+  if (!actor_->HasSpell(form) && !actor_->AddSpell(form)) {
+    UT_PRINT("UT: %08X SPEL Could not add: %08X %s", actor_->GetFormID(), form->GetFormID(), form->GetName());
+    return false;
+  }
+  return true;
+}
+
+void Actor::UnequipConflicts(const Engine::Form& armor)
+{
+  if (const auto form = RE::TESForm::LookupByID<RE::TESObjectARMO>(armor.id)) {
+    Game::UnequipConflicts(GetBaseID(), actor_, form);
+  }
+}
+
+void Actor::EvaluatePackage()
+{
+  actor_->EvaluatePackage(true, false);
+}
+
+Engine::VM& GetVM() noexcept
+{
+  return Scripts;
+}
+
+std::shared_ptr<Trinity> MakeTrinity(RE::Actor* actor) noexcept
+{
+  const auto base = actor && !actor->IsDead() ? actor->GetActorBase() : nullptr;
+  const auto index = base ? GetClass(base->GetFormID()) : Policy::Classes;
+  if (index >= Policy::Classes) {
+    return nullptr;
+  }
+
+  // Warlocks heal with the heal packages. All members use the packages of their rules.
+  std::vector<std::uint32_t> packages;
+  if (index == static_cast<std::size_t>(Policy::Class::Warlock)) {
+    for (const auto package : { HealSelf, HealKnight, HealGuard, Heal }) {
+      if (package) {
+        packages.push_back(package->GetFormID());
       }
     }
   }
-  return false;
+  for (const auto package : PolicyPackages[index]) {
+    if (package && std::find(packages.begin(), packages.end(), package->GetFormID()) == packages.end()) {
+      packages.push_back(package->GetFormID());
+    }
+  }
+  try {
+    const auto member = static_cast<Policy::Class>(index);
+    return std::make_shared<Trinity>(Scripts, std::make_shared<Actor>(actor), member, std::move(packages));
+  }
+  catch (const std::exception& e) {
+    UT_PRINT("UT: %08X Could not create trinity member: %s", actor->GetFormID(), e.what());
+    return nullptr;
+  }
 }
 
-void AddPackageOverride(
-  RE::FormID id,
-  RE::Actor* actor,
-  RE::TESPackage* package,
-  int priority,
-  bool force,
-  std::function<void(RE::BSScript::Variable)> callback) noexcept
+Engine::Item GetItem(RE::TESBoundObject* object) noexcept
 {
-  const auto policy = VirtualMachine->GetObjectHandlePolicy();
-  if (!policy) {
-    UT_PRINT("UT: [%s] Could not get object handle policy.", GetName(id));
-    return;
+  const auto category = Classify(object);
+  if (category == Equip::Category::Spell) {
+    return { GetForm(object->As<RE::TESObjectBOOK>()->GetSpell()), category };
   }
+  return { GetForm(object), category };
+}
 
-  const auto handle = policy->GetHandleForObject(actor->GetFormType(), actor);
-  if (handle == policy->EmptyHandle()) {
-    UT_PRINT("UT: [%s] Could not get object handle: %08X UT_Actor", GetName(id), actor->GetFormID());
-    return;
+int GetCount(RE::Actor* actor) noexcept
+{
+  for (const auto& [perk, count] : Counts) {
+    if (actor->HasPerk(perk)) {
+      return count;
+    }
   }
+  return 1;
+}
 
-  struct Script {
-    RE::BSFixedString name = "ActorUtil";
-    RE::BSFixedString function = "AddPackageOverride";
-    RE::BSTSmartPointer<RE::BSScript::Object> object;
-    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result;
-  } script;
+double GetDuration(RE::SpellItem* spell) noexcept
+{
+  std::uint32_t duration = 0;
+  for (const auto effect : spell->effects) {
+    if (effect) {
+      duration = std::max(duration, effect->GetDuration());
+    }
+  }
+  return static_cast<double>(duration);
+}
 
-  if (callback) {
-    script.result.reset(new ResultCallback("ActorUtil.AddPackageOverride", std::move(callback)));
+RE::NiPoint3 GetSpawnOffset(RE::Actor* actor, int trinity, float distance) noexcept
+{
+  // Angles in degrees relative to the direction the actor is facing.
+  auto angle = 0.0f;
+  if (trinity == 3) {
+    angle = 22.0f;
+  } else if (const auto count = GetCount(actor); trinity == 1) {
+    angle = count == 2 ? 349.0f : 0.0f;
+  } else if (trinity == 2) {
+    angle = count > 2 ? 338.0f : 11.0f;
   }
+  const auto z = angle * std::numbers::pi_v<float> / 180.0f + actor->GetAngleZ();
+  return { distance * std::sin(z), distance * std::cos(z), 0.0f };
+}
 
-  auto flag = force ? 1 : 0;
-  auto args = RE::MakeFunctionArguments(std::move(actor), std::move(package), std::move(priority), std::move(flag));
-  if (!VirtualMachine->DispatchStaticCall(script.name, script.function, args, script.result)) {
-    UT_PRINT("UT: [%s] Could not call script function: ActorUtil.AddPackageOverride", GetName(id));
-    return;
+void MoveToSpawn(RE::Actor* actor, RE::Actor* summoner, int trinity) noexcept
+{
+  if (actor->GetParentCell() != summoner->GetParentCell()) {
+    actor->MoveTo(summoner);
+  }
+  actor->SetPosition(summoner->GetPosition() + GetSpawnOffset(summoner, trinity), true);
+}
+
+void TakeItems(RE::Actor* actor, int trinity) noexcept
+{
+  if (const auto index = static_cast<std::size_t>(trinity - 1); actor && index < Armors.size()) {
+    TakeItems(actor, Armors[index], Inventories[index]);
   }
 }
 
-void RemovePackageOverride(
+void Materialize(
   RE::FormID id,
   RE::Actor* actor,
-  RE::TESPackage* package,
-  std::function<void(RE::BSScript::Variable)> callback) noexcept
+  RE::Actor* summoner,
+  int trinity,
+  RE::TESObjectREFR* armor,
+  RE::TESObjectREFR* inventory,
+  RE::TESRace* race,
+  RE::TESPackage* follow) noexcept
 {
-  const auto policy = VirtualMachine->GetObjectHandlePolicy();
-  if (!policy) {
-    UT_PRINT("UT: [%s] Could not get object handle policy.", GetName(id));
-    return;
-  }
+  const Trace::Scope trace{ "Materialize" };
 
-  const auto handle = policy->GetHandleForObject(actor->GetFormType(), actor);
-  if (handle == policy->EmptyHandle()) {
-    UT_PRINT("UT: [%s] Could not get object handle: %08X UT_Actor", GetName(id), actor->GetFormID());
-    return;
+  // Move to spawn location.
+  if (summoner) {
+    MoveToSpawn(actor, summoner, trinity);
   }
 
-  struct Script {
-    RE::BSFixedString name = "ActorUtil";
-    RE::BSFixedString function = "RemovePackageOverride";
-    RE::BSTSmartPointer<RE::BSScript::Object> object;
-    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result;
-  } script;
+  TakeItems(actor, armor, inventory);
 
-  if (callback) {
-    script.result.reset(new ResultCallback("ActorUtil.RemovePackageOverride", std::move(callback)));
+  // Actors summoned before the base race was changed still have the invisible race.
+  if (race && actor->GetRace() != race) {
+    UT_TRACE("UT: [%s] %08X Switching race.", GetName(id), actor->GetFormID());
+    actor->SwitchRace(race, false);
   }
 
-  auto args = RE::MakeFunctionArguments(std::move(actor), std::move(package));
-  if (!VirtualMachine->DispatchStaticCall(script.name, script.function, args, script.result)) {
-    UT_PRINT("UT: [%s] Could not call script function: ActorUtil.RemovePackageOverride", GetName(id));
-    return;
+  if (follow) {
+    Actor member{ actor };
+    Packages::Add(Scripts, member, follow->GetFormID(), 1, true);
   }
 }
 
-void ClearPackageOverride(RE::FormID id, RE::Actor* actor, std::function<void(RE::BSScript::Variable)> callback) noexcept
+Conditions::Stats GetConditionStats() noexcept
 {
-  const auto policy = VirtualMachine->GetObjectHandlePolicy();
-  if (!policy) {
-    UT_PRINT("UT: [%s] Could not get object handle policy.", GetName(id));
-    return;
+  Conditions::Stats stats;
+  for (const auto& e : PerkConditions) {
+    stats += e.second.GetStats();
   }
+  return stats;
+}
 
-  const auto handle = policy->GetHandleForObject(actor->GetFormType(), actor);
-  if (handle == policy->EmptyHandle()) {
-    UT_PRINT("UT: [%s] Could not get object handle: %08X UT_Actor", GetName(id), actor->GetFormID());
-    return;
-  }
+std::vector<std::string> GetModels() noexcept
+{
+  std::vector<std::string> models;
+  try {
+    const auto add = [&](const RE::TESModel& model) {
+      if (const auto path = model.GetModel(); path && *path) {
+        auto name = std::format("meshes\\{}", path);
+        if (std::ranges::find(models, name) == models.end()) {
+          models.push_back(std::move(name));
+        }
+      }
+    };
+    const std::array actors{ Guard, Knight, Warlock };
+    for (std::size_t i = 0; i < actors.size(); i++) {
+      const auto npc = RE::TESForm::LookupByID<RE::TESNPC>(actors[i]);
+      const auto race = Races[i + 1];
+      if (!npc || !race) {
+        continue;
+      }
 
-  struct Script {
-    RE::BSFixedString name = "ActorUtil";
-    RE::BSFixedString function = "ClearPackageOverride";
-    RE::BSTSmartPointer<RE::BSScript::Object> object;
-    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> result;
-  } script;
+      // Only the models of the race and sex the member is summoned with are loaded.
+      const auto sex = static_cast<std::size_t>(npc->GetSex());
+      const auto addArmor = [&](const RE::TESObjectARMO* armor) {
+        for (const auto addon : armor->armorAddons) {
+          if (addon && addon->IsValidRace(race)) {
+            add(addon->bipedModels[sex]);
+          }
+        }
+      };
+      add(race->skeletonModels[sex]);
+      if (race->skin) {
+        addArmor(race->skin);
+      }
 
-  if (callback) {
-    script.result.reset(new ResultCallback("ActorUtil.ClearPackageOverride", std::move(callback)));
+      // Items in the armor container are equipped by Materialize. Items in the inventory container are not.
+      for (const auto& [object, data] : Armors[i]->GetInventory()) {
+        if (const auto armor = object->As<RE::TESObjectARMO>()) {
+          addArmor(armor);
+        } else if (const auto weapon = object->As<RE::TESObjectWEAP>()) {
+          add(*weapon);
+        }
+      }
+    }
   }
-
-  auto args = RE::MakeFunctionArguments(std::move(actor));
-  if (!VirtualMachine->DispatchStaticCall(script.name, script.function, args, script.result)) {
-    UT_PRINT("UT: [%s] Could not call script function: ActorUtil.ClearPackageOverride", GetName(id));
-    return;
+  catch (const std::exception& e) {
+    UT_PRINT("UT: Could not get models: %s", e.what());
   }
+  return models;
 }
 
 float GetHealth(RE::Actor* actor) noexcept
@@ -861,4 +1183,72 @@ float GetHealth(RE::Actor* actor) noexcept
   return 1.0f;
 }
 
+// Returns true if the conditions of an effect of the spell pass for the target.
+// Magic effect conditions run on the target, with the caster as their target.
+bool CanAffect(RE::SpellItem* spell, RE::Actor* caster, RE::Actor* target) noexcept
+{
+  for (const auto effect : spell->effects) {
+    if (
+      effect && effect->baseEffect && effect->conditions(target, caster) &&
+      effect->baseEffect->conditions(target, caster))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Cast(RE::Actor* caster, RE::SpellItem* spell, RE::Actor* target) noexcept
+{
+  if (!caster || !spell || !target || !CanAffect(spell, caster, target)) {
+    return false;
+  }
+  const auto avo = caster->AsActorValueOwner();
+  const auto magic = caster->GetMagicCaster(RE::MagicSystem::CastingSource::kInstant);
+  if (!avo || !magic) {
+    return false;
+  }
+  const auto cost = spell->CalculateMagickaCost(caster);
+  if (avo->GetActorValue(RE::ActorValue::kMagicka) < cost) {
+    return false;
+  }
+  avo->RestoreActorValue(RE::ACTOR_VALUE_MODIFIER::kDamage, RE::ActorValue::kMagicka, -cost);
+  magic->CastSpellImmediate(spell, false, target, 1.0f, false, 0.0f, caster);
+  return true;
+}
+
+RE::SpellItem* GetHealSpell(RE::Actor* caster, RE::Actor* target) noexcept
+{
+  if (!caster || !target) {
+    return nullptr;
+  }
+  for (const auto spell : { HealAlly, HealUndead }) {
+    if (spell && CanAffect(spell, caster, target)) {
+      return spell;
+    }
+  }
+  return nullptr;
+}
+
+RE::TESPackage* GetPolicyPackage(
+  RE::FormID id,
+  bool combat,
+  std::span<const Policy::Input, Policy::Subjects> inputs) noexcept
+{
+  if (const auto index = GetClass(id); index < Policy::Classes) {
+    if (const auto rule = Policies[index].Evaluate(combat, inputs); rule != Policy::None) {
+      return RulePackages[rule];
+    }
+  }
+  return nullptr;
+}
+
+std::span<RE::TESPackage* const> GetPolicyPackages(RE::FormID id) noexcept
+{
+  if (const auto index = GetClass(id); index < Policy::Classes) {
+    return PolicyPackages[index];
+  }
+  return {};
+}
+
 }  // namespace UT::Game
@@ -1,8 +1,19 @@
 #pragma once
-
-#define UT_DEBUG_TRACE 0
-#define UT_DEBUG_PERKS 0
-#define UT_DEBUG_SPELL 0
+#include <conditions.hpp>
+#include <engine.hpp>
+#include <equip.hpp>
+#include <forms.hpp>
+#include <packages.hpp>
+#include <policy.hpp>
+#include <schedule.hpp>
+#include <trace.hpp>
+#include <trinity.hpp>
+
+#define UT_DEBUG_TRACE  0
+#define UT_DEBUG_PERKS  0
+#define UT_DEBUG_SPELL  0
+#define UT_DEBUG_EVENTS 0
+#define UT_DEBUG_RECORD 0
 
 #define UT_PRINT RE::ConsoleLog::GetSingleton()->Print
 
@@ -20,17 +31,14 @@
 
 namespace UT::Game {
 
-enum class Mods {
-  Skyrim,
-  Requiem,
-};
+using Forms::Mods;
 
 inline Mods Mod = Mods::Skyrim;
 
-constexpr std::string_view Skyrim{ "Skyrim.esm" };
-constexpr std::string_view Dawnguard{ "Dawnguard.esm" };
-constexpr std::string_view Requiem{ "Requiem.esp" };
-constexpr std::string_view Trinity{ "Undead Trinity.esp" };
+using Forms::Dawnguard;
+using Forms::Requiem;
+using Forms::Skyrim;
+using Forms::Trinity;
 
 inline const SKSE::PapyrusInterface* Papyrus{ nullptr };
 
@@ -65,34 +73,125 @@ inline RE::TESPackage* HealGuard{ nullptr };
 inline RE::TESPackage* HealKnight{ nullptr };
 inline RE::TESPackage* HealSelf{ nullptr };
 
+// Heal packages have fixed targets. Allies that are not trinity members are healed with these spells.
+// The conditions of the ally spell exclude undead actors, which are healed with the undead spell.
+inline RE::SpellItem* HealAlly{ nullptr };
+inline RE::SpellItem* HealUndead{ nullptr };
+
+// Maximum number of microseconds per frame spent on scheduled tasks.
+constexpr std::int64_t ScheduleBudget = 1000;
+
+// Game actor for the engine layer. Script calls of the engine layer expect every actor to be one.
+class Actor final : public Engine::Actor {
+public:
+  explicit Actor(RE::Actor* actor) noexcept :
+    actor_(actor)
+  {}
+
+  RE::Actor* Get() const noexcept
+  {
+    return actor_;
+  }
+
+  std::uint32_t GetFormID() const override;
+  std::uint32_t GetBaseID() const override;
+  bool IsDead() const override;
+  float GetHealth() const override;
+  Engine::Position GetPosition() const override;
+  std::optional<Engine::Item> GetEquipped(bool left) const override;
+  bool AddSpell(const Engine::Form& spell) override;
+  void UnequipConflicts(const Engine::Form& armor) override;
+  void EvaluatePackage() override;
+
+private:
+  RE::Actor* actor_;
+};
+
+// Returns the game actor of a trinity member created by MakeTrinity.
+inline RE::Actor* GetActor(const Trinity& trinity) noexcept
+{
+  return static_cast<const Actor&>(trinity.GetActor()).Get();
+}
+
 void Load();
 void Initialize(RE::FormID id, RE::Actor* actor) noexcept;
 
-void Equip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object) noexcept;
+// Queues a task that runs on the main thread within the per-frame budget.
+void Schedule(Scheduler::Priority priority, Scheduler::Job job) noexcept;
+
+// Returns the generation of the running game. Script callbacks and tasks from an older
+// generation belong to a game that was unloaded.
+std::uint32_t GetGeneration() noexcept;
+
+// Starts a new generation, drops queued tasks and pending script callbacks.
+void Invalidate() noexcept;
+
+// Returns the script calls of the engine layer, dispatched to the Papyrus VM.
+Engine::VM& GetVM() noexcept;
+
+// Creates a trinity member for a living actor with a trinity actor base or returns nullptr.
+std::shared_ptr<Trinity> MakeTrinity(RE::Actor* actor) noexcept;
+
+// Returns the item for an object in an inventory. Spell tomes return the spell they teach.
+Engine::Item GetItem(RE::TESBoundObject* object) noexcept;
+
 void Unequip(RE::FormID id, RE::Actor* actor, RE::TESBoundObject* object, RE::ExtraDataList* extra) noexcept;
 
-bool CanEquip(RE::FormID id, RE::TESBoundObject* object) noexcept;
+// Refreshes the item list of the open container menu in a UI task.
+void UpdateContainerMenu() noexcept;
 
-void AddPackageOverride(
-  RE::FormID id,
-  RE::Actor* actor,
-  RE::TESPackage* package,
-  int priority = 30,
-  bool force = false,
-  std::function<void(RE::BSScript::Variable)> callback = {}) noexcept;
+float GetHealth(RE::Actor* actor) noexcept;
 
-void RemovePackageOverride(
-  RE::FormID id,
-  RE::Actor* actor,
-  RE::TESPackage* package,
-  std::function<void(RE::BSScript::Variable)> callback = {}) noexcept;
+// Casts a spell at the target without a cast animation and damages the magicka of the caster by the cost.
+// Returns false when the caster does not have enough magicka or no effect of the spell can affect the target.
+bool Cast(RE::Actor* caster, RE::SpellItem* spell, RE::Actor* target) noexcept;
+
+// Returns the spell that heals the ally or nullptr when no heal spell can affect it.
+RE::SpellItem* GetHealSpell(RE::Actor* caster, RE::Actor* target) noexcept;
 
-void ClearPackageOverride(
+// Returns the number of trinity members the actor can summon.
+int GetCount(RE::Actor* actor) noexcept;
+
+// Returns the longest effect duration of the spell in seconds.
+double GetDuration(RE::SpellItem* spell) noexcept;
+
+// Returns the spawn location of a trinity member relative to the actor.
+RE::NiPoint3 GetSpawnOffset(RE::Actor* actor, int trinity, float distance = 180.0f) noexcept;
+
+// Moves an actor to its spawn location next to the summoner.
+void MoveToSpawn(RE::Actor* actor, RE::Actor* summoner, int trinity) noexcept;
+
+// Moves the items that a trinity member left in its armor and inventory containers back to the actor
+// and equips the armor.
+void TakeItems(RE::Actor* actor, int trinity) noexcept;
+
+// Moves a summoned actor to its spawn location, equips the items of the armor container, moves the items
+// of the inventory container and adds the follow package. Called before the first 3D load of the actor.
+void Materialize(
   RE::FormID id,
   RE::Actor* actor,
-  std::function<void(RE::BSScript::Variable)> callback = {}) noexcept;
+  RE::Actor* summoner,
+  int trinity,
+  RE::TESObjectREFR* armor,
+  RE::TESObjectREFR* inventory,
+  RE::TESRace* race,
+  RE::TESPackage* follow) noexcept;
+
+// Returns the perk condition cache statistics of all trinity members.
+Conditions::Stats GetConditionStats() noexcept;
+
+// Returns the mesh paths a summon loads: the skeleton and skin of the race and sex every member is
+// summoned with, and the armor and weapons it equips from its armor container.
+std::vector<std::string> GetModels() noexcept;
+
+// Returns the package selected by the rules for a trinity member or nullptr.
+RE::TESPackage* GetPolicyPackage(
+  RE::FormID id,
+  bool combat,
+  std::span<const Policy::Input, Policy::Subjects> inputs) noexcept;
 
-float GetHealth(RE::Actor* actor) noexcept;
+// Returns all packages that rules can select for a trinity member.
+std::span<RE::TESPackage* const> GetPolicyPackages(RE::FormID id) noexcept;
 
 constexpr const char* GetName(Mods mod) noexcept
 {
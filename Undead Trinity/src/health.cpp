@@ -0,0 +1,71 @@
+#include "health.hpp"
+
+#include <chrono>
+
+namespace UT {
+
+void Health::Sample(double time, float value) noexcept
+{
+  // Merge samples that were taken at the same time (hit event and update).
+  if (size_) {
+    auto& last = samples_[(head_ + Capacity - 1) % Capacity];
+    if (time < last.time + 0.01) {
+      last.value = value;
+      return;
+    }
+  }
+  samples_[head_] = { time, value };
+  head_ = (head_ + 1) % Capacity;
+  if (size_ < Capacity) {
+    size_++;
+  }
+
+  // Fit a line through the samples in the window.
+  auto n = 0.0;
+  auto st = 0.0;
+  auto sv = 0.0;
+  auto stt = 0.0;
+  auto stv = 0.0;
+  for (std::size_t i = 0; i < size_; i++) {
+    const auto& e = samples_[(head_ + Capacity - 1 - i) % Capacity];
+    const auto t = e.time - time;
+    if (t < -Window) {
+      break;
+    }
+    n += 1.0;
+    st += t;
+    sv += e.value;
+    stt += t * t;
+    stv += t * e.value;
+  }
+  auto rate = 0.0f;
+  if (const auto d = n * stt - st * st; n > 1.0 && d > 0.0) {
+    rate = static_cast<float>(-(n * stv - st * sv) / d);
+  }
+  rate_ += Smoothing * (rate - rate_);
+}
+
+void Health::Reset() noexcept
+{
+  head_ = 0;
+  size_ = 0;
+  rate_ = 0.0f;
+}
+
+float Health::GetValue() const noexcept
+{
+  return size_ ? samples_[(head_ + Capacity - 1) % Capacity].value : 1.0f;
+}
+
+float Health::GetRate() const noexcept
+{
+  return rate_;
+}
+
+double Health::Now() noexcept
+{
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+}  // namespace UT
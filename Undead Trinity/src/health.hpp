@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+namespace UT {
+
+// Estimates how fast an actor loses health from a fixed number of health ratio samples.
+class Health {
+public:
+  static constexpr std::size_t Capacity = 16;
+
+  // Seconds of samples used by the least-squares fit.
+  static constexpr double Window = 4.0;
+
+  // Weight of the newest least-squares fit in the moving average.
+  static constexpr float Smoothing = 0.4f;
+
+  void Sample(double time, float value) noexcept;
+  void Reset() noexcept;
+
+  // Returns the last sampled health ratio.
+  float GetValue() const noexcept;
+
+  // Returns the health ratio lost per second (negative while healing).
+  float GetRate() const noexcept;
+
+  // Returns a monotonic time stamp in seconds.
+  static double Now() noexcept;
+
+private:
+  struct Entry {
+    double time{ 0.0 };
+    float value{ 1.0f };
+  };
+
+  std::array<Entry, Capacity> samples_{};
+  std::size_t head_{ 0 };
+  std::size_t size_{ 0 };
+  float rate_{ 0.0f };
+};
+
+}  // namespace UT
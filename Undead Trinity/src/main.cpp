@@ -1,9 +1,68 @@
+#include <allies.hpp>
 #include <game.hpp>
+#include <record.hpp>
+#include <snapshot.hpp>
+#include <tracker.hpp>
+#include <triage.hpp>
 #include <trinity.hpp>
+#include <worker.hpp>
 #include <version.h>
 
 namespace UT {
 
+// Trinity members that are read on the main thread and modified on script threads.
+struct Roster {
+  std::shared_ptr<Trinity> guard;
+  std::shared_ptr<Trinity> knight;
+  std::shared_ptr<Trinity> warlock;
+
+  std::shared_ptr<Trinity>& Get(RE::FormID id) noexcept
+  {
+    if (id == Game::Guard) {
+      return guard;
+    }
+    if (id == Game::Knight) {
+      return knight;
+    }
+    return warlock;
+  }
+
+  const std::shared_ptr<Trinity>& Get(RE::FormID id) const noexcept
+  {
+    return const_cast<Roster*>(this)->Get(id);
+  }
+};
+
+// Party state sampled on the main thread and evaluated on the planner thread.
+struct Plan {
+  struct Member {
+    RE::FormID id{ 0 };
+    bool present{ false };
+    bool dead{ false };
+    float health{ 1.0f };
+    float rate{ 0.0f };
+    RE::NiPoint3 position;
+  };
+
+  std::uint32_t generation{ 0 };
+  double time{ 0.0 };
+  bool combat{ false };
+  std::array<Member, 4> members;  // player, guard, knight, warlock
+  Member ally;                    // nearby ally that needs healing the most
+};
+
+// Packages selected by the planner thread for the guard, knight and warlock.
+struct Decision {
+  std::uint32_t generation{ 0 };
+  double time{ 0.0 };
+  std::array<RE::FormID, Policy::Classes> members{};
+  std::array<RE::TESPackage*, Policy::Classes> packages{};
+  bool triage{ false };
+  Triage::Party party;
+  Triage::Target target{ Triage::Target::None };
+  RE::FormID ally{ 0 };  // ally in the party or zero
+};
+
 class Manager final :
   public RE::BSTEventSink<RE::InputEvent*>,
   public RE::BSTEventSink<RE::TESCombatEvent>,
@@ -38,6 +97,11 @@ public:
         manager->OnPostLoadGame();
       }
       break;
+    case SKSE::MessagingInterface::kNewGame:
+      if (auto manager = GetSingleton(); manager->initialized_) {
+        manager->Prewarm();
+      }
+      break;
     }
   }
 
@@ -69,22 +133,202 @@ public:
     input->AddEventSink<RE::InputEvent*>(this);
 
     // Get script event source holder.
-    // auto sesh = RE::ScriptEventSourceHolder::GetSingleton();
-    // if (!sesh) {
-    //   UT_PRINT("UT: Could not get script event source holder.");
-    //   return false;
-    // }
+    auto sesh = RE::ScriptEventSourceHolder::GetSingleton();
+    if (!sesh) {
+      UT_PRINT("UT: Could not get script event source holder.");
+      return false;
+    }
 
     // Add combat event sink.
     // sesh->AddEventSink<RE::TESCombatEvent>(this);
 
     // Add hit event sink.
-    // sesh->AddEventSink<RE::TESHitEvent>(this);
+    sesh->AddEventSink<RE::TESHitEvent>(this);
+
+#if UT_DEBUG_EVENTS
+    // Record plugin activity.
+    Trace::Start();
+#endif
 
     initialized_ = true;
     return true;
   }
 
+  static void OnSave(SKSE::SerializationInterface* serialization) noexcept
+  {
+    const auto manager = GetSingleton();
+    if (!manager->initialized_) {
+      return;
+    }
+    std::vector<std::shared_ptr<Trinity>> members;
+    const auto roster = manager->roster_.Read();
+    for (const auto& trinity : { roster->guard, roster->knight, roster->warlock }) {
+      if (trinity) {
+        members.push_back(trinity);
+      }
+    }
+    if (!serialization->OpenRecord(RosterRecord, RosterVersion)) {
+      UT_PRINT("UT: Could not open roster record.");
+      return;
+    }
+    serialization->WriteRecordData(static_cast<std::uint32_t>(members.size()));
+    for (const auto& trinity : members) {
+      serialization->WriteRecordData(trinity->GetClass());
+      serialization->WriteRecordData(trinity->GetFormID());
+      serialization->WriteRecordData(RE::FormID{ trinity->GetCombatPackage() });
+    }
+
+    std::lock_guard lock{ manager->pool_mutex_ };
+    if (!serialization->OpenRecord(PoolRecord, PoolVersion)) {
+      UT_PRINT("UT: Could not open pool record.");
+      return;
+    }
+    // Every entry holds the parked actor and the remaining duration of the revived member.
+    const auto now = Health::Now();
+    serialization->WriteRecordData(static_cast<std::uint32_t>(Pool));
+    for (std::size_t i = 0; i < Pool; i++) {
+      const auto actor = manager->pool_[i].get();
+      const auto expires = manager->expires_[i];
+      serialization->WriteRecordData(actor ? actor->GetFormID() : RE::FormID{ 0 });
+      serialization->WriteRecordData(expires > 0.0 ? std::max(expires - now, 1.0) : 0.0);
+    }
+
+    std::lock_guard visuals{ manager->visuals_mutex_ };
+    if (!serialization->OpenRecord(VisualsRecord, VisualsVersion)) {
+      UT_PRINT("UT: Could not open visuals record.");
+      return;
+    }
+    serialization->WriteRecordData(static_cast<std::uint32_t>(manager->visuals_.size()));
+    for (const auto& handle : manager->visuals_) {
+      const auto reference = handle.get();
+      serialization->WriteRecordData(reference ? reference->GetFormID() : RE::FormID{ 0 });
+    }
+
+    std::lock_guard tracker{ manager->tracker_mutex_ };
+    if (!serialization->OpenRecord(TrackerRecord, TrackerVersion)) {
+      UT_PRINT("UT: Could not open tracker record.");
+      return;
+    }
+    serialization->WriteRecordData(static_cast<std::uint32_t>(manager->tracker_.GetSize()));
+    for (const auto& entry : manager->tracker_.GetEntries()) {
+      if (entry.kind != Tracker::Kind::None) {
+        serialization->WriteRecordData(entry.id);
+        serialization->WriteRecordData(entry.kind);
+      }
+    }
+  }
+
+  static void OnLoad(SKSE::SerializationInterface* serialization) noexcept
+  {
+    const auto manager = GetSingleton();
+    std::uint32_t type = 0;
+    std::uint32_t version = 0;
+    std::uint32_t length = 0;
+    while (serialization->GetNextRecordInfo(type, version, length)) {
+      if (type == PoolRecord && version == PoolVersion) {
+        std::lock_guard lock{ manager->pool_mutex_ };
+        const auto now = Health::Now();
+        std::uint32_t size = 0;
+        serialization->ReadRecordData(size);
+        for (std::size_t i = 0; i < std::min<std::size_t>(size, Pool); i++) {
+          RE::FormID actor = 0;
+          double duration = 0.0;
+          if (!serialization->ReadRecordData(actor) || !serialization->ReadRecordData(duration)) {
+            UT_PRINT("UT: Could not read pool record.");
+            break;
+          }
+          if (actor && serialization->ResolveFormID(actor, actor)) {
+            if (const auto form = RE::TESForm::LookupByID<RE::Actor>(actor)) {
+              manager->pool_[i] = form->GetHandle();
+            }
+          }
+          manager->expires_[i] = duration > 0.0 ? now + duration : 0.0;
+        }
+        continue;
+      }
+      if (type == TrackerRecord && version == TrackerVersion) {
+        std::lock_guard lock{ manager->tracker_mutex_ };
+        std::uint32_t size = 0;
+        serialization->ReadRecordData(size);
+        for (std::uint32_t i = 0; i < size; i++) {
+          RE::FormID reference = 0;
+          auto kind = Tracker::Kind::None;
+          if (!serialization->ReadRecordData(reference) || !serialization->ReadRecordData(kind)) {
+            UT_PRINT("UT: Could not read tracker record.");
+            break;
+          }
+          if (serialization->ResolveFormID(reference, reference)) {
+            manager->tracker_.Track(reference, kind);
+          }
+        }
+        continue;
+      }
+      if (type == VisualsRecord && version == VisualsVersion) {
+        std::lock_guard lock{ manager->visuals_mutex_ };
+        std::uint32_t size = 0;
+        serialization->ReadRecordData(size);
+        for (std::uint32_t i = 0; i < size; i++) {
+          RE::FormID reference = 0;
+          serialization->ReadRecordData(reference);
+          if (reference && serialization->ResolveFormID(reference, reference)) {
+            if (const auto form = RE::TESForm::LookupByID<RE::TESObjectREFR>(reference)) {
+              manager->visuals_.push_back(form->GetHandle());
+            }
+          }
+        }
+        continue;
+      }
+      if (type != RosterRecord || version != RosterVersion) {
+        continue;
+      }
+      std::uint32_t size = 0;
+      serialization->ReadRecordData(size);
+      for (std::uint32_t i = 0; i < size; i++) {
+        RE::FormID id = 0;
+        RE::FormID actor = 0;
+        RE::FormID package = 0;
+        if (!serialization->ReadRecordData(id) || !serialization->ReadRecordData(actor) ||
+            !serialization->ReadRecordData(package)) {
+          UT_PRINT("UT: Could not read roster record.");
+          break;
+        }
+        if (!serialization->ResolveFormID(id, id) || !serialization->ResolveFormID(actor, actor)) {
+          continue;
+        }
+        if (package && !serialization->ResolveFormID(package, package)) {
+          package = 0;
+        }
+        if (package && !RE::TESForm::LookupByID<RE::TESPackage>(package)) {
+          package = 0;
+        }
+        manager->saved_.push_back({ id, actor, package });
+      }
+      manager->restored_ = true;
+    }
+  }
+
+  static void OnRevert(SKSE::SerializationInterface* serialization) noexcept
+  {
+    const auto manager = GetSingleton();
+    manager->saved_.clear();
+    manager->restored_ = false;
+    std::lock_guard lock{ manager->pool_mutex_ };
+    manager->pool_ = {};
+    manager->expires_ = {};
+    std::lock_guard visuals{ manager->visuals_mutex_ };
+    manager->visuals_.clear();
+    std::lock_guard tracker{ manager->tracker_mutex_ };
+    manager->tracker_.Clear();
+  }
+
+  static void Register(const SKSE::SerializationInterface* serialization) noexcept
+  {
+    serialization->SetUniqueID(Serialization);
+    serialization->SetSaveCallback(OnSave);
+    serialization->SetLoadCallback(OnLoad);
+    serialization->SetRevertCallback(OnRevert);
+  }
+
   static Manager* GetSingleton() noexcept
   {
     static Manager trinity;
@@ -159,12 +403,90 @@ private:
       GetSingleton()->Update();
     }
 
+    static RE::Actor* Get(RE::StaticFunctionTag*, std::int32_t trinity)
+    {
+      return GetSingleton()->Get(GetClass(trinity));
+    }
+
+    static bool Park(RE::StaticFunctionTag*, RE::Actor* actor)
+    {
+      return GetSingleton()->Park(actor);
+    }
+
+    static RE::Actor* Unpark(RE::StaticFunctionTag*, std::int32_t trinity)
+    {
+      return GetSingleton()->Unpark(GetClass(trinity));
+    }
+
+    static std::int32_t GetCount(RE::StaticFunctionTag*, RE::Actor* actor)
+    {
+      return actor ? Game::GetCount(actor) : 1;
+    }
+
+    static std::vector<float> GetSpawnLocation(RE::StaticFunctionTag*, RE::Actor* actor, std::int32_t trinity, float distance)
+    {
+      if (!actor) {
+        return { 0.0f, 0.0f };
+      }
+      const auto offset = Game::GetSpawnOffset(actor, trinity, distance);
+      return { offset.x, offset.y };
+    }
+
+    static void ShowVisuals(RE::StaticFunctionTag*, RE::Actor* actor, RE::TESForm* visual)
+    {
+      GetSingleton()->ShowVisuals(actor, visual);
+    }
+
+    static void HideVisuals(RE::StaticFunctionTag*)
+    {
+      GetSingleton()->HideVisuals();
+    }
+
+    static void Materialize(
+      RE::StaticFunctionTag*,
+      RE::Actor* actor,
+      RE::Actor* summoner,
+      std::int32_t trinity,
+      RE::TESObjectREFR* armor,
+      RE::TESObjectREFR* inventory,
+      RE::TESRace* race,
+      RE::TESPackage* follow)
+    {
+      GetSingleton()->Materialize(actor, summoner, trinity, armor, inventory, race, follow);
+    }
+
+    static std::vector<RE::Actor*> GetActors(RE::StaticFunctionTag*)
+    {
+      return GetSingleton()->GetActors();
+    }
+
+    static std::vector<float> GetStates(RE::StaticFunctionTag*)
+    {
+      return GetSingleton()->GetStates();
+    }
+
+    static void Summon(RE::StaticFunctionTag*, RE::Actor* actor, std::vector<RE::SpellItem*> spells)
+    {
+      GetSingleton()->Summon(actor, spells);
+    }
+
     static bool Register(RE::BSScript::IVirtualMachine* vm) noexcept
     {
       // clang-format off
       vm->RegisterFunction("Add",    "UT_Trinity", Add);
       vm->RegisterFunction("Remove", "UT_Trinity", Remove);
       vm->RegisterFunction("Update", "UT_Trinity", Update);
+      vm->RegisterFunction("Get",    "UT_Trinity", Get);
+      vm->RegisterFunction("Park",   "UT_Trinity", Park);
+      vm->RegisterFunction("Unpark", "UT_Trinity", Unpark);
+      vm->RegisterFunction("GetCount",         "UT_Trinity", GetCount);
+      vm->RegisterFunction("GetSpawnLocation", "UT_Trinity", GetSpawnLocation);
+      vm->RegisterFunction("ShowVisuals",      "UT_Trinity", ShowVisuals);
+      vm->RegisterFunction("HideVisuals",      "UT_Trinity", HideVisuals);
+      vm->RegisterFunction("Materialize",      "UT_Trinity", Materialize);
+      vm->RegisterFunction("GetActors",        "UT_Trinity", GetActors);
+      vm->RegisterFunction("GetStates",        "UT_Trinity", GetStates);
+      vm->RegisterFunction("Summon",           "UT_Trinity", Summon);
       // clang-format on
       return true;
     }
@@ -172,13 +494,32 @@ private:
 
   void OnPreLoadGame() noexcept
   {
-    guard_.reset();
-    knight_.reset();
-    warlock_.reset();
+    // Invalidate members instead of clearing their packages while the game is loading.
+    Game::Invalidate();
+    recorder_.Close();
+    player_.Reset();
+    {
+      std::lock_guard lock{ updating_ };
+      update_ = 0.0;
+    }
+    roster_.Write([](Roster& roster) { roster = {}; });
   }
 
   void OnPostLoadGame() noexcept
   {
+    // Read the models of the next summon while the player is still in the loading screen.
+    Prewarm();
+
+#if UT_DEBUG_RECORD
+    // Record party state.
+    if (const auto directory = SKSE::log::log_directory()) {
+      const auto path = *directory / "undead_trinity.utr";
+      if (!recorder_.Open(path)) {
+        UT_PRINT("UT: Could not open recording %s", path.string().data());
+      }
+    }
+#endif
+
     // Get player process.
     const auto process = Game::Player->GetActorRuntimeData().currentProcess;
     if (!process) {
@@ -193,12 +534,97 @@ private:
       return;
     }
 
-    // Get player commanded actors.
+    // Restore members from the co-save without clearing their packages.
+    if (restored_) {
+      for (const auto& e : saved_) {
+        Game::Schedule(Scheduler::Priority::Low, [this, e]() noexcept {
+          const auto actor = RE::TESForm::LookupByID<RE::Actor>(e.actor);
+          if (const auto base = actor ? actor->GetActorBase() : nullptr; base && base->GetFormID() == e.id) {
+            Add(actor, e.package);
+          }
+          return true;
+        });
+      }
+      saved_.clear();
+      restored_ = false;
+      Reclaim();
+      return;
+    }
+
+    // Add player commanded actors one per task.
     for (const auto& e : middleHigh->commandedActors) {
-      if (const auto actor = e.commandedActor.get()) {
-        Add(actor.get());
+      Game::Schedule(Scheduler::Priority::Low, [this, handle = e.commandedActor]() noexcept {
+        if (const auto actor = handle.get()) {
+          Add(actor.get());
+        }
+        return true;
+      });
+    }
+
+    // Add members that were revived from the pool. They are not commanded actors.
+    if (const auto processes = RE::ProcessLists::GetSingleton()) {
+      for (const auto& handle : processes->highActorHandles) {
+        const auto actor = handle.get();
+        const auto base = actor ? actor->GetActorBase() : nullptr;
+        if (!base || GetPoolIndex(base->GetFormID()) == Pool || actor->IsCommandedActor()) {
+          continue;
+        }
+        Game::Schedule(Scheduler::Priority::Low, [this, handle]() noexcept {
+          if (const auto actor = handle.get()) {
+            Add(actor.get());
+          }
+          return true;
+        });
       }
     }
+    Reclaim();
+  }
+
+  // Reclaims references from earlier sessions that are not owned by the roster or a pool.
+  // Runs after the members of the loaded game were added.
+  void Reclaim() noexcept
+  {
+    Game::Schedule(Scheduler::Priority::Low, [this]() noexcept {
+      const auto roster = roster_.Read();
+      std::scoped_lock lock{ tracker_mutex_, pool_mutex_, visuals_mutex_ };
+      [[maybe_unused]] const auto orphaned = tracker_.Audit([&](const Tracker::Entry& entry) {
+        if (entry.kind == Tracker::Kind::Visual) {
+          return std::ranges::any_of(visuals_, [&](const RE::ObjectRefHandle& handle) {
+            const auto reference = handle.get();
+            return reference && reference->GetFormID() == entry.id;
+          });
+        }
+        for (const auto& trinity : { roster->guard, roster->knight, roster->warlock }) {
+          if (trinity && trinity->GetFormID() == entry.id) {
+            return true;
+          }
+        }
+        return std::ranges::any_of(pool_, [&](const RE::ActorHandle& handle) {
+          const auto actor = handle.get();
+          return actor && actor->GetFormID() == entry.id;
+        });
+      });
+      UT_TRACE("UT: %zu of %zu tracked references are orphaned.", orphaned, tracker_.GetSize());
+      return true;
+    });
+    Game::Schedule(Scheduler::Priority::Low, [this]() noexcept {
+      const Trace::Scope trace{ "Manager::Reclaim" };
+      std::lock_guard lock{ tracker_mutex_ };
+      return !tracker_.Reclaim(ReclaimBudget, [](const Tracker::Entry& entry) {
+        const auto reference = RE::TESForm::LookupByID<RE::TESObjectREFR>(entry.id);
+        if (!reference) {
+          return true;
+        }
+        // Living actors are not deleted, they are only no longer tracked.
+        if (const auto actor = reference->As<RE::Actor>(); actor && !actor->IsDead() && !actor->IsDisabled()) {
+          return true;
+        }
+        UT_TRACE("UT: %08X Deleting orphaned reference.", entry.id);
+        reference->Disable();
+        reference->SetDelete(true);
+        return true;
+      });
+    });
   }
 
   RE::BSEventNotifyControl OnAction() noexcept
@@ -233,24 +659,43 @@ private:
 
     std::string info;
     auto ss = std::back_inserter(info);
-    if (const auto guard = guard_) {
-      std::format_to(ss, " G:{:.1f}", Game::Player->GetPosition().GetDistance(guard->GetPosition()));
+    const auto roster = roster_.Read();
+    if (const auto& guard = roster->guard) {
+      std::format_to(ss, " G:{:.1f}", Game::Player->GetPosition().GetDistance(Game::GetActor(*guard)->GetPosition()));
     }
-    if (const auto knight = knight_) {
-      std::format_to(ss, " K:{:.1f}", Game::Player->GetPosition().GetDistance(knight->GetPosition()));
+    if (const auto& knight = roster->knight) {
+      std::format_to(ss, " K:{:.1f}", Game::Player->GetPosition().GetDistance(Game::GetActor(*knight)->GetPosition()));
     }
-    if (const auto warlock = warlock_) {
-      std::format_to(ss, " W:{:.1f}", Game::Player->GetPosition().GetDistance(warlock->GetPosition()));
+    if (const auto& warlock = roster->warlock) {
+      std::format_to(ss, " W:{:.1f}", Game::Player->GetPosition().GetDistance(Game::GetActor(*warlock)->GetPosition()));
+    }
+    if (const auto stats = Game::GetConditionStats(); stats.hits + stats.misses) {
+      const auto rate = static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+      std::format_to(ss, " P:{:.0f}% {:.2f}ms", rate * 100.0, stats.saved * 1000.0);
     }
     if (!info.empty()) {
       UT_PRINT("UT:%s", info.data());
     }
 
+#if UT_DEBUG_EVENTS
+    // Write recorded plugin activity.
+    if (const auto directory = SKSE::log::log_directory()) {
+      const auto path = *directory / "undead_trinity.json";
+      if (Trace::Write(path)) {
+        UT_PRINT("UT: Trace written to %s", path.string().data());
+      } else {
+        UT_PRINT("UT: Could not write trace to %s", path.string().data());
+      }
+    }
+#endif
+
     return RE::BSEventNotifyControl::kStop;
   }
 
   RE::BSEventNotifyControl OnEquip() noexcept
   {
+    const Trace::Scope trace{ "Manager::OnEquip" };
+
     // Get user interface.
     const auto ui = RE::UI::GetSingleton();
     if (!ui) {
@@ -323,11 +768,13 @@ private:
       UT_TRACE("UT: Selected item has no object.");
       return RE::BSEventNotifyControl::kContinue;
     }
-    if (!info->extraLists || info->extraLists->empty()) {
+    RE::ExtraDataList* extra = nullptr;
+    if (info->extraLists && !info->extraLists->empty()) {
+      extra = info->extraLists->front();
+    } else if (info->IsWorn()) {
       UT_TRACE("UT: Selected item has no extra data lists.");
       return RE::BSEventNotifyControl::kContinue;
     }
-    auto extra = info->extraLists->front();
 
     // Get target actor.
     auto actor = target->As<RE::Actor>();
@@ -339,8 +786,10 @@ private:
     // Try to equip item.
     if (info->IsWorn()) {
       Game::Unequip(id, actor, object, extra);
-    } else if (Game::CanEquip(id, object)) {
-      Game::Equip(id, actor, object);
+    } else if (const auto trinity = Find(id, actor)) {
+      if (const auto item = Game::GetItem(object); trinity->CanEquip(item)) {
+        trinity->EquipItem(item, Game::UpdateContainerMenu);
+      }
     }
     return RE::BSEventNotifyControl::kStop;
   }
@@ -371,37 +820,96 @@ private:
       return RE::BSEventNotifyControl::kContinue;
     }
     UT_TRACE("UT: [%s] HITE %08X %4.2f", Game::GetName(id), source, Game::GetHealth(actor));
+
+    // Sample health of the player and trinity members.
+    const auto time = Health::Now();
+    if (actor == Game::Player) {
+      player_.Sample(time, Game::GetHealth(actor));
+      Capture(time, Triage::Target::Player, player_.GetValue(), source);
+    } else if (const auto trinity = Find(id, actor)) {
+      trinity->Sample(time);
+      Capture(time, GetTarget(id), trinity->GetHealth().GetValue(), source);
+    }
     return RE::BSEventNotifyControl::kContinue;
   }
 
-  void Add(RE::Actor* actor) noexcept
+  static Triage::Target GetTarget(RE::FormID id) noexcept
+  {
+    if (id == Game::Guard) {
+      return Triage::Target::Guard;
+    }
+    if (id == Game::Knight) {
+      return Triage::Target::Knight;
+    }
+    if (id == Game::Warlock) {
+      return Triage::Target::Warlock;
+    }
+    return Triage::Target::None;
+  }
+
+  std::shared_ptr<Trinity> Find(RE::FormID id, RE::Actor* actor) const noexcept
+  {
+    std::shared_ptr<Trinity> trinity;
+    if (const auto roster = roster_.Read(); id == Game::Guard) {
+      trinity = roster->guard;
+    } else if (id == Game::Knight) {
+      trinity = roster->knight;
+    } else if (id == Game::Warlock) {
+      trinity = roster->warlock;
+    }
+    if (trinity && Game::GetActor(*trinity) != actor) {
+      trinity.reset();
+    }
+    return trinity;
+  }
+
+  void Add(RE::Actor* actor, std::optional<RE::FormID> package = std::nullopt) noexcept
   {
-    if (!actor || actor->IsDead()) {
+    const Trace::Scope trace{ "Manager::Add" };
+    const auto trinity = Game::MakeTrinity(actor);
+    if (!trinity) {
       return;
     }
-    auto trinity = std::make_shared<Trinity>(actor);
-    if (trinity->IsGuard()) {
-      if (const auto guard = guard_; guard && guard->GetFormID() == trinity->GetFormID()) {
-        return;
+    auto added = false;
+    roster_.Write([&](Roster& roster) {
+      auto& member = roster.Get(trinity->GetClass());
+      if (!member || member->GetFormID() != trinity->GetFormID()) {
+        member = trinity;
+        added = true;
       }
-      guard_ = trinity;
-    } else if (trinity->IsKnight()) {
-      if (const auto knight = knight_; knight && knight->GetFormID() == trinity->GetFormID()) {
-        return;
-      }
-      knight_ = trinity;
-    } else if (trinity->IsWarlock()) {
-      if (const auto warlock = warlock_; warlock && warlock->GetFormID() == trinity->GetFormID()) {
-        return;
-      }
-      warlock_ = trinity;
-    } else {
+    });
+    if (!added) {
       return;
     }
-    trinity->Initialize();
+    if (package) {
+      trinity->Restore(*package);
+    } else {
+      trinity->Initialize();
+    }
+    Game::Initialize(trinity->GetClass(), actor);
+    Track(actor->GetFormID(), Tracker::Kind::Actor);
     UT_TRACE("UT: [%s] %08X Added to actors list.", Game::GetName(trinity->GetClass()), actor->GetFormID());
   }
 
+  // Prepares a summoned actor in one call before its 3D is loaded and adds it.
+  void Materialize(
+    RE::Actor* actor,
+    RE::Actor* summoner,
+    std::int32_t trinity,
+    RE::TESObjectREFR* armor,
+    RE::TESObjectREFR* inventory,
+    RE::TESRace* race,
+    RE::TESPackage* follow) noexcept
+  {
+    const auto id = GetClass(trinity);
+    if (!actor || actor->IsDead() || !id) {
+      return;
+    }
+    const Trace::Scope trace{ "Manager::Materialize" };
+    Game::Materialize(id, actor, summoner, trinity, armor, inventory, race, follow);
+    Add(actor);
+  }
+
   void Remove(RE::Actor* actor) noexcept
   {
     if (!actor) {
@@ -412,72 +920,697 @@ private:
       return;
     }
     const auto id = base->GetFormID();
-    if (id == Game::Guard) {
-      if (guard_ && guard_->GetFormID() == actor->GetFormID()) {
-        guard_.reset();
+    if (id != Game::Guard && id != Game::Knight && id != Game::Warlock) {
+      return;
+    }
+    roster_.Write([&](Roster& roster) {
+      if (auto& member = roster.Get(id); member && member->GetFormID() == actor->GetFormID()) {
+        member.reset();
         UT_TRACE("UT: [%s] %08X Removed from actors list.", Game::GetName(id), actor->GetFormID());
       }
-    } else if (id == Game::Knight) {
-      if (knight_ && knight_->GetFormID() == actor->GetFormID()) {
-        knight_.reset();
-        UT_TRACE("UT: [%s] %08X Removed from actors list.", Game::GetName(id), actor->GetFormID());
+    });
+  }
+
+  // Converts the trinity index used by scripts to the class form id.
+  static RE::FormID GetClass(std::int32_t trinity) noexcept
+  {
+    switch (trinity) {
+    case 1:
+      return Game::Guard;
+    case 2:
+      return Game::Knight;
+    case 3:
+      return Game::Warlock;
+    }
+    return 0;
+  }
+
+  static std::size_t GetPoolIndex(RE::FormID id) noexcept
+  {
+    if (id == Game::Guard) {
+      return 0;
+    }
+    if (id == Game::Knight) {
+      return 1;
+    }
+    if (id == Game::Warlock) {
+      return 2;
+    }
+    return Pool;
+  }
+
+  RE::Actor* Get(RE::FormID id) noexcept
+  {
+    if (GetPoolIndex(id) == Pool) {
+      return nullptr;
+    }
+    const auto roster = roster_.Read();
+    const auto& trinity = roster->Get(id);
+    return trinity ? Game::GetActor(*trinity) : nullptr;
+  }
+
+  // Returns the guard, knight and warlock or nullptr for missing members.
+  std::vector<RE::Actor*> GetActors() noexcept
+  {
+    std::vector<RE::Actor*> actors;
+    const auto roster = roster_.Read();
+    for (auto trinity = 1; trinity <= 3; trinity++) {
+      const auto& member = roster->Get(GetClass(trinity));
+      actors.push_back(member ? Game::GetActor(*member) : nullptr);
+    }
+    return actors;
+  }
+
+  // Returns the health ratio and position of the guard, knight and warlock as four values per member.
+  // Missing members have a health ratio of -1.
+  std::vector<float> GetStates() noexcept
+  {
+    std::vector<float> states;
+    const auto roster = roster_.Read();
+    for (auto trinity = 1; trinity <= 3; trinity++) {
+      const auto& member = roster->Get(GetClass(trinity));
+      if (!member) {
+        states.insert(states.end(), { -1.0f, 0.0f, 0.0f, 0.0f });
+        continue;
       }
-    } else if (id == Game::Warlock) {
-      if (warlock_ && warlock_->GetFormID() == actor->GetFormID()) {
-        warlock_.reset();
-        UT_TRACE("UT: [%s] %08X Removed from actors list.", Game::GetName(id), actor->GetFormID());
+      const auto position = member->GetPosition();
+      states.insert(states.end(), { Game::GetHealth(Game::GetActor(*member)), position.x, position.y, position.z });
+    }
+    return states;
+  }
+
+  // Moves summoned members to their spawn locations, revives parked members and casts the summon spell
+  // of every other member the actor can summon. The spells are ordered by trinity index. Called on a
+  // script thread, the members are moved and summoned in a task on the main thread.
+  void Summon(RE::Actor* actor, std::span<RE::SpellItem* const> spells) noexcept
+  {
+    if (!actor) {
+      return;
+    }
+    const auto tasks = SKSE::GetTaskInterface();
+    if (!tasks) {
+      UT_PRINT("UT: Could not get task interface.");
+      return;
+    }
+    tasks->AddTask([this, handle = actor->GetHandle(), spells = std::vector(spells.begin(), spells.end())]() {
+      SummonMembers(handle, spells);
+    });
+  }
+
+  // Revived members are not commanded actors, because the engine can not tie an existing actor to a new
+  // summon effect. They do not take one of the summon slots of the engine and are not in the commanded
+  // actors of the player. They still count against the number of members the actor can summon, are added
+  // on load with the other high process actors, and expire after the duration of their summon spell.
+  void SummonMembers(RE::ActorHandle handle, std::span<RE::SpellItem* const> spells) noexcept
+  {
+    const auto actor = handle.get();
+    if (!actor) {
+      return;
+    }
+    const Trace::Scope trace{ "Manager::Summon" };
+    const auto count = Game::GetCount(actor.get());
+    const auto caster = actor->GetMagicCaster(RE::MagicSystem::CastingSource::kInstant);
+    for (auto trinity = 1; trinity <= 3; trinity++) {
+      const auto id = GetClass(trinity);
+      if (const auto member = Get(id)) {
+        Game::MoveToSpawn(member, actor.get(), trinity);
+        continue;
+      }
+      if (trinity > count) {
+        continue;
+      }
+      const auto index = static_cast<std::size_t>(trinity - 1);
+      const auto spell = index < spells.size() ? spells[index] : nullptr;
+      if (const auto parked = Unpark(id)) {
+        Game::MoveToSpawn(parked, actor.get(), trinity);
+        parked->Resurrect(false, true);
+        parked->Enable(false);
+        Game::TakeItems(parked, trinity);
+        Add(parked);
+        SetExpiration(index, spell ? Game::GetDuration(spell) : 0.0);
+        continue;
+      }
+      if (caster && spell) {
+        caster->CastSpellImmediate(spell, false, nullptr, 1.0f, false, 0.0f, nullptr);
       }
     }
   }
 
-  void Update() noexcept
+  // Sets the number of seconds after which a revived member is killed like an expired summon.
+  // Members revived with a duration of zero never expire.
+  void SetExpiration(std::size_t index, double duration) noexcept
   {
-    if (const auto warlock = warlock_) {
-      warlock->SetCombatPackage(GetCombatPackage(warlock->GetActor()));
+    std::lock_guard lock{ pool_mutex_ };
+    expires_[index] = duration > 0.0 ? Health::Now() + duration : 0.0;
+  }
+
+  // Kills revived members whose summon duration has passed. Their death parks them again.
+  void Expire(double time, const Roster& roster) noexcept
+  {
+    std::array<RE::Actor*, Pool> expired{};
+    {
+      std::lock_guard lock{ pool_mutex_ };
+      for (std::size_t i = 0; i < Pool; i++) {
+        if (expires_[i] > 0.0 && time >= expires_[i]) {
+          const auto& member = roster.Get(GetClass(static_cast<std::int32_t>(i + 1)));
+          expired[i] = member ? Game::GetActor(*member) : nullptr;
+          expires_[i] = 0.0;
+        }
+      }
+    }
+    for (const auto actor : expired) {
+      if (actor && !actor->IsDead()) {
+        UT_TRACE("UT: %08X Summon duration expired.", actor->GetFormID());
+        actor->KillImmediate();
+      }
     }
   }
 
-  RE::TESPackage* GetCombatPackage(RE::Actor* warlock) noexcept
+  // Keeps a dead member for the next summon. Its items are moved to the containers before it is parked,
+  // so that they are not lost when the engine deletes the actor.
+  bool Park(RE::Actor* actor) noexcept
   {
-    if (!warlock || warlock->IsDead()) {
+    const auto base = actor ? actor->GetActorBase() : nullptr;
+    const auto index = base ? GetPoolIndex(base->GetFormID()) : Pool;
+    if (index == Pool) {
+      return false;
+    }
+    std::lock_guard lock{ pool_mutex_ };
+    if (const auto parked = pool_[index].get(); parked && parked.get() != actor) {
+      return false;
+    }
+    pool_[index] = actor->GetHandle();
+    expires_[index] = 0.0;
+    UT_TRACE("UT: [%s] %08X Parked.", Game::GetName(base->GetFormID()), actor->GetFormID());
+    return true;
+  }
+
+  // Returns a parked member and removes it from the pool.
+  RE::Actor* Unpark(RE::FormID id) noexcept
+  {
+    const auto index = GetPoolIndex(id);
+    if (index == Pool) {
       return nullptr;
     }
-    auto playerMin = 1.0f;
-    auto warlockMin = 1.0f;
-    auto knightMin = 1.0f;
-    auto guardMin = 1.0f;
-    if (Game::Player->IsInCombat()) {
-      playerMin = 0.9f;
-      warlockMin = 0.9f;
-      knightMin = 0.75f;
-      guardMin = 0.6f;
-    }
-    if (!Game::Player->IsDead() && Game::GetHealth(Game::Player) < playerMin) {
-      return Game::Heal;
+    std::lock_guard lock{ pool_mutex_ };
+    const auto actor = pool_[index].get();
+    if (!actor) {
+      if (pool_[index]) {
+        UT_TRACE("UT: [%s] Parked actor is gone, summoning a new one.", Game::GetName(id));
+      }
+      pool_[index] = {};
+      return nullptr;
     }
-    if (Game::GetHealth(warlock) < warlockMin) {
-      return Game::HealSelf;
+    pool_[index] = {};
+    UT_TRACE("UT: [%s] %08X Unparked.", Game::GetName(id), actor->GetFormID());
+    return actor.get();
+  }
+
+  // Shows summon visuals at the spawn locations and at the current position of summoned members.
+  void ShowVisuals(RE::Actor* actor, RE::TESForm* form) noexcept
+  {
+    const auto visual = form ? form->As<RE::TESBoundObject>() : nullptr;
+    if (!actor || !visual) {
+      return;
     }
-    const auto pos = warlock->GetPosition();
-    if (const auto knight = knight_) {
-      const auto health = Game::GetHealth(knight->GetActor());
-      if (!knight->IsDead() && health > 0.1f && health < knightMin && pos.GetDistance(knight->GetPosition()) < 900.0f) {
-        return Game::HealKnight;
+
+    // Take positions now, the script moves members right after this call.
+    std::vector<RE::NiPoint3> positions;
+    const auto count = Game::GetCount(actor);
+    const auto roster = roster_.Read();
+    for (auto trinity = 1; trinity <= 3; trinity++) {
+      const auto& member = roster->Get(GetClass(trinity));
+      if (member) {
+        positions.push_back(Game::GetActor(*member)->GetPosition());
+      }
+      if (member || trinity <= count) {
+        positions.push_back(actor->GetPosition() + Game::GetSpawnOffset(actor, trinity));
+      }
+    }
+
+    const auto tasks = SKSE::GetTaskInterface();
+    if (!tasks) {
+      UT_PRINT("UT: Could not get task interface.");
+      return;
+    }
+    tasks->AddTask([this, handle = actor->GetHandle(), visual, positions = std::move(positions)]() {
+      PlaceVisuals(handle, visual, positions);
+    });
+  }
+
+  void PlaceVisuals(RE::ActorHandle handle, RE::TESBoundObject* visual, std::span<const RE::NiPoint3> positions) noexcept
+  {
+    const Trace::Scope trace{ "Manager::PlaceVisuals" };
+    const auto actor = handle.get();
+    if (!actor) {
+      return;
+    }
+    std::lock_guard lock{ visuals_mutex_ };
+    std::erase_if(visuals_, [](const RE::ObjectRefHandle& e) { return !e.get(); });
+    for (std::size_t i = 0; i < positions.size(); i++) {
+      RE::NiPointer<RE::TESObjectREFR> reference;
+      if (i < visuals_.size()) {
+        reference = visuals_[i].get();
+        reference->MoveTo(actor.get());
+      } else {
+        reference = actor->PlaceObjectAtMe(visual, true);
+        if (!reference) {
+          UT_PRINT("UT: Could not place visual.");
+          return;
+        }
+        visuals_.push_back(reference->GetHandle());
+        Track(reference->GetFormID(), Tracker::Kind::Visual);
+      }
+      reference->SetPosition(positions[i]);
+      reference->Enable(false);
+    }
+  }
+
+  void HideVisuals() noexcept
+  {
+    const auto tasks = SKSE::GetTaskInterface();
+    if (!tasks) {
+      UT_PRINT("UT: Could not get task interface.");
+      return;
+    }
+    tasks->AddTask([this]() {
+      const Trace::Scope trace{ "Manager::HideVisuals" };
+      std::lock_guard lock{ visuals_mutex_ };
+      for (const auto& handle : visuals_) {
+        if (const auto reference = handle.get()) {
+          reference->Disable();
+        }
+      }
+    });
+  }
+
+  void Track(RE::FormID id, Tracker::Kind kind) noexcept
+  {
+    try {
+      std::lock_guard lock{ tracker_mutex_ };
+      tracker_.Track(id, kind);
+    }
+    catch (const std::exception& e) {
+      UT_PRINT("UT: %08X Could not track reference: %s", id, e.what());
+    }
+  }
+
+  void Update() noexcept
+  {
+    // Every trinity member requests an update on a script thread, but the party only needs
+    // to be evaluated once.
+    std::unique_lock lock{ updating_, std::try_to_lock };
+    const auto time = Health::Now();
+    if (!lock || time - update_ < UpdateInterval) {
+      return;
+    }
+    update_ = time;
+    roster_.Reclaim();
+    Game::Schedule(Scheduler::Priority::High, [this]() noexcept {
+      Sample();
+      return true;
+    });
+  }
+
+  void Sample() noexcept
+  {
+    const Trace::Scope trace{ "Manager::Sample" };
+    const auto time = Health::Now();
+    player_.Sample(time, Game::GetHealth(Game::Player));
+
+    Plan plan;
+    plan.generation = Game::GetGeneration();
+    plan.time = time;
+    plan.combat = Game::Player->IsInCombat();
+    plan.members[0] = {
+      Game::Player->GetFormID(),
+      true,
+      Game::Player->IsDead(),
+      player_.GetValue(),
+      player_.GetRate(),
+      Game::Player->GetPosition(),
+    };
+
+    const auto roster = roster_.Read();
+    Expire(time, *roster);
+    const std::array members{ &roster->guard, &roster->knight, &roster->warlock };
+    for (std::size_t i = 0; i < members.size(); i++) {
+      if (const auto& trinity = *members[i]) {
+        trinity->Sample(time);
+        const auto& health = trinity->GetHealth();
+        plan.members[i + 1] = {
+          trinity->GetFormID(),
+          true,
+          trinity->IsDead(),
+          health.GetValue(),
+          health.GetRate(),
+          Game::GetActor(*trinity)->GetPosition(),
+        };
+      }
+    }
+    SampleAllies(time, *roster, plan);
+    if (!planner_.Push(plan)) {
+      UT_TRACE("UT: Planner is busy.");
+    }
+  }
+
+  // Ranks friendly actors near the warlock that fight with the player, are not trinity members and can be
+  // healed by a heal spell. Only the ally that needs healing the most is passed to the planner.
+  void SampleAllies(double time, const Roster& roster, Plan& plan) noexcept
+  {
+    const auto processes = RE::ProcessLists::GetSingleton();
+    const auto warlock = roster.warlock ? Game::GetActor(*roster.warlock) : nullptr;
+    if (!plan.combat || !processes || !warlock || warlock->IsDead()) {
+      allies_.Clear();
+      ally_health_.clear();
+      return;
+    }
+    const std::array members{ roster.guard.get(), roster.knight.get(), roster.warlock.get() };
+    const auto position = warlock->GetPosition();
+    for (const auto& handle : processes->highActorHandles) {
+      const auto actor = handle.get();
+      if (!actor || actor->IsDead() || !IsAlly(actor.get())) {
+        continue;
+      }
+      const auto member = std::ranges::any_of(members, [&](const Trinity* trinity) noexcept {
+        return trinity && Game::GetActor(*trinity) == actor.get();
+      });
+      if (member || !Game::GetHealSpell(warlock, actor.get())) {
+        continue;
       }
+      const auto id = actor->GetFormID();
+      auto& health = ally_health_[id];
+      health.time = time;
+      health.estimator.Sample(time, Game::GetHealth(actor.get()));
+      const auto distance = position.GetDistance(actor->GetPosition());
+      allies_.Update(id, { true, false, health.estimator.GetValue(), health.estimator.GetRate(), distance });
     }
-    if (const auto guard = guard_) {
-      const auto health = Game::GetHealth(guard->GetActor());
-      if (!guard->IsDead() && health > 0.1f && health < guardMin && pos.GetDistance(guard->GetPosition()) < 900.0f) {
-        return Game::HealGuard;
+    allies_.Prune();
+    std::erase_if(ally_health_, [&](const auto& entry) noexcept {
+      return entry.second.time != time;
+    });
+    if (const auto ally = allies_.Top()) {
+      if (const auto actor = RE::TESForm::LookupByID<RE::Actor>(ally->id)) {
+        plan.ally = {
+          ally->id,
+          true,
+          false,
+          ally->member.health,
+          ally->member.rate,
+          actor->GetPosition(),
+        };
       }
     }
+  }
+
+  // Returns true for followers and actors commanded by the player.
+  static bool IsAlly(RE::Actor* actor) noexcept
+  {
+    if (actor->IsPlayerTeammate()) {
+      return true;
+    }
+    return actor->IsCommandedActor() && actor->GetCommandingActor().get().get() == Game::Player;
+  }
+
+  // Reads the models of the trinity members on the prewarm thread after a game was loaded or started,
+  // so that the first 3D load of summoned actors finds them in the file cache instead of waiting for
+  // the disk.
+  void Prewarm() noexcept
+  {
+    auto models = Game::GetModels();
+    if (!models.empty() && !prewarmer_.Push(std::move(models))) {
+      UT_TRACE("UT: Too many pending prewarm requests.");
+    }
+  }
+
+  // Called on the prewarm thread. Returns the number of bytes read.
+  static std::size_t Read(const std::vector<std::string>& models)
+  {
+    const Trace::Scope trace{ "Manager::Prewarm" };
+    std::size_t size = 0;
+    std::vector<char> buffer(PrewarmBuffer);
+    for (const auto& model : models) {
+      RE::BSResourceNiBinaryStream stream{ model };
+      if (!stream.good()) {
+        continue;
+      }
+      while (const auto read = stream.DoRead(buffer.data(), static_cast<std::uint32_t>(buffer.size()))) {
+        size += read;
+      }
+    }
+    return size;
+  }
+
+  // Called on the planner thread.
+  static Decision Evaluate(const Plan& plan) noexcept
+  {
+    const std::array classes{ Game::Guard, Game::Knight, Game::Warlock };
+
+    Decision decision;
+    decision.generation = plan.generation;
+    decision.time = plan.time;
+    for (std::size_t i = 0; i < classes.size(); i++) {
+      const auto& self = plan.members[i + 1];
+      if (!self.present || self.dead) {
+        continue;
+      }
+      decision.members[i] = self.id;
+
+      const auto input = [&](const Plan::Member& subject) noexcept -> Policy::Input {
+        if (!subject.present || subject.dead) {
+          return {};
+        }
+        return { true, subject.health, self.position.GetDistance(subject.position) };
+      };
+
+      std::array<Policy::Input, Policy::Subjects> inputs;
+      inputs[static_cast<std::size_t>(Policy::Subject::Player)] = input(plan.members[0]);
+      inputs[static_cast<std::size_t>(Policy::Subject::Self)] = input(self);
+      inputs[static_cast<std::size_t>(Policy::Subject::Guard)] = input(plan.members[1]);
+      inputs[static_cast<std::size_t>(Policy::Subject::Knight)] = input(plan.members[2]);
+      inputs[static_cast<std::size_t>(Policy::Subject::Warlock)] = input(plan.members[3]);
+
+      auto& package = decision.packages[i];
+      package = Game::GetPolicyPackage(classes[i], plan.combat, inputs);
+      if (!package && classes[i] == Game::Warlock) {
+        decision.triage = true;
+        decision.party = GetParty(plan);
+        decision.target = Triage::Select(decision.party);
+        decision.ally = plan.ally.present ? plan.ally.id : 0;
+        package = GetCombatPackage(decision.target);
+      }
+    }
+    return decision;
+  }
+
+  static Triage::Party GetParty(const Plan& plan) noexcept
+  {
+    const auto& player = plan.members[0];
+    const auto& warlock = plan.members[3];
+
+    Triage::Party party;
+    party.combat = plan.combat;
+    party.player = { true, player.dead, player.health, player.rate, 0.0f };
+
+    const auto member = [&](const Plan::Member& member) noexcept -> Triage::Member {
+      if (!member.present) {
+        return {};
+      }
+      const auto distance = warlock.position.GetDistance(member.position);
+      return { true, member.dead, member.health, member.rate, distance };
+    };
+    party.guard = member(plan.members[1]);
+    party.knight = member(plan.members[2]);
+    party.warlock = member(warlock);
+    party.ally = member(plan.ally);
+    return party;
+  }
+
+  static RE::TESPackage* GetCombatPackage(Triage::Target target) noexcept
+  {
+    switch (target) {
+    case Triage::Target::None:
+      break;
+    case Triage::Target::Player:
+      return Game::Heal;
+    case Triage::Target::Warlock:
+      return Game::HealSelf;
+    case Triage::Target::Knight:
+      return Game::HealKnight;
+    case Triage::Target::Guard:
+      return Game::HealGuard;
+    case Triage::Target::Ally:
+      break;
+    }
     return nullptr;
   }
 
+  void Apply() noexcept
+  {
+    const Trace::Scope trace{ "Manager::Apply" };
+    const auto roster = roster_.Read();
+    const std::array members{ &roster->guard, &roster->knight, &roster->warlock };
+
+    Decision decision;
+    while (planner_.Pop(decision)) {
+      if (decision.generation != Game::GetGeneration()) {
+        continue;
+      }
+      for (std::size_t i = 0; i < members.size(); i++) {
+        if (const auto& trinity = *members[i]; trinity && trinity->GetFormID() == decision.members[i]) {
+          const auto package = decision.packages[i];
+          trinity->SetCombatPackage(package ? package->GetFormID() : 0);
+        }
+      }
+      if (decision.target == Triage::Target::Ally) {
+        HealAlly(decision.time, roster->warlock.get(), decision.ally);
+      }
+      if (decision.triage) {
+        Capture(decision.time, *roster, decision);
+      }
+    }
+  }
+
+  // No heal package can target an ally, so the warlock casts a heal spell that can affect it directly.
+  // The interval only starts when the spell was cast.
+  void HealAlly(double time, Trinity* warlock, RE::FormID id) noexcept
+  {
+    if (!warlock || time - ally_heal_ < AllyHealInterval) {
+      return;
+    }
+    const auto actor = RE::TESForm::LookupByID<RE::Actor>(id);
+    const auto caster = Game::GetActor(*warlock);
+    if (!actor || actor->IsDead() || !caster || caster->IsDead()) {
+      return;
+    }
+    const auto spell = Game::GetHealSpell(caster, actor);
+    if (spell && Game::Cast(caster, spell, actor)) {
+      UT_TRACE("UT: [W] Heal ally %08X %4.2f", id, Game::GetHealth(actor));
+      ally_heal_ = time;
+    }
+  }
+
+  void Capture(double time, const Roster& roster, const Decision& decision) noexcept
+  {
+    if (!recorder_.IsOpen()) {
+      return;
+    }
+    const auto& party = decision.party;
+    Record::Frame frame;
+    frame.kind = Record::Kind::Update;
+    frame.time = time;
+    frame.combat = party.combat;
+    frame.target = decision.target;
+    const auto member = [&](Triage::Target index, const Triage::Member& state, const RE::NiPoint3& position) {
+      auto& e = frame.members[Record::GetIndex(index)];
+      e.present = state.present;
+      e.dead = state.dead;
+      e.health = state.health;
+      e.position = { position.x, position.y, position.z };
+    };
+    member(Triage::Target::Player, party.player, Game::Player->GetPosition());
+    if (const auto& warlock = roster.warlock) {
+      member(Triage::Target::Warlock, party.warlock, Game::GetActor(*warlock)->GetPosition());
+    }
+    if (const auto& knight = roster.knight) {
+      member(Triage::Target::Knight, party.knight, Game::GetActor(*knight)->GetPosition());
+    }
+    if (const auto& guard = roster.guard) {
+      member(Triage::Target::Guard, party.guard, Game::GetActor(*guard)->GetPosition());
+    }
+    if (const auto ally = decision.ally ? RE::TESForm::LookupByID<RE::Actor>(decision.ally) : nullptr) {
+      member(Triage::Target::Ally, party.ally, ally->GetPosition());
+      frame.members[Record::GetIndex(Triage::Target::Ally)].rate = party.ally.rate;
+    }
+    recorder_.Write(frame);
+  }
+
+  void Capture(double time, Triage::Target index, float health, RE::FormID source) noexcept
+  {
+    if (!recorder_.IsOpen() || index == Triage::Target::None) {
+      return;
+    }
+    Record::Frame frame;
+    frame.kind = Record::Kind::Hit;
+    frame.time = time;
+    frame.combat = Game::Player->IsInCombat();
+    frame.member = static_cast<std::uint8_t>(Record::GetIndex(index));
+    frame.source = source;
+    frame.members[frame.member].health = health;
+    recorder_.Write(frame);
+  }
+
+  static constexpr double UpdateInterval = 0.9;
+
+  // Minimum number of seconds between two heal spells cast at allies.
+  static constexpr double AllyHealInterval = 3.0;
+
+  static constexpr std::uint32_t Serialization = 'UTRN';
+  static constexpr std::uint32_t RosterRecord = 'ROST';
+  static constexpr std::uint32_t RosterVersion = 1;
+  static constexpr std::uint32_t PoolRecord = 'POOL';
+  static constexpr std::uint32_t PoolVersion = 2;
+  static constexpr std::uint32_t VisualsRecord = 'VISL';
+  static constexpr std::uint32_t VisualsVersion = 1;
+  static constexpr std::uint32_t TrackerRecord = 'TRAK';
+  static constexpr std::uint32_t TrackerVersion = 1;
+
+  // Number of orphaned references reclaimed per task.
+  static constexpr std::size_t ReclaimBudget = 8;
+
+  // Size of the buffer used to read models on the prewarm thread.
+  static constexpr std::size_t PrewarmBuffer = 0x10000;
+
+  // Number of parked members, one per class.
+  static constexpr std::size_t Pool = 3;
+
+  // Member read from the co-save.
+  struct Saved {
+    RE::FormID id{ 0 };
+    RE::FormID actor{ 0 };
+    RE::FormID package{ 0 };
+  };
+
   bool initialized_{ false };
-  std::shared_ptr<Trinity> guard_;
-  std::shared_ptr<Trinity> knight_;
-  std::shared_ptr<Trinity> warlock_;
+  std::mutex updating_;
+  double update_{ 0.0 };
+  Record::Writer recorder_;
+  Health player_;
+
+  // Health of the sampled allies. Used on the main thread.
+  struct Ally {
+    double time{ 0.0 };
+    Health estimator;
+  };
+
+  Allies allies_;
+  std::unordered_map<RE::FormID, Ally> ally_health_;
+  double ally_heal_{ 0.0 };
+  Snapshot<Roster> roster_;
+  std::vector<Saved> saved_;
+  bool restored_{ false };
+
+  std::mutex pool_mutex_;
+  std::array<RE::ActorHandle, Pool> pool_;
+
+  // Times when revived members expire or zero, indexed like the pool.
+  std::array<double, Pool> expires_{};
+
+  std::mutex visuals_mutex_;
+  std::vector<RE::ObjectRefHandle> visuals_;
+
+  std::mutex tracker_mutex_;
+  Tracker tracker_;
+
+  // Reads models off the main thread. Results are not used.
+  Worker<std::vector<std::string>, std::size_t, 4> prewarmer_{ Read, {} };
+
+  // Evaluates the party off the main thread and applies the decision in the next task.
+  Worker<Plan, Decision> planner_{ Evaluate, [this]() noexcept {
+    if (const auto tasks = SKSE::GetTaskInterface()) {
+      tasks->AddTask([this]() { Apply(); });
+    }
+  } };
 };
 
 }  // namespace UT
@@ -488,5 +1621,6 @@ SKSEPluginLoad(const SKSE::LoadInterface* skse)
   if (!SKSE::GetMessagingInterface()->RegisterListener(UT::Manager::Listener)) {
     return false;
   }
+  UT::Manager::Register(SKSE::GetSerializationInterface());
   return true;
 }
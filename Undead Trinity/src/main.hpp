@@ -4,8 +4,14 @@
 
 #include <boost/container/flat_map.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <format>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <numbers>
+#include <optional>
 #include <set>
 #include <span>
 #include <stdexcept>
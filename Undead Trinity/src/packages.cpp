@@ -0,0 +1,45 @@
+#include "packages.hpp"
+
+#include <trace.hpp>
+
+#include <array>
+#include <utility>
+
+namespace UT::Packages {
+namespace {
+
+constexpr Engine::Form GetPackage(std::uint32_t package) noexcept
+{
+  return { package, Engine::FormType::Package };
+}
+
+}  // namespace
+
+bool Add(
+  Engine::VM& vm,
+  Engine::Actor& actor,
+  std::uint32_t package,
+  std::int32_t priority,
+  bool force,
+  Engine::Callback callback)
+{
+  const Trace::Scope trace{ "AddPackageOverride" };
+  const std::array<Engine::Argument, 4> arguments{ &actor, GetPackage(package), priority, force ? 1 : 0 };
+  return vm.DispatchStaticCall("ActorUtil", "AddPackageOverride", arguments, std::move(callback));
+}
+
+bool Remove(Engine::VM& vm, Engine::Actor& actor, std::uint32_t package, Engine::Callback callback)
+{
+  const Trace::Scope trace{ "RemovePackageOverride" };
+  const std::array<Engine::Argument, 2> arguments{ &actor, GetPackage(package) };
+  return vm.DispatchStaticCall("ActorUtil", "RemovePackageOverride", arguments, std::move(callback));
+}
+
+bool Clear(Engine::VM& vm, Engine::Actor& actor, Engine::Callback callback)
+{
+  const Trace::Scope trace{ "ClearPackageOverride" };
+  const std::array<Engine::Argument, 1> arguments{ &actor };
+  return vm.DispatchStaticCall("ActorUtil", "ClearPackageOverride", arguments, std::move(callback));
+}
+
+}  // namespace UT::Packages
@@ -0,0 +1,24 @@
+#pragma once
+#include <engine.hpp>
+
+#include <cstdint>
+
+namespace UT::Packages {
+
+// Package overrides of the ActorUtil script from PapyrusUtil.
+// All functions return false if the call could not be dispatched and the callback is not called.
+
+// Adds a package override. Forced overrides are evaluated before packages of the same priority.
+bool Add(
+  Engine::VM& vm,
+  Engine::Actor& actor,
+  std::uint32_t package,
+  std::int32_t priority = 30,
+  bool force = false,
+  Engine::Callback callback = {});
+
+bool Remove(Engine::VM& vm, Engine::Actor& actor, std::uint32_t package, Engine::Callback callback = {});
+
+bool Clear(Engine::VM& vm, Engine::Actor& actor, Engine::Callback callback = {});
+
+}  // namespace UT::Packages
@@ -0,0 +1,210 @@
+#include "policy.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace UT::Policy {
+namespace {
+
+constexpr std::string_view Whitespace{ " \t\r" };
+
+std::string_view Trim(std::string_view text) noexcept
+{
+  const auto first = text.find_first_not_of(Whitespace);
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  return text.substr(first, text.find_last_not_of(Whitespace) - first + 1);
+}
+
+std::string_view Next(std::string_view& text) noexcept
+{
+  text = Trim(text);
+  const auto end = std::min(text.find_first_of(Whitespace), text.size());
+  const auto token = text.substr(0, end);
+  text.remove_prefix(end);
+  return token;
+}
+
+[[noreturn]] void Fail(std::size_t line, std::string_view message, std::string_view token)
+{
+  throw std::runtime_error(
+    "Invalid rule on line " + std::to_string(line) + ": " + std::string{ message } + ": '" + std::string{ token } + "'");
+}
+
+template <class T>
+T ParseEnum(std::size_t line, std::string_view token, std::string_view message)
+{
+  constexpr auto size = std::is_same_v<T, Class> ? Classes : Subjects;
+  for (std::size_t i = 0; i < size; i++) {
+    if (token == GetName(static_cast<T>(i))) {
+      return static_cast<T>(i);
+    }
+  }
+  Fail(line, message, token);
+}
+
+float ParseFloat(std::size_t line, std::string_view token, std::string_view message)
+{
+  auto value = 0.0f;
+  const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (ec != std::errc{} || end != token.data() + token.size() || !(value >= 0.0f)) {
+    Fail(line, message, token);
+  }
+  return value;
+}
+
+}  // namespace
+
+std::vector<Rule> Parse(std::string_view text)
+{
+  std::vector<Rule> rules;
+  for (std::size_t line = 1; !text.empty(); line++) {
+    const auto end = std::min(text.find('\n'), text.size());
+    auto entry = text.substr(0, end);
+    text.remove_prefix(std::min(end + 1, text.size()));
+    entry = Trim(entry.substr(0, std::min(entry.find('#'), entry.size())));
+    if (entry.empty()) {
+      continue;
+    }
+
+    Rule rule;
+    rule.line = line;
+    rule.member = ParseEnum<Class>(line, Next(entry), "Unknown class");
+    rule.subject = ParseEnum<Subject>(line, Next(entry), "Unknown subject");
+
+    if (const auto state = Next(entry); state == "combat") {
+      rule.peace = false;
+    } else if (state == "peace") {
+      rule.combat = false;
+    } else if (state != "any") {
+      Fail(line, "Unknown state", state);
+    }
+
+    const auto min = Next(entry);
+    const auto max = Next(entry);
+    rule.min = ParseFloat(line, min, "Invalid min health");
+    rule.max = ParseFloat(line, max, "Invalid max health");
+    if (rule.min >= rule.max) {
+      Fail(line, "Empty health range", max);
+    }
+
+    if (const auto distance = Next(entry); distance != "-") {
+      rule.distance = ParseFloat(line, distance, "Invalid distance");
+      if (rule.distance <= 0.0f) {
+        Fail(line, "Invalid distance", distance);
+      }
+    }
+
+    const auto form = Next(entry);
+    auto digits = form;
+    if (digits.starts_with("0x") || digits.starts_with("0X")) {
+      digits.remove_prefix(2);
+    }
+    const auto [last, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), rule.form, 16);
+    if (digits.empty() || ec != std::errc{} || last != digits.data() + digits.size() || rule.form > 0xFFFFFF) {
+      Fail(line, "Invalid form id", form);
+    }
+
+    rule.plugin = Trim(entry);
+    if (rule.plugin.empty()) {
+      Fail(line, "Missing plugin", entry);
+    }
+    rules.push_back(std::move(rule));
+  }
+  return rules;
+}
+
+Table::Table() noexcept
+{
+  health_.fill(std::numeric_limits<float>::infinity());
+  distance_.fill(std::numeric_limits<float>::infinity());
+  table_.fill(Empty);
+}
+
+Table::Table(Class member, std::span<const Rule> rules) :
+  Table()
+{
+  // Collect the rules and limits for this class.
+  std::vector<float> health;
+  std::vector<float> distance;
+  for (std::size_t i = 0; i < rules.size(); i++) {
+    const auto& rule = rules[i];
+    if (rule.member != member) {
+      continue;
+    }
+    rules_.push_back(i);
+    health.push_back(rule.min);
+    health.push_back(rule.max);
+    if (rule.distance > 0.0f) {
+      distance.push_back(rule.distance);
+    }
+  }
+  for (auto* limits : { &health, &distance }) {
+    std::sort(limits->begin(), limits->end());
+    limits->erase(std::unique(limits->begin(), limits->end()), limits->end());
+  }
+  if (rules_.size() > Rules) {
+    throw std::runtime_error(std::string{ "Too many rules for " } + GetName(member));
+  }
+  if (health.size() > Limits || distance.size() > Limits) {
+    throw std::runtime_error(std::string{ "Too many distinct health or distance limits for " } + GetName(member));
+  }
+  std::copy(health.begin(), health.end(), health_.begin());
+  std::copy(distance.begin(), distance.end(), distance_.begin());
+
+  // Store the first matching rule for every bucket. Every bucket starts at a limit or zero,
+  // so testing the rule against the first value of the bucket is exact.
+  for (std::size_t s = 0; s < Subjects; s++) {
+    for (std::size_t c = 0; c < 2; c++) {
+      for (std::size_t h = 0; h < Buckets; h++) {
+        for (std::size_t d = 0; d < Buckets; d++) {
+          const auto hv = h ? health_[h - 1] : 0.0f;
+          const auto dv = d ? distance_[d - 1] : 0.0f;
+          if (std::isinf(hv) || std::isinf(dv)) {
+            continue;
+          }
+          for (std::size_t r = 0; r < rules_.size(); r++) {
+            const auto& rule = rules[rules_[r]];
+            if (static_cast<std::size_t>(rule.subject) != s || !(c ? rule.combat : rule.peace)) {
+              continue;
+            }
+            if (hv < rule.min || hv >= rule.max || (rule.distance > 0.0f && dv >= rule.distance)) {
+              continue;
+            }
+            table_[((s * 2 + c) * Buckets + h) * Buckets + d] = static_cast<std::uint8_t>(r);
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+std::size_t Table::Evaluate(bool combat, std::span<const Input, Subjects> inputs) const noexcept
+{
+  std::uint8_t rule = Empty;
+  for (std::size_t s = 0; s < Subjects; s++) {
+    const auto& input = inputs[s];
+    const auto h = GetBucket(health_, input.health);
+    const auto d = GetBucket(distance_, input.distance);
+    const auto value = table_[((s * 2 + (combat ? 1 : 0)) * Buckets + h) * Buckets + d];
+    rule = std::min(rule, input.present ? value : Empty);
+  }
+  return rule == Empty ? None : rules_[rule];
+}
+
+std::size_t Table::GetBucket(const std::array<float, Limits>& limits, float value) noexcept
+{
+  std::size_t bucket = 0;
+  for (const auto limit : limits) {
+    bucket += value >= limit ? 1 : 0;
+  }
+  return bucket;
+}
+
+}  // namespace UT::Policy
@@ -0,0 +1,132 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace UT::Policy {
+
+// Rules are read line by line, empty lines and text after '#' are ignored:
+//
+//   <class> <subject> <state> <min health> <max health> <max distance> <form id> <plugin>
+//
+// class     guard, knight or warlock
+// subject   player, self, guard, knight or warlock
+// state     combat, peace or any
+// health    subject health ratio range (min <= health < max)
+// distance  maximum distance between the member and the subject or '-'
+// form id   package form id without the load order index
+// plugin    plugin file name that contains the package
+//
+// The first rule that matches any subject selects the package.
+enum class Class : std::uint8_t {
+  Guard,
+  Knight,
+  Warlock,
+};
+
+enum class Subject : std::uint8_t {
+  Player,
+  Self,
+  Guard,
+  Knight,
+  Warlock,
+};
+
+constexpr std::size_t Classes = 3;
+constexpr std::size_t Subjects = 5;
+
+// Maximum number of distinct health and distance limits per class.
+constexpr std::size_t Limits = 15;
+
+// Maximum number of rules per class.
+constexpr std::size_t Rules = 255;
+
+// Returned when no rule matches.
+constexpr std::size_t None = static_cast<std::size_t>(-1);
+
+struct Rule {
+  Class member{ Class::Guard };
+  Subject subject{ Subject::Self };
+  bool peace{ true };
+  bool combat{ true };
+  float min{ 0.0f };
+  float max{ 1.0f };
+  float distance{ 0.0f };  // zero if unlimited
+  std::uint32_t form{ 0 };
+  std::string plugin;
+  std::size_t line{ 0 };  // line in the rules file
+};
+
+struct Input {
+  bool present{ false };
+  float health{ 1.0f };
+  float distance{ 0.0f };
+};
+
+// Parses rules and throws std::runtime_error with the line number on errors.
+std::vector<Rule> Parse(std::string_view text);
+
+// Decision table for the rules of one class.
+class Table {
+public:
+  Table() noexcept;
+
+  // Compiles all rules for the given class and throws std::runtime_error if there are too many.
+  explicit Table(Class member, std::span<const Rule> rules);
+
+  // Returns the index of the first matching rule or None.
+  std::size_t Evaluate(bool combat, std::span<const Input, Subjects> inputs) const noexcept;
+
+  // Returns the indices of the compiled rules in the span passed to the constructor.
+  const std::vector<std::size_t>& GetRules() const noexcept
+  {
+    return rules_;
+  }
+
+private:
+  static constexpr std::size_t Buckets = Limits + 1;
+  static constexpr std::uint8_t Empty = 0xFF;
+
+  static std::size_t GetBucket(const std::array<float, Limits>& limits, float value) noexcept;
+
+  std::array<float, Limits> health_;
+  std::array<float, Limits> distance_;
+  std::array<std::uint8_t, Subjects * 2 * Buckets * Buckets> table_;
+  std::vector<std::size_t> rules_;
+};
+
+constexpr const char* GetName(Class member) noexcept
+{
+  switch (member) {
+  case Class::Guard:
+    return "guard";
+  case Class::Knight:
+    return "knight";
+  case Class::Warlock:
+    return "warlock";
+  }
+  return "unknown";
+}
+
+constexpr const char* GetName(Subject subject) noexcept
+{
+  switch (subject) {
+  case Subject::Player:
+    return "player";
+  case Subject::Self:
+    return "self";
+  case Subject::Guard:
+    return "guard";
+  case Subject::Knight:
+    return "knight";
+  case Subject::Warlock:
+    return "warlock";
+  }
+  return "unknown";
+}
+
+}  // namespace UT::Policy
@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace UT {
+
+// Lock-free queue with a single producer thread and a single consumer thread.
+template <class T, std::size_t Capacity>
+class Queue {
+public:
+  static_assert(std::has_single_bit(Capacity), "Capacity must be a power of two.");
+
+  // Called by the producer. Returns false when the queue is full.
+  bool Push(T value) noexcept(std::is_nothrow_move_assignable_v<T>)
+  {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    items_[head % Capacity] = std::move(value);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the consumer. Returns false when the queue is empty.
+  bool Pop(T& value) noexcept(std::is_nothrow_move_assignable_v<T>)
+  {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(items_[tail % Capacity]);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  static constexpr std::size_t Alignment = 64;
+
+  alignas(Alignment) std::atomic_size_t head_{ 0 };
+  alignas(Alignment) std::atomic_size_t tail_{ 0 };
+  std::array<T, Capacity> items_{};
+};
+
+}  // namespace UT
@@ -0,0 +1,330 @@
+#include "record.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace UT::Record {
+namespace {
+
+constexpr std::size_t BufferSize = 64 * 1024;
+
+// Health and rates are stored in steps of 1/65535. Rates are limited, so that they fit the state.
+constexpr float Scale = 65535.0f;
+constexpr float Rate = 1000.0f;
+
+void Put(std::vector<std::uint8_t>& buffer, std::uint64_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+void Put(std::vector<std::uint8_t>& buffer, std::int64_t value)
+{
+  Put(buffer, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void Put(std::vector<std::uint8_t>& buffer, std::uint32_t value, std::size_t size)
+{
+  for (std::size_t i = 0; i < size; i++) {
+    buffer.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+  }
+}
+
+State Encode(const Member& member) noexcept
+{
+  State state;
+  state.present = member.present;
+  state.dead = member.dead;
+  state.health = static_cast<std::int32_t>(std::lround(std::clamp(member.health, 0.0f, 1.0f) * Scale));
+  state.rate = static_cast<std::int32_t>(std::lround(std::clamp(member.rate, -Rate, Rate) * Scale));
+  for (std::size_t i = 0; i < 3; i++) {
+    state.position[i] = static_cast<std::int32_t>(std::lround(member.position[i]));
+  }
+  return state;
+}
+
+Member Decode(const State& state) noexcept
+{
+  Member member;
+  member.present = state.present;
+  member.dead = state.dead;
+  member.health = static_cast<float>(state.health) / Scale;
+  member.rate = static_cast<float>(state.rate) / Scale;
+  for (std::size_t i = 0; i < 3; i++) {
+    member.position[i] = static_cast<float>(state.position[i]);
+  }
+  return member;
+}
+
+}  // namespace
+
+Writer::~Writer()
+{
+  Close();
+}
+
+bool Writer::Open(const std::filesystem::path& path) noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  if (file_.is_open()) {
+    return false;
+  }
+  try {
+    buffer_.clear();
+    buffer_.reserve(BufferSize);
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+      return false;
+    }
+    Put(buffer_, Magic, 4);
+    Put(buffer_, Version, 4);
+  }
+  catch (...) {
+    file_.close();
+    return false;
+  }
+  states_ = {};
+  started_ = false;
+  time_ = 0;
+  return true;
+}
+
+void Writer::Close() noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  if (file_.is_open()) {
+    Flush();
+    file_.close();
+  }
+}
+
+bool Writer::IsOpen() const noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  return file_.is_open();
+}
+
+void Writer::Write(const Frame& frame) noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  if (!file_.is_open() || (frame.kind == Kind::Hit && frame.member >= states_.size())) {
+    return;
+  }
+  if (!started_) {
+    started_ = true;
+    start_ = frame.time;
+  }
+  const auto time = std::max(static_cast<std::int64_t>(std::llround((frame.time - start_) * 1000.0)), time_);
+  const auto combat = static_cast<std::uint8_t>(frame.combat ? 0x04 : 0x00);
+
+  try {
+    if (frame.kind == Kind::Hit) {
+      auto& state = states_[frame.member];
+      const auto encoded = Encode(frame.members[frame.member]);
+      buffer_.push_back(static_cast<std::uint8_t>(Kind::Hit) | combat);
+      Put(buffer_, static_cast<std::uint64_t>(time - time_));
+      buffer_.push_back(frame.member);
+      Put(buffer_, std::uint64_t{ frame.source });
+      Put(buffer_, std::int64_t{ encoded.health - state.health });
+      state.health = encoded.health;
+    } else {
+      const auto target = static_cast<std::uint8_t>(static_cast<std::uint8_t>(frame.target) << 3);
+      buffer_.push_back(static_cast<std::uint8_t>(Kind::Update) | combat | target);
+      Put(buffer_, static_cast<std::uint64_t>(time - time_));
+
+      // Only store members that changed since the last frame.
+      std::array<State, Members> encoded;
+      std::uint8_t changed = 0;
+      for (std::size_t i = 0; i < states_.size(); i++) {
+        encoded[i] = Encode(frame.members[i]);
+        const auto& a = encoded[i];
+        const auto& b = states_[i];
+        if (
+          a.present != b.present || a.dead != b.dead || a.health != b.health || a.rate != b.rate ||
+          a.position != b.position)
+        {
+          changed |= static_cast<std::uint8_t>(1 << i);
+        }
+      }
+      buffer_.push_back(changed);
+      for (std::size_t i = 0; i < states_.size(); i++) {
+        if (!(changed & (1 << i))) {
+          continue;
+        }
+        const auto& a = encoded[i];
+        auto& b = states_[i];
+        const auto health = a.health != b.health;
+        const auto position = a.position != b.position;
+        const auto rate = a.rate != b.rate;
+        std::uint8_t flags = 0;
+        flags |= a.present ? 0x01 : 0x00;
+        flags |= a.dead ? 0x02 : 0x00;
+        flags |= health ? 0x04 : 0x00;
+        flags |= position ? 0x08 : 0x00;
+        flags |= rate ? 0x10 : 0x00;
+        buffer_.push_back(flags);
+        if (health) {
+          Put(buffer_, std::int64_t{ a.health - b.health });
+        }
+        if (position) {
+          for (std::size_t j = 0; j < 3; j++) {
+            Put(buffer_, std::int64_t{ a.position[j] } - b.position[j]);
+          }
+        }
+        if (rate) {
+          Put(buffer_, std::int64_t{ a.rate } - b.rate);
+        }
+        b = a;
+      }
+    }
+  }
+  catch (...) {
+    file_.close();
+    return;
+  }
+  time_ = time;
+
+  if (buffer_.size() >= BufferSize - 64) {
+    Flush();
+  }
+}
+
+void Writer::Flush() noexcept
+{
+  if (!buffer_.empty()) {
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+  }
+}
+
+Reader::Reader(std::span<const std::uint8_t> data) noexcept :
+  data_(data)
+{
+  const auto get = [&](std::size_t offset) noexcept {
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+      value |= static_cast<std::uint32_t>(data_[offset + i]) << (i * 8);
+    }
+    return value;
+  };
+  if (data_.size() >= 8 && get(0) == Magic && get(4) >= 1 && get(4) <= Version) {
+    offset_ = 8;
+    valid_ = true;
+  }
+}
+
+bool Reader::Valid() const noexcept
+{
+  return valid_;
+}
+
+bool Reader::Next(Frame& frame) noexcept
+{
+  if (!valid_ || offset_ >= data_.size()) {
+    return false;
+  }
+  const auto header = data_[offset_++];
+  std::uint64_t delta = 0;
+  if (!Read(delta)) {
+    return valid_ = false;
+  }
+  time_ += static_cast<std::int64_t>(delta);
+
+  frame.kind = static_cast<Kind>(header & 0x03);
+  frame.time = static_cast<double>(time_) / 1000.0;
+  frame.combat = (header & 0x04) != 0;
+  frame.target = Triage::Target::None;
+  frame.member = 0;
+  frame.source = 0;
+
+  if (frame.kind == Kind::Hit) {
+    std::uint64_t source = 0;
+    std::int64_t health = 0;
+    if (offset_ >= data_.size()) {
+      return valid_ = false;
+    }
+    frame.member = data_[offset_++];
+    if (frame.member >= states_.size() || !Read(source) || !Read(health)) {
+      return valid_ = false;
+    }
+    frame.source = static_cast<std::uint32_t>(source);
+    states_[frame.member].health += static_cast<std::int32_t>(health);
+  } else if (frame.kind == Kind::Update) {
+    frame.target = static_cast<Triage::Target>((header >> 3) & 0x07);
+    if (offset_ >= data_.size()) {
+      return valid_ = false;
+    }
+    const auto changed = data_[offset_++];
+    for (std::size_t i = 0; i < states_.size(); i++) {
+      if (!(changed & (1 << i))) {
+        continue;
+      }
+      if (offset_ >= data_.size()) {
+        return valid_ = false;
+      }
+      const auto flags = data_[offset_++];
+      auto& state = states_[i];
+      state.present = (flags & 0x01) != 0;
+      state.dead = (flags & 0x02) != 0;
+      if (flags & 0x04) {
+        std::int64_t health = 0;
+        if (!Read(health)) {
+          return valid_ = false;
+        }
+        state.health += static_cast<std::int32_t>(health);
+      }
+      if (flags & 0x08) {
+        for (auto& position : state.position) {
+          std::int64_t value = 0;
+          if (!Read(value)) {
+            return valid_ = false;
+          }
+          position += static_cast<std::int32_t>(value);
+        }
+      }
+      if (flags & 0x10) {
+        std::int64_t rate = 0;
+        if (!Read(rate)) {
+          return valid_ = false;
+        }
+        state.rate += static_cast<std::int32_t>(rate);
+      }
+    }
+  } else {
+    return valid_ = false;
+  }
+
+  for (std::size_t i = 0; i < states_.size(); i++) {
+    frame.members[i] = Decode(states_[i]);
+  }
+  return true;
+}
+
+bool Reader::Read(std::uint64_t& value) noexcept
+{
+  value = 0;
+  for (unsigned shift = 0; shift < 64 && offset_ < data_.size(); shift += 7) {
+    const auto byte = data_[offset_++];
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Reader::Read(std::int64_t& value) noexcept
+{
+  std::uint64_t encoded = 0;
+  if (!Read(encoded)) {
+    return false;
+  }
+  value = static_cast<std::int64_t>(encoded >> 1) ^ -static_cast<std::int64_t>(encoded & 1);
+  return true;
+}
+
+}  // namespace UT::Record
@@ -0,0 +1,112 @@
+#pragma once
+#include <triage.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace UT::Record {
+
+// Recordings start with the magic number and version as little endian integers, followed by frames.
+// Frames store the time in milliseconds and the party state as deltas to the previous frame.
+// Version 1 recordings have no ally and are still read.
+constexpr std::uint32_t Magic = 0x43525455;  // UTRC
+constexpr std::uint32_t Version = 2;
+
+// Number of recorded members: player, warlock, knight, guard, ally.
+constexpr std::size_t Members = 5;
+
+enum class Kind : std::uint8_t {
+  Update,
+  Hit,
+};
+
+struct Member {
+  bool present{ false };
+  bool dead{ false };
+  float health{ 1.0f };
+  float rate{ 0.0f };  // health ratio lost per second, only recorded for the ally
+  std::array<float, 3> position{};
+};
+
+struct Frame {
+  Kind kind{ Kind::Update };
+  double time{ 0.0 };                            // seconds since the first frame
+  bool combat{ false };                          // player combat state
+  Triage::Target target{ Triage::Target::None };  // update: selected heal target
+  std::uint8_t member{ 0 };                      // hit: index of the member that was hit
+  std::uint32_t source{ 0 };                     // hit: form id of the hit source
+  std::array<Member, Members> members;           // player, warlock, knight, guard, ally
+};
+
+// Returns the index of the member in Frame::members.
+constexpr std::size_t GetIndex(Triage::Target target) noexcept
+{
+  return static_cast<std::size_t>(target) - 1;
+}
+
+// Encoded member state used as the base for the next delta.
+struct State {
+  bool present{ false };
+  bool dead{ false };
+  std::int32_t health{ 0 };
+  std::int32_t rate{ 0 };
+  std::array<std::int32_t, 3> position{};
+};
+
+class Writer {
+public:
+  Writer() = default;
+  Writer(Writer&& other) = delete;
+  Writer(const Writer& other) = delete;
+  Writer& operator=(Writer&& other) = delete;
+  Writer& operator=(const Writer& other) = delete;
+  ~Writer();
+
+  bool Open(const std::filesystem::path& path) noexcept;
+  void Close() noexcept;
+  bool IsOpen() const noexcept;
+
+  // Appends a frame. Hit frames only store the member that was hit.
+  // The time is a monotonic time stamp in seconds.
+  void Write(const Frame& frame) noexcept;
+
+private:
+  void Flush() noexcept;
+
+  mutable std::mutex mutex_;
+  std::ofstream file_;
+  std::vector<std::uint8_t> buffer_;
+  std::array<State, Members> states_{};
+  bool started_{ false };
+  double start_{ 0.0 };
+  std::int64_t time_{ 0 };
+};
+
+class Reader {
+public:
+  explicit Reader(std::span<const std::uint8_t> data) noexcept;
+
+  // Returns false when the header is invalid or a frame could not be decoded.
+  bool Valid() const noexcept;
+
+  // Decodes the next frame. Members contain the full party state after the frame.
+  bool Next(Frame& frame) noexcept;
+
+private:
+  bool Read(std::uint64_t& value) noexcept;
+  bool Read(std::int64_t& value) noexcept;
+
+  std::span<const std::uint8_t> data_;
+  std::size_t offset_{ 0 };
+  bool valid_{ false };
+  std::array<State, Members> states_{};
+  std::int64_t time_{ 0 };
+};
+
+}  // namespace UT::Record
@@ -0,0 +1,74 @@
+#include "schedule.hpp"
+
+#include <chrono>
+
+namespace UT {
+
+Scheduler::Scheduler(Clock clock) :
+  clock_(std::move(clock))
+{}
+
+void Scheduler::Post(Priority priority, Job job)
+{
+  std::lock_guard lock{ mutex_ };
+  queues_[static_cast<std::size_t>(priority)].push_back(std::move(job));
+}
+
+bool Scheduler::Run(std::int64_t budget) noexcept
+{
+  const auto start = clock_();
+  do {
+    // Take the next job out of the queue, so that it can post new jobs.
+    Job job;
+    std::size_t priority = 0;
+    {
+      std::lock_guard lock{ mutex_ };
+      while (priority < Priorities && queues_[priority].empty()) {
+        priority++;
+      }
+      if (priority == Priorities) {
+        return false;
+      }
+      job = std::move(queues_[priority].front());
+      queues_[priority].pop_front();
+    }
+
+    // Queue the job again when it yields. Jobs that throw are dropped.
+    try {
+      if (!job()) {
+        std::lock_guard lock{ mutex_ };
+        queues_[priority].push_back(std::move(job));
+      }
+    }
+    catch (...) {
+    }
+  } while (clock_() - start < budget);
+  return !Empty();
+}
+
+void Scheduler::Clear() noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  for (auto& queue : queues_) {
+    queue.clear();
+  }
+}
+
+bool Scheduler::Empty() const noexcept
+{
+  std::lock_guard lock{ mutex_ };
+  for (const auto& queue : queues_) {
+    if (!queue.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::int64_t Scheduler::Now() noexcept
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+}  // namespace UT
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace UT {
+
+// Runs queued jobs in priority order until a time budget is spent.
+class Scheduler {
+public:
+  enum class Priority : std::uint8_t {
+    High,
+    Normal,
+    Low,
+  };
+
+  static constexpr std::size_t Priorities = 3;
+
+  // Jobs return true when they are done and false to run again later.
+  using Job = std::function<bool()>;
+
+  // Returns a monotonic time stamp in microseconds.
+  using Clock = std::function<std::int64_t()>;
+
+  explicit Scheduler(Clock clock = Now);
+  Scheduler(Scheduler&& other) = delete;
+  Scheduler(const Scheduler& other) = delete;
+  Scheduler& operator=(Scheduler&& other) = delete;
+  Scheduler& operator=(const Scheduler& other) = delete;
+
+  // Queues a job. Can be called from any thread.
+  void Post(Priority priority, Job job);
+
+  // Runs jobs until the budget in microseconds is spent and returns true if jobs remain.
+  // The first job always runs, so every call makes progress. The budget is checked after
+  // every job, so a single long job can overrun it.
+  bool Run(std::int64_t budget) noexcept;
+
+  // Removes all queued jobs.
+  void Clear() noexcept;
+
+  bool Empty() const noexcept;
+
+  static std::int64_t Now() noexcept;
+
+private:
+  mutable std::mutex mutex_;
+  std::array<std::deque<Job>, Priorities> queues_;
+  Clock clock_;
+};
+
+}  // namespace UT
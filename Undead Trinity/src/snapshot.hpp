@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace UT {
+
+// Immutable versions of a value that can be read from any thread without locks.
+//
+// Readers pin the current epoch in a slot and load the current version. Writers are
+// serialized, publish a modified copy and retire the previous version, which is deleted
+// once no slot is pinned to an epoch in which the previous version was visible.
+//
+// At most Slots readers can exist at the same time and Read waits for a free slot when all
+// slots are pinned. Threads that hold a reader while they wait for another one can wait
+// forever, so the number of readers held at once must stay below Slots.
+template <class T, std::size_t Slots = 64>
+class Snapshot {
+public:
+  class Reader {
+  public:
+    Reader(Reader&& other) = delete;
+    Reader(const Reader& other) = delete;
+    Reader& operator=(Reader&& other) = delete;
+    Reader& operator=(const Reader& other) = delete;
+
+    ~Reader()
+    {
+      slot_.store(0, std::memory_order_release);
+    }
+
+    const T& operator*() const noexcept
+    {
+      return *value_;
+    }
+
+    const T* operator->() const noexcept
+    {
+      return value_;
+    }
+
+  private:
+    friend class Snapshot;
+
+    Reader(std::atomic<std::uint64_t>& slot, const T* value) noexcept :
+      slot_(slot),
+      value_(value)
+    {}
+
+    std::atomic<std::uint64_t>& slot_;
+    const T* value_;
+  };
+
+  Snapshot() :
+    value_(new T{})
+  {}
+
+  Snapshot(Snapshot&& other) = delete;
+  Snapshot(const Snapshot& other) = delete;
+  Snapshot& operator=(Snapshot&& other) = delete;
+  Snapshot& operator=(const Snapshot& other) = delete;
+
+  ~Snapshot()
+  {
+    delete value_.load();
+  }
+
+  // Returns the current version, which stays valid while the reader exists.
+  // Yields after every pass over the slots until another reader releases one.
+  Reader Read() const noexcept
+  {
+    // Threads start at different slots, so that the first slot is usually free.
+    static std::atomic_size_t threads{ 0 };
+    thread_local const auto hint = threads.fetch_add(1, std::memory_order_relaxed);
+    for (auto i = hint;; i++) {
+      auto& slot = slots_[i % Slots];
+      auto expected = std::uint64_t{ 0 };
+      if (slot.compare_exchange_strong(expected, epoch_.load())) {
+        return { slot, value_.load() };
+      }
+      if ((i + 1 - hint) % Slots == 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // Publishes a copy of the current version that was modified by the function.
+  template <class Function>
+  void Write(Function&& function)
+  {
+    std::lock_guard lock{ mutex_ };
+    auto next = std::make_unique<T>(*value_.load());
+    std::forward<Function>(function)(*next);
+    std::unique_ptr<T> last{ value_.exchange(next.release()) };
+    retired_.emplace_back(epoch_.fetch_add(1) + 1, std::move(last));
+    Collect();
+  }
+
+  // Deletes retired versions that can no longer be read.
+  void Reclaim()
+  {
+    std::lock_guard lock{ mutex_ };
+    Collect();
+  }
+
+private:
+  void Collect()
+  {
+    auto oldest = epoch_.load();
+    for (const auto& slot : slots_) {
+      if (const auto epoch = slot.load(); epoch && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+    std::erase_if(retired_, [oldest](const auto& e) { return e.first <= oldest; });
+  }
+
+  std::atomic<T*> value_;
+  std::atomic<std::uint64_t> epoch_{ 1 };
+  mutable std::array<std::atomic<std::uint64_t>, Slots> slots_{};
+  std::mutex mutex_;
+  std::vector<std::pair<std::uint64_t, std::unique_ptr<T>>> retired_;
+};
+
+}  // namespace UT
@@ -0,0 +1,230 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UT::Trace {
+namespace {
+
+struct Event {
+  std::atomic<std::uint64_t> sequence{ 0 };
+  std::uint64_t time{ 0 };
+  std::uint64_t id{ 0 };
+  std::uint32_t thread{ 0 };
+  char phase{ 0 };
+  char name[43]{};
+};
+
+struct Record {
+  std::uint64_t time{ 0 };
+  std::uint64_t id{ 0 };
+  std::uint32_t thread{ 0 };
+  char phase{ 0 };
+  char name[43]{};
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::unique_ptr<Event[]> Events;
+std::size_t Mask{ 0 };
+Clock::time_point Epoch;
+
+std::atomic<bool> Recording{ false };
+std::atomic<std::uint64_t> Sequence{ 0 };
+std::atomic<std::uint64_t> Flow{ 0 };
+std::atomic<std::uint32_t> Threads{ 0 };
+
+std::uint32_t GetThread() noexcept
+{
+  thread_local const auto thread = Threads.fetch_add(1, std::memory_order_relaxed) + 1;
+  return thread;
+}
+
+void Add(char phase, std::string_view name, std::uint64_t id) noexcept
+{
+  const auto sequence = Sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+  auto& event = Events[sequence & Mask];
+  // Invalidate the event before the fields change. The fence keeps the field stores below from
+  // moving ahead of the invalidation, so Write never accepts a half written event.
+  event.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  const auto time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - Epoch);
+  event.time = static_cast<std::uint64_t>(time.count());
+  event.id = id;
+  event.thread = GetThread();
+  event.phase = phase;
+  const auto size = std::min(name.size(), sizeof(event.name) - 1);
+  std::copy_n(name.data(), size, event.name);
+  event.name[size] = '\0';
+  event.sequence.store(sequence, std::memory_order_release);
+}
+
+void Escape(std::string& json, const char* name)
+{
+  for (auto c = name; *c; c++) {
+    switch (*c) {
+    case '"':
+    case '\\':
+      json.push_back('\\');
+      json.push_back(*c);
+      break;
+    default:
+      if (static_cast<unsigned char>(*c) < 0x20) {
+        json.push_back('?');
+      } else {
+        json.push_back(*c);
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+void Start(std::size_t capacity) noexcept
+{
+  if (!Events) {
+    capacity = std::bit_ceil(std::max(capacity, std::size_t{ 1024 }));
+    Events.reset(new (std::nothrow) Event[capacity]);
+    if (!Events) {
+      return;
+    }
+    Mask = capacity - 1;
+    Epoch = Clock::now();
+  }
+  Recording.store(true, std::memory_order_release);
+}
+
+void Stop() noexcept
+{
+  Recording.store(false, std::memory_order_release);
+}
+
+bool Enabled() noexcept
+{
+  return Recording.load(std::memory_order_relaxed);
+}
+
+void Begin(std::string_view name) noexcept
+{
+  if (Enabled()) {
+    Add('B', name, 0);
+  }
+}
+
+void End() noexcept
+{
+  if (Enabled()) {
+    Add('E', {}, 0);
+  }
+}
+
+std::uint64_t FlowBegin(std::string_view name) noexcept
+{
+  if (!Enabled()) {
+    return 0;
+  }
+  const auto id = Flow.fetch_add(1, std::memory_order_relaxed) + 1;
+  Add('s', name, id);
+  return id;
+}
+
+void FlowEnd(std::string_view name, std::uint64_t id) noexcept
+{
+  if (id && Enabled()) {
+    Add('f', name, id);
+  }
+}
+
+bool Write(const std::filesystem::path& path) noexcept
+{
+  if (!Events) {
+    return false;
+  }
+
+  // Copy events that were completely written and are still in the ring buffer.
+  const auto last = Sequence.load(std::memory_order_acquire);
+  const auto first = last > Mask ? last - Mask : 1;
+  std::vector<Record> records;
+  try {
+    records.reserve(static_cast<std::size_t>(last - first + 1));
+  }
+  catch (...) {
+    return false;
+  }
+  for (auto sequence = first; sequence <= last; sequence++) {
+    auto& event = Events[sequence & Mask];
+    if (event.sequence.load(std::memory_order_acquire) != sequence) {
+      continue;
+    }
+    auto& record = records.emplace_back();
+    record.time = event.time;
+    record.id = event.id;
+    record.thread = event.thread;
+    record.phase = event.phase;
+    std::copy_n(event.name, sizeof(record.name), record.name);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (event.sequence.load(std::memory_order_relaxed) != sequence) {
+      records.pop_back();
+    }
+  }
+
+  try {
+    std::string json;
+    json.reserve(records.size() * 96 + 64);
+    json.append(R"({"displayTimeUnit":"ms","traceEvents":[)");
+
+    // Skip end events whose begin event was overwritten.
+    std::unordered_map<std::uint32_t, std::size_t> depth;
+    auto separator = "\n";
+    for (const auto& record : records) {
+      if (record.phase == 'B') {
+        depth[record.thread]++;
+      } else if (record.phase == 'E') {
+        if (auto& open = depth[record.thread]; open) {
+          open--;
+        } else {
+          continue;
+        }
+      }
+      json.append(separator);
+      separator = ",\n";
+      json.append(R"({"name":")");
+      Escape(json, record.name);
+      json.append(R"(","cat":"ut","ph":")");
+      json.push_back(record.phase);
+      json.append(R"(","ts":)");
+      json.append(std::to_string(record.time));
+      json.append(R"(,"pid":1,"tid":)");
+      json.append(std::to_string(record.thread));
+      if (record.phase == 's' || record.phase == 'f') {
+        json.append(R"(,"id":)");
+        json.append(std::to_string(record.id));
+      }
+      if (record.phase == 'f') {
+        json.append(R"(,"bp":"e")");
+      }
+      json.push_back('}');
+    }
+    json.append("\n]}\n");
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return false;
+    }
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return static_cast<bool>(file);
+  }
+  catch (...) {
+    return false;
+  }
+}
+
+}  // namespace UT::Trace
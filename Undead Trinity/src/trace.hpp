@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace UT::Trace {
+
+// Allocates the event ring buffer and starts recording.
+// The buffer is never released and keeps the most recent events.
+void Start(std::size_t capacity = 1 << 16) noexcept;
+
+// Stops recording events.
+void Stop() noexcept;
+
+// Returns true if events are being recorded.
+bool Enabled() noexcept;
+
+// Records the beginning of a slice on the calling thread.
+void Begin(std::string_view name) noexcept;
+
+// Records the end of the last slice on the calling thread.
+void End() noexcept;
+
+// Records the start of a flow inside the current slice and returns its id.
+std::uint64_t FlowBegin(std::string_view name) noexcept;
+
+// Records the end of a flow inside the current slice.
+void FlowEnd(std::string_view name, std::uint64_t id) noexcept;
+
+// Writes recorded events in the Chrome trace event format.
+// Open with https://ui.perfetto.dev or chrome://tracing.
+bool Write(const std::filesystem::path& path) noexcept;
+
+class Scope {
+public:
+  explicit Scope(std::string_view name) noexcept :
+    active_(Enabled())
+  {
+    if (active_) {
+      Begin(name);
+    }
+  }
+
+  Scope(Scope&& other) = delete;
+  Scope(const Scope& other) = delete;
+  Scope& operator=(Scope&& other) = delete;
+  Scope& operator=(const Scope& other) = delete;
+
+  ~Scope()
+  {
+    if (active_) {
+      End();
+    }
+  }
+
+private:
+  bool active_;
+};
+
+}  // namespace UT::Trace
@@ -0,0 +1,51 @@
+#include "tracker.hpp"
+
+namespace UT {
+
+void Tracker::Track(std::uint32_t id, Kind kind)
+{
+  if (const auto it = index_.find(id); it != index_.end()) {
+    entries_[it->second] = { id, kind, State::Owned };
+    return;
+  }
+  std::uint32_t index = 0;
+  if (holes_.empty()) {
+    index = static_cast<std::uint32_t>(entries_.size());
+    entries_.push_back({ id, kind, State::Owned });
+  } else {
+    index = holes_.back();
+    holes_.pop_back();
+    entries_[index] = { id, kind, State::Owned };
+  }
+  index_.emplace(id, index);
+}
+
+void Tracker::Untrack(std::uint32_t id) noexcept
+{
+  const auto it = index_.find(id);
+  if (it == index_.end()) {
+    return;
+  }
+  const auto index = it->second;
+  index_.erase(it);
+  entries_[index] = {};
+  if (index + 1 == entries_.size()) {
+    entries_.pop_back();
+    while (!entries_.empty() && entries_.back().kind == Kind::None) {
+      entries_.pop_back();
+    }
+    std::erase_if(holes_, [this](std::uint32_t hole) { return hole >= entries_.size(); });
+  } else {
+    holes_.push_back(index);
+  }
+}
+
+void Tracker::Clear() noexcept
+{
+  entries_.clear();
+  holes_.clear();
+  index_.clear();
+  cursor_ = 0;
+}
+
+}  // namespace UT
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace UT {
+
+// Table of references created by the mod.
+//
+// Entries are stored in a dense array and indexed by form id. Removed entries leave a hole
+// that is reused by the next tracked reference, so indices stay stable while an entry exists.
+class Tracker {
+public:
+  enum class Kind : std::uint8_t {
+    None,
+    Actor,
+    Visual,
+  };
+
+  enum class State : std::uint8_t {
+    Owned,     // referenced by the roster, the actor pool or the visuals pool
+    Orphaned,  // not referenced anymore, waiting to be reclaimed
+  };
+
+  struct Entry {
+    std::uint32_t id{ 0 };
+    Kind kind{ Kind::None };
+    State state{ State::Owned };
+  };
+
+  // Adds a reference or marks a tracked reference as owned.
+  void Track(std::uint32_t id, Kind kind);
+
+  // Removes a reference.
+  void Untrack(std::uint32_t id) noexcept;
+
+  // Marks every entry that is not owned according to the predicate as orphaned and returns
+  // the number of orphaned entries.
+  template <class Predicate>
+  std::size_t Audit(Predicate&& owned)
+  {
+    std::size_t orphaned = 0;
+    for (auto& entry : entries_) {
+      if (entry.kind == Kind::None) {
+        continue;
+      }
+      if (!owned(entry)) {
+        entry.state = State::Orphaned;
+      }
+      if (entry.state == State::Orphaned) {
+        orphaned++;
+      }
+    }
+    return orphaned;
+  }
+
+  // Calls the function for up to budget orphaned entries, starting after the last entry of
+  // the previous call. Entries are removed when the function returns true. Returns false when
+  // a full pass over the table found no orphaned entries.
+  template <class Function>
+  bool Reclaim(std::size_t budget, Function&& reclaim)
+  {
+    auto found = false;
+    for (std::size_t i = 0; i < entries_.size() && budget; i++) {
+      cursor_ = (cursor_ + 1) % entries_.size();
+      const auto entry = entries_[cursor_];
+      if (entry.kind == Kind::None || entry.state != State::Orphaned) {
+        continue;
+      }
+      found = true;
+      budget--;
+      if (reclaim(entry)) {
+        Untrack(entry.id);
+      }
+    }
+    return found;
+  }
+
+  // Returns all entries including holes with the kind None.
+  std::span<const Entry> GetEntries() const noexcept
+  {
+    return entries_;
+  }
+
+  std::size_t GetSize() const noexcept
+  {
+    return index_.size();
+  }
+
+  void Clear() noexcept;
+
+private:
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> holes_;
+  std::unordered_map<std::uint32_t, std::uint32_t> index_;
+  std::size_t cursor_{ 0 };
+};
+
+}  // namespace UT
@@ -0,0 +1,68 @@
+#include "triage.hpp"
+
+#include <limits>
+
+namespace UT::Triage {
+
+Target Select(const Party& party, const Thresholds& thresholds) noexcept
+{
+  if (!party.warlock.present || party.warlock.dead) {
+    return Target::None;
+  }
+
+  // Heal anyone who is not at full health outside of combat.
+  auto playerMin = 1.0f;
+  auto warlockMin = 1.0f;
+  auto knightMin = 1.0f;
+  auto guardMin = 1.0f;
+  auto allyMin = 1.0f;
+  auto lookahead = 0.0f;
+  if (party.combat) {
+    playerMin = thresholds.player;
+    warlockMin = thresholds.warlock;
+    knightMin = thresholds.knight;
+    guardMin = thresholds.guard;
+    allyMin = thresholds.ally;
+    lookahead = thresholds.lookahead;
+  }
+
+  auto target = Target::None;
+  auto best = std::numeric_limits<float>::infinity();
+  const auto rank = [&](Target candidate, const Member& member, float threshold) noexcept {
+    if (const auto time = GetTime(member, threshold); time <= lookahead && time < best) {
+      target = candidate;
+      best = time;
+    }
+  };
+
+  if (party.player.present && !party.player.dead) {
+    rank(Target::Player, party.player, playerMin);
+  }
+  rank(Target::Warlock, party.warlock, warlockMin);
+  const auto reachable = [&](const Member& member) noexcept {
+    return member.present && !member.dead && member.health > thresholds.floor && member.distance < thresholds.range;
+  };
+  if (reachable(party.knight)) {
+    rank(Target::Knight, party.knight, knightMin);
+  }
+  if (reachable(party.guard)) {
+    rank(Target::Guard, party.guard, guardMin);
+  }
+  if (reachable(party.ally)) {
+    rank(Target::Ally, party.ally, allyMin);
+  }
+  return target;
+}
+
+float GetTime(const Member& member, float threshold) noexcept
+{
+  if (member.health < threshold) {
+    return 0.0f;
+  }
+  if (member.rate <= 0.0f) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return (member.health - threshold) / member.rate;
+}
+
+}  // namespace UT::Triage
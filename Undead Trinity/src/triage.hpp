@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+
+namespace UT::Triage {
+
+enum class Target : std::uint8_t {
+  None,
+  Player,
+  Warlock,
+  Knight,
+  Guard,
+  Ally,
+};
+
+struct Member {
+  bool present{ false };
+  bool dead{ false };
+  float health{ 1.0f };    // health ratio
+  float rate{ 0.0f };      // health ratio lost per second
+  float distance{ 0.0f };  // distance to the warlock
+};
+
+struct Party {
+  bool combat{ false };
+  Member player;
+  Member warlock;
+  Member knight;
+  Member guard;
+  Member ally;  // nearby friendly actor that needs healing the most
+};
+
+struct Thresholds {
+  float player{ 0.9f };
+  float warlock{ 0.9f };
+  float knight{ 0.75f };
+  float guard{ 0.6f };
+  float ally{ 0.6f };
+  float floor{ 0.1f };       // members below this ratio are not healed
+  float range{ 900.0f };     // maximum distance to heal the knight, guard or an ally
+  float lookahead{ 1.5f };   // seconds of predicted damage that start a heal early
+};
+
+// Selects the member the warlock should heal.
+// Members are ranked by the predicted time until their health drops below the threshold;
+// ties are resolved in the order player, warlock, knight, guard, ally.
+Target Select(const Party& party, const Thresholds& thresholds = {}) noexcept;
+
+// Returns the predicted number of seconds until health drops below the threshold.
+float GetTime(const Member& member, float threshold) noexcept;
+
+constexpr const char* GetName(Target target) noexcept
+{
+  switch (target) {
+  case Target::None:
+    return "None";
+  case Target::Player:
+    return "Player";
+  case Target::Warlock:
+    return "Warlock";
+  case Target::Knight:
+    return "Knight";
+  case Target::Guard:
+    return "Guard";
+  case Target::Ally:
+    return "Ally";
+  }
+  return "Unknown";
+}
+
+}  // namespace UT::Triage
@@ -1,89 +1,174 @@
 #include "trinity.hpp"
 
+#include <packages.hpp>
+#include <trace.hpp>
+
+#include <array>
+#include <utility>
+
 namespace UT {
 namespace {
 
-constexpr auto RP = Game::RemovePackageOverride;
+void EvaluatePackage(Engine::Actor& actor) noexcept
+{
+  const Trace::Scope trace{ "EvaluatePackage" };
+  actor.EvaluatePackage();
+}
+
+// Removes the packages one after another and calls the callback after the last one.
+void RemovePackages(
+  Engine::VM& vm,
+  std::shared_ptr<Engine::Actor> actor,
+  std::shared_ptr<std::vector<std::uint32_t>> packages,
+  std::size_t index,
+  Engine::Callback callback) noexcept
+{
+  if (index >= packages->size()) {
+    if (callback) {
+      callback();
+    }
+    return;
+  }
+  const auto package = (*packages)[index];
+  auto& target = *actor;
+  Packages::Remove(
+    vm, target, package, [&vm, actor = std::move(actor), packages, index, callback = std::move(callback)]() mutable {
+      RemovePackages(vm, std::move(actor), std::move(packages), index + 1, std::move(callback));
+    });
+}
+
+constexpr bool IsOneHanded(Equip::Category category) noexcept
+{
+  return category == Equip::Category::OneHanded || category == Equip::Category::Dagger;
+}
 
 }  // namespace
 
-Trinity::Trinity(RE::Actor* actor) :
-  actor_(actor),
-  class_(GetTrinityClass(actor))
+Trinity::Trinity(
+  Engine::VM& vm,
+  std::shared_ptr<Engine::Actor> actor,
+  Policy::Class member,
+  std::vector<std::uint32_t> packages) :
+  vm_(vm),
+  actor_(std::move(actor)),
+  member_(member),
+  class_(actor_->GetBaseID()),
+  generation_(vm.GetGeneration()),
+  packages_(std::move(packages))
 {}
 
 Trinity::~Trinity()
 {
-  if (initialized_) {
+  // Package overrides of members from an unloaded game are restored by the loaded save.
+  if (initialized_ && generation_ == vm_.GetGeneration()) {
     ClearPackages();
   }
 }
 
 void Trinity::Initialize() noexcept
 {
-  if (initialized_ || !IsTrinity()) {
+  if (initialized_) {
     return;
   }
+  const Trace::Scope trace{ "Trinity::Initialize" };
   initialized_ = true;
-  Game::Initialize(class_, actor_);
-  ClearPackages([this, self = shared_from_this()]() { actor_->EvaluatePackage(true, false); });
+  ClearPackages([this, self = shared_from_this()]() { EvaluatePackage(*actor_); });
 }
 
-void Trinity::SetCombatPackage(RE::TESPackage* package) noexcept
+void Trinity::Restore(std::uint32_t package) noexcept
+{
+  if (initialized_) {
+    return;
+  }
+  const Trace::Scope trace{ "Trinity::Restore" };
+  initialized_ = true;
+  package_ = package;
+}
+
+void Trinity::SetCombatPackage(std::uint32_t package) noexcept
 {
   if (package == package_) {
     return;
   }
+  const Trace::Scope trace{ "Trinity::SetCombatPackage" };
   const auto self = shared_from_this();
   if (package_) {
-    Game::RemovePackageOverride(class_, actor_, package_, [this, self, package](RE::BSScript::Variable result) {
+    Packages::Remove(vm_, *actor_, package_, [this, self, package]() {
       if (package) {
-        Game::AddPackageOverride(class_, actor_, package, 2, true, [this, self, package](RE::BSScript::Variable result) {
-          UT_DEBUG("UT: [%s] PACK %s", Game::GetName(class_), Game::GetName(package));
-          actor_->EvaluatePackage(true, false);
-        });
+        Packages::Add(vm_, *actor_, package, 2, true, [this, self]() { EvaluatePackage(*actor_); });
       } else {
-        UT_DEBUG("UT: [%s] PACK Follow", Game::GetName(class_));
-        actor_->EvaluatePackage(true, false);
+        EvaluatePackage(*actor_);
       }
     });
   } else {
-    Game::AddPackageOverride(class_, actor_, package, 2, true, [this, self, package](RE::BSScript::Variable result) {
-      UT_DEBUG("UT: [%s] PACK %s", Game::GetName(class_), Game::GetName(package));
-      actor_->EvaluatePackage(true, false);
-    });
+    Packages::Add(vm_, *actor_, package, 2, true, [this, self]() { EvaluatePackage(*actor_); });
   }
   package_ = package;
 }
 
-RE::FormID Trinity::GetTrinityClass(RE::Actor* actor) noexcept
+void Trinity::EquipItem(const Engine::Item& item, Engine::Callback callback) noexcept
 {
-  if (actor && !actor->IsDead()) {
-    if (const auto base = actor->GetActorBase()) {
-      return base->GetFormID();
+  const Trace::Scope trace{ "Trinity::EquipItem" };
+  switch (item.category) {
+  case Equip::Category::None:
+    return;
+  case Equip::Category::Spell:
+    EquipSpell(item.form, std::move(callback));
+    return;
+  case Equip::Category::Clothing:
+  case Equip::Category::LightArmor:
+  case Equip::Category::HeavyArmor:
+  case Equip::Category::Shield:
+    actor_->UnequipConflicts(item.form);
+    break;
+  default:
+    break;
+  }
+
+  // Dual wield one-handed weapons when the right hand already holds one.
+  std::int32_t slot = 0;
+  if (IsKnight() && IsOneHanded(item.category)) {
+    if (const auto right = actor_->GetEquipped(false); right && right->form.id != item.form.id) {
+      if (IsOneHanded(right->category)) {
+        slot = 2;
+      }
     }
   }
-  return 0;
+
+  const std::array<Engine::Argument, 4> arguments{ item.form, slot, true, true };
+  vm_.DispatchMethodCall(*actor_, "Actor", "EquipItemEx", arguments, std::move(callback));
 }
 
-void Trinity::ClearPackages(std::function<void()> callback) noexcept
+void Trinity::EquipSpell(const Engine::Form& spell, Engine::Callback callback) noexcept
 {
-  const auto id = class_;
-  if (id != Game::Warlock) {
+  // Spell tomes teach the spell and toggle it between the hands and the spell list.
+  if (!actor_->AddSpell(spell)) {
     return;
   }
-  const auto actor = actor_;
-  RP(id, actor, Game::HealSelf, [id, actor, callback = std::move(callback)](RE::BSScript::Variable result) mutable {
-    RP(id, actor, Game::HealKnight, [id, actor, callback = std::move(callback)](RE::BSScript::Variable result) mutable {
-      RP(id, actor, Game::HealGuard, [id, actor, callback = std::move(callback)](RE::BSScript::Variable result) mutable {
-        RP(id, actor, Game::Heal, [id, actor, callback = std::move(callback)](RE::BSScript::Variable result) {
-          if (callback) {
-            callback();
-          }
-        });
-      });
-    });
-  });
+  const auto equipped = [&](bool left) {
+    const auto item = actor_->GetEquipped(left);
+    return item && item->form.id == spell.id;
+  };
+  if (equipped(true)) {
+    const std::array<Engine::Argument, 2> arguments{ spell, 0 };
+    vm_.DispatchMethodCall(*actor_, "Actor", "UnequipSpell", arguments, std::move(callback));
+  } else if (equipped(false)) {
+    const std::array<Engine::Argument, 2> arguments{ spell, 1 };
+    vm_.DispatchMethodCall(*actor_, "Actor", "UnequipSpell", arguments, std::move(callback));
+  } else {
+    const std::array<Engine::Argument, 2> arguments{ spell, actor_->GetEquipped(false) ? 0 : 1 };
+    vm_.DispatchMethodCall(*actor_, "Actor", "EquipSpell", arguments, std::move(callback));
+  }
+}
+
+void Trinity::ClearPackages(Engine::Callback callback) noexcept
+{
+  if (packages_.empty()) {
+    return;
+  }
+  const Trace::Scope trace{ "Trinity::ClearPackages" };
+  auto packages = std::make_shared<std::vector<std::uint32_t>>(packages_);
+  RemovePackages(vm_, actor_, std::move(packages), 0, std::move(callback));
 }
 
 }  // namespace UT
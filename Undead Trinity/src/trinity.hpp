@@ -1,11 +1,26 @@
 #pragma once
-#include <game.hpp>
+#include <engine.hpp>
+#include <equip.hpp>
+#include <health.hpp>
+#include <policy.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace UT {
 
 class Trinity : public std::enable_shared_from_this<Trinity> {
 public:
-  Trinity(RE::Actor* actor);
+  // Packages are all packages that rules and heal decisions can add as an override. They are removed
+  // when the member is initialized and when it is destroyed. The actor is shared with pending script
+  // calls that remove them.
+  Trinity(
+    Engine::VM& vm,
+    std::shared_ptr<Engine::Actor> actor,
+    Policy::Class member,
+    std::vector<std::uint32_t> packages);
+
   Trinity(Trinity&& other) = delete;
   Trinity(const Trinity& other) = delete;
   Trinity& operator=(Trinity&& other) = delete;
@@ -13,34 +28,49 @@ public:
   ~Trinity();
 
   void Initialize() noexcept;
-  void SetCombatPackage(RE::TESPackage* package) noexcept;
 
-  bool IsGuard() const noexcept
+  // Initializes a member restored from the co-save with the package override that is still active.
+  void Restore(std::uint32_t package) noexcept;
+
+  // Replaces the combat package override. Zero removes it, so that the member follows the player.
+  void SetCombatPackage(std::uint32_t package) noexcept;
+
+  std::uint32_t GetCombatPackage() const noexcept
   {
-    return class_ == Game::Guard;
+    return package_;
   }
 
-  bool IsKnight() const noexcept
+  // Equips the item through the script functions of the actor. Spells are toggled between the
+  // hands and the spell list. The callback runs when the script function returned.
+  void EquipItem(const Engine::Item& item, Engine::Callback callback = {}) noexcept;
+
+  bool CanEquip(const Engine::Item& item) const noexcept
   {
-    return class_ == Game::Knight;
+    return Equip::CanEquip(member_, item.category);
   }
 
-  bool IsWarlock() const noexcept
+  bool IsGuard() const noexcept
+  {
+    return member_ == Policy::Class::Guard;
+  }
+
+  bool IsKnight() const noexcept
   {
-    return class_ == Game::Warlock;
+    return member_ == Policy::Class::Knight;
   }
 
-  bool IsTrinity() const noexcept
+  bool IsWarlock() const noexcept
   {
-    return IsGuard() || IsKnight() || IsWarlock();
+    return member_ == Policy::Class::Warlock;
   }
 
-  constexpr RE::Actor* GetActor() const noexcept
+  Engine::Actor& GetActor() const noexcept
   {
-    return actor_;
+    return *actor_;
   }
 
-  constexpr RE::FormID GetClass() const noexcept
+  // Returns the form id of the actor base.
+  constexpr std::uint32_t GetClass() const noexcept
   {
     return class_;
   }
@@ -60,14 +90,29 @@ public:
     return actor_->IsDead();
   }
 
+  const Health& GetHealth() const noexcept
+  {
+    return health_;
+  }
+
+  void Sample(double time) noexcept
+  {
+    health_.Sample(time, actor_->GetHealth());
+  }
+
 private:
-  static RE::FormID GetTrinityClass(RE::Actor* actor) noexcept;
-  void ClearPackages(std::function<void()> callback = {}) noexcept;
+  void EquipSpell(const Engine::Form& spell, Engine::Callback callback) noexcept;
+  void ClearPackages(Engine::Callback callback = {}) noexcept;
 
-  RE::Actor* actor_;
-  RE::FormID class_;
+  Engine::VM& vm_;
+  std::shared_ptr<Engine::Actor> actor_;
+  Policy::Class member_;
+  std::uint32_t class_;
+  std::uint32_t generation_;
+  std::vector<std::uint32_t> packages_;
   bool initialized_{ false };
-  RE::TESPackage* package_{ nullptr };
+  std::uint32_t package_{ 0 };
+  Health health_;
 };
 
 }  // namespace UT
@@ -0,0 +1,90 @@
+#pragma once
+#include <queue.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace UT {
+
+// Computes results for requests on a separate thread.
+//
+// Requests are pushed by one producer thread and results are popped by one consumer thread.
+// The notify function is called on the worker thread after every result, so that the
+// consumer can schedule a task that pops the results.
+template <class Request, class Result, std::size_t Capacity = 16>
+class Worker {
+public:
+  using Function = std::function<Result(const Request&)>;
+  using Notify = std::function<void()>;
+
+  Worker(Function function, Notify notify) :
+    function_(std::move(function)),
+    notify_(std::move(notify)),
+    thread_([this](std::stop_token stop) { Run(stop); })
+  {}
+
+  Worker(Worker&& other) = delete;
+  Worker(const Worker& other) = delete;
+  Worker& operator=(Worker&& other) = delete;
+  Worker& operator=(const Worker& other) = delete;
+
+  ~Worker()
+  {
+    thread_.request_stop();
+    Wake();
+  }
+
+  // Called by the producer. Returns false when too many requests are pending.
+  bool Push(Request request) noexcept
+  {
+    if (!requests_.Push(std::move(request))) {
+      return false;
+    }
+    Wake();
+    return true;
+  }
+
+  // Called by the consumer. Returns false when there are no results.
+  bool Pop(Result& result) noexcept
+  {
+    return results_.Pop(result);
+  }
+
+private:
+  void Wake() noexcept
+  {
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+  }
+
+  void Run(std::stop_token stop) noexcept
+  {
+    Request request;
+    while (!stop.stop_requested()) {
+      const auto signal = signal_.load(std::memory_order_acquire);
+      while (requests_.Pop(request)) {
+        try {
+          // Drop results that the consumer did not pick up.
+          if (results_.Push(function_(request)) && notify_) {
+            notify_();
+          }
+        }
+        catch (...) {
+        }
+      }
+      signal_.wait(signal, std::memory_order_acquire);
+    }
+  }
+
+  Function function_;
+  Notify notify_;
+  Queue<Request, Capacity> requests_;
+  Queue<Result, Capacity> results_;
+  std::atomic<std::uint32_t> signal_{ 0 };
+  std::jthread thread_;
+};
+
+}  // namespace UT
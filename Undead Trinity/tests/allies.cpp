@@ -0,0 +1,162 @@
+// Ranks allies in the bounded priority queue and checks eviction, updates and pruning.
+#include "test.hpp"
+
+#include <allies.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+Triage::Member Member(float health, float rate = 0.0f, float distance = 0.0f) noexcept
+{
+  return { true, false, health, rate, distance };
+}
+
+// Removes all allies in the order of Top and returns their ids.
+std::vector<std::uint32_t> Drain(Allies& allies)
+{
+  std::vector<std::uint32_t> ids;
+  while (const auto top = allies.Top()) {
+    ids.push_back(top->id);
+    allies.Remove(top->id);
+  }
+  return ids;
+}
+
+void TestScore()
+{
+  constexpr auto Ignored = -std::numeric_limits<float>::infinity();
+  const Triage::Thresholds thresholds;
+
+  // The deficit below the threshold and the predicted damage add up.
+  UT_CHECK_NEAR(Allies::GetScore(Member(0.5f)), 0.1f, 1e-6f);
+  UT_CHECK_NEAR(Allies::GetScore(Member(0.5f, 0.1f)), 0.1f + 0.1f * thresholds.lookahead, 1e-6f);
+  UT_CHECK_NEAR(Allies::GetScore(Member(0.5f, 0.0f, thresholds.range / 2.0f)), 0.1f - Allies::Distance / 2.0f, 1e-6f);
+
+  // Allies above the threshold are only ranked when their predicted health drops below it.
+  UT_CHECK(Allies::GetScore(Member(0.7f)) == Ignored);
+  UT_CHECK(Allies::GetScore(Member(0.7f, 0.1f)) > 0.0f);
+  UT_CHECK(Allies::GetScore(Member(0.5f, -1.0f)) > 0.0f);
+
+  // Absent, dead, out of range and allies below the floor are ignored.
+  UT_CHECK(Allies::GetScore({}) == Ignored);
+  UT_CHECK(Allies::GetScore({ true, true, 0.5f, 0.0f, 0.0f }) == Ignored);
+  UT_CHECK(Allies::GetScore(Member(0.5f, 0.0f, thresholds.range)) == Ignored);
+  UT_CHECK(Allies::GetScore(Member(thresholds.floor)) == Ignored);
+}
+
+void TestTop()
+{
+  // Allies are returned by score regardless of the update order.
+  Allies allies;
+  UT_CHECK(allies.Top() == nullptr);
+  const std::vector<float> health{ 0.45f, 0.2f, 0.55f, 0.3f, 0.5f, 0.25f };
+  for (std::size_t i = 0; i < health.size(); i++) {
+    allies.Update(static_cast<std::uint32_t>(i + 1), Member(health[i]));
+  }
+  UT_CHECK(allies.GetSize() == health.size());
+  UT_CHECK(allies.Top() && allies.Top()->id == 2);
+  UT_CHECK(allies.Top() && allies.Top()->member.health == 0.2f);
+  UT_CHECK((Drain(allies) == std::vector<std::uint32_t>{ 2, 6, 4, 1, 5, 3 }));
+  UT_CHECK(allies.GetSize() == 0);
+}
+
+void TestCapacity()
+{
+  // A full queue keeps the allies with the highest scores.
+  Allies allies;
+  for (std::uint32_t id = 1; id <= Allies::Capacity; id++) {
+    allies.Update(id, Member(0.55f - static_cast<float>(id) * 0.05f));
+  }
+  UT_CHECK(allies.GetSize() == Allies::Capacity);
+
+  // Allies with a lower score than every queued ally are not inserted.
+  allies.Update(100, Member(0.55f));
+  UT_CHECK(allies.GetSize() == Allies::Capacity);
+
+  // Allies with a higher score replace the lowest score.
+  allies.Update(101, Member(0.12f));
+  allies.Update(102, Member(0.42f));
+  UT_CHECK(allies.GetSize() == Allies::Capacity);
+  UT_CHECK((Drain(allies) == std::vector<std::uint32_t>{ 101, 8, 7, 6, 5, 4, 3, 102 }));
+
+  allies.Update(1, Member(0.5f));
+  allies.Clear();
+  UT_CHECK(allies.GetSize() == 0 && allies.Top() == nullptr);
+}
+
+void TestUpdate()
+{
+  Allies allies;
+  for (std::uint32_t id = 1; id <= 5; id++) {
+    allies.Update(id, Member(0.2f + static_cast<float>(id) * 0.05f));
+  }
+  UT_CHECK(allies.Top() && allies.Top()->id == 1);
+
+  // Updates of queued allies move them up or down without duplicates.
+  allies.Update(4, Member(0.15f));
+  UT_CHECK(allies.GetSize() == 5);
+  UT_CHECK(allies.Top() && allies.Top()->id == 4);
+  allies.Update(4, Member(0.5f));
+  UT_CHECK(allies.GetSize() == 5);
+  UT_CHECK(allies.Top() && allies.Top()->id == 1);
+  allies.Update(1, Member(0.48f, 0.0f, 450.0f));
+  UT_CHECK(allies.Top() && allies.Top()->id == 2);
+
+  // Allies that do not need healing anymore are removed.
+  allies.Update(2, Member(1.0f));
+  UT_CHECK(allies.GetSize() == 4);
+  allies.Remove(42);
+  UT_CHECK(allies.GetSize() == 4);
+  UT_CHECK((Drain(allies) == std::vector<std::uint32_t>{ 3, 5, 4, 1 }));
+
+  // Updates of a full queue move queued allies instead of evicting one.
+  for (std::uint32_t id = 1; id <= Allies::Capacity; id++) {
+    allies.Update(id, Member(0.5f));
+  }
+  allies.Update(Allies::Capacity, Member(0.2f));
+  UT_CHECK(allies.GetSize() == Allies::Capacity);
+  UT_CHECK(allies.Top() && allies.Top()->id == Allies::Capacity);
+}
+
+void TestPrune()
+{
+  Allies allies;
+  for (std::uint32_t id = 1; id <= 6; id++) {
+    allies.Update(id, Member(0.2f + static_cast<float>(id) * 0.05f));
+  }
+  allies.Prune();
+  UT_CHECK(allies.GetSize() == 6);
+
+  // Allies that were not sampled since the last call are removed.
+  allies.Update(2, Member(0.3f));
+  allies.Update(5, Member(0.15f));
+  allies.Update(6, Member(0.45f));
+  allies.Prune();
+  UT_CHECK(allies.GetSize() == 3);
+  UT_CHECK((Drain(allies) == std::vector<std::uint32_t>{ 5, 2, 6 }));
+
+  // Pruning resets the sampled state.
+  allies.Update(1, Member(0.3f));
+  allies.Prune();
+  UT_CHECK(allies.GetSize() == 1 && allies.Top() && !allies.Top()->sampled);
+  allies.Prune();
+  UT_CHECK(allies.GetSize() == 0);
+}
+
+}  // namespace
+
+int main()
+{
+  TestScore();
+  TestTop();
+  TestCapacity();
+  TestUpdate();
+  TestPrune();
+  return UT::Test::Result();
+}
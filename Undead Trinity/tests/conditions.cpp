@@ -0,0 +1,59 @@
+// Checks when cached perk condition outcomes are reused and dropped.
+#include "test.hpp"
+
+#include <conditions.hpp>
+
+#include <array>
+
+namespace {
+
+using namespace UT;
+
+void TestCache()
+{
+  Conditions conditions;
+  auto evaluated = 0;
+  auto outcome = true;
+  const auto condition = [&]() {
+    evaluated++;
+    return outcome;
+  };
+
+  // Outcomes are keyed by perk and reused while the skills do not change.
+  const std::array skills{ 15.0f, 20.0f };
+  conditions.Sync(skills);
+  UT_CHECK(conditions.Evaluate(0x000BE126, condition));
+  outcome = false;
+  UT_CHECK(conditions.Evaluate(0x000BE126, condition));
+  UT_CHECK(!conditions.Evaluate(0x000C44B5, condition));
+  UT_CHECK(evaluated == 2);
+  UT_CHECK(conditions.GetSize() == 2);
+
+  // Syncing the same skills keeps the outcomes.
+  conditions.Sync(skills);
+  UT_CHECK(conditions.Evaluate(0x000BE126, condition));
+  UT_CHECK(evaluated == 2);
+
+  // Any skill change drops all outcomes, because conditions can compare other skills.
+  const std::array changed{ 15.0f, 21.0f };
+  conditions.Sync(changed);
+  UT_CHECK(conditions.GetSize() == 0);
+  UT_CHECK(!conditions.Evaluate(0x000BE126, condition));
+  UT_CHECK(evaluated == 3);
+
+  const auto stats = conditions.GetStats();
+  UT_CHECK(stats.hits == 2);
+  UT_CHECK(stats.misses == 3);
+
+  conditions.Clear();
+  UT_CHECK(conditions.GetSize() == 0);
+  UT_CHECK(conditions.GetStats().hits == 0);
+}
+
+}  // namespace
+
+int main()
+{
+  TestCache();
+  return UT::Test::Result();
+}
@@ -0,0 +1,272 @@
+// Parses package rules and checks the decisions of the compiled tables.
+#include "test.hpp"
+
+#include <policy.hpp>
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+using Policy::Class;
+using Policy::Subject;
+
+using Inputs = std::array<Policy::Input, Policy::Subjects>;
+
+// Returns the parse error or an empty string.
+std::string GetError(std::string_view text)
+{
+  try {
+    Policy::Parse(text);
+  }
+  catch (const std::runtime_error& e) {
+    return e.what();
+  }
+  return {};
+}
+
+bool Contains(const std::string& text, std::string_view part) noexcept
+{
+  return text.find(part) != std::string::npos;
+}
+
+// Returns inputs where only the given subject is present.
+Inputs Only(Subject subject, float health, float distance = 0.0f) noexcept
+{
+  Inputs inputs;
+  inputs[static_cast<std::size_t>(subject)] = { true, health, distance };
+  return inputs;
+}
+
+Policy::Rule Rule(Class member, Subject subject, float min, float max, float distance = 0.0f)
+{
+  Policy::Rule rule;
+  rule.member = member;
+  rule.subject = subject;
+  rule.min = min;
+  rule.max = max;
+  rule.distance = distance;
+  rule.form = 0x800;
+  rule.plugin = "Tactics.esp";
+  return rule;
+}
+
+void TestParse()
+{
+  const auto rules = Policy::Parse(
+    "# class subject state min max distance form plugin\n"
+    "\n"
+    "knight player combat 0.0 0.5 1500 0x000D65 My Tactics.esp  # comment\r\n"
+    "  guard  self  peace  0.25  1.5  -  d66  Tactics.esp\n"
+    "warlock warlock any 0 1 - 0XFFFFFF Tactics.esp");
+  UT_CHECK(rules.size() == 3);
+  if (rules.size() != 3) {
+    return;
+  }
+  UT_CHECK(rules[0].member == Class::Knight);
+  UT_CHECK(rules[0].subject == Subject::Player);
+  UT_CHECK(rules[0].combat && !rules[0].peace);
+  UT_CHECK(rules[0].min == 0.0f && rules[0].max == 0.5f);
+  UT_CHECK(rules[0].distance == 1500.0f);
+  UT_CHECK(rules[0].form == 0x000D65);
+  UT_CHECK(rules[0].plugin == "My Tactics.esp");
+  UT_CHECK(rules[0].line == 3);
+
+  UT_CHECK(rules[1].member == Class::Guard);
+  UT_CHECK(rules[1].subject == Subject::Self);
+  UT_CHECK(!rules[1].combat && rules[1].peace);
+  UT_CHECK(rules[1].min == 0.25f && rules[1].max == 1.5f);
+  UT_CHECK(rules[1].distance == 0.0f);
+  UT_CHECK(rules[1].form == 0x000D66);
+  UT_CHECK(rules[1].line == 4);
+
+  UT_CHECK(rules[2].combat && rules[2].peace);
+  UT_CHECK(rules[2].form == 0xFFFFFF);
+  UT_CHECK(rules[2].plugin == "Tactics.esp");
+  UT_CHECK(rules[2].line == 5);
+
+  UT_CHECK(Policy::Parse("").empty());
+  UT_CHECK(Policy::Parse("# only comments\n\n   \n").empty());
+}
+
+void TestErrors()
+{
+  // Errors name the line of the rule, counting empty and comment lines.
+  const auto error = GetError("# comment\n\nzombie self any 0 1 - 0x800 Tactics.esp\n");
+  UT_CHECK(Contains(error, "line 3"));
+  UT_CHECK(Contains(error, "Unknown class"));
+  UT_CHECK(Contains(error, "'zombie'"));
+
+  const std::string valid{ "guard self any 0 1 - 0x800 Tactics.esp\n" };
+  const auto check = [&](std::string_view rule, std::string_view message) {
+    const auto error = GetError(valid + std::string{ rule });
+    UT_CHECK(Contains(error, "line 2"));
+    UT_CHECK(Contains(error, message));
+  };
+  check("guard ally any 0 1 - 0x800 Tactics.esp", "Unknown subject");
+  check("guard self fight 0 1 - 0x800 Tactics.esp", "Unknown state");
+  check("guard self any low 1 - 0x800 Tactics.esp", "Invalid min health");
+  check("guard self any -0.5 1 - 0x800 Tactics.esp", "Invalid min health");
+  check("guard self any 0 1x - 0x800 Tactics.esp", "Invalid max health");
+  check("guard self any 0.5 0.5 - 0x800 Tactics.esp", "Empty health range");
+  check("guard self any 0.5 0.25 - 0x800 Tactics.esp", "Empty health range");
+  check("guard self any 0 1 0 0x800 Tactics.esp", "Invalid distance");
+  check("guard self any 0 1 far 0x800 Tactics.esp", "Invalid distance");
+  check("guard self any 0 1 - 0x1000000 Tactics.esp", "Invalid form id");
+  check("guard self any 0 1 - 0xZZ Tactics.esp", "Invalid form id");
+  check("guard self any 0 1 - 0x Tactics.esp", "Invalid form id");
+  check("guard self any 0 1 - 0x800", "Missing plugin");
+  check("guard self any 0 1 - 0x800 # Tactics.esp", "Missing plugin");
+  check("guard", "Unknown subject");
+}
+
+void TestBuckets()
+{
+  const std::vector rules{ Rule(Class::Guard, Subject::Self, 0.25f, 0.5f) };
+  const Policy::Table table{ Class::Guard, rules };
+  UT_CHECK(table.GetRules() == std::vector<std::size_t>{ 0 });
+
+  // Health ranges include the minimum and exclude the maximum.
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 0.2499f)) == Policy::None);
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 0.25f)) == 0);
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 0.4999f)) == 0);
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 0.5f)) == Policy::None);
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 1.0f)) == Policy::None);
+
+  // The distance is a maximum and is ignored when the rule has none.
+  const std::vector limited{
+    Rule(Class::Guard, Subject::Player, 0.0f, 0.5f, 1000.0f),
+    Rule(Class::Guard, Subject::Player, 0.5f, 2.0f),
+  };
+  const Policy::Table distance{ Class::Guard, limited };
+  UT_CHECK(distance.Evaluate(false, Only(Subject::Player, 0.3f, 0.0f)) == 0);
+  UT_CHECK(distance.Evaluate(false, Only(Subject::Player, 0.3f, 999.0f)) == 0);
+  UT_CHECK(distance.Evaluate(false, Only(Subject::Player, 0.3f, 1000.0f)) == Policy::None);
+  UT_CHECK(distance.Evaluate(false, Only(Subject::Player, 1.0f, 1e6f)) == 1);
+
+  // Absent subjects never match.
+  auto inputs = Only(Subject::Player, 0.3f);
+  inputs[static_cast<std::size_t>(Subject::Player)].present = false;
+  UT_CHECK(distance.Evaluate(false, inputs) == Policy::None);
+
+  // Tables without rules never match.
+  const Policy::Table empty;
+  UT_CHECK(empty.Evaluate(true, Only(Subject::Self, 0.0f)) == Policy::None);
+}
+
+void TestOrder()
+{
+  // Rules of other classes are skipped, and the returned index refers to all rules.
+  const std::vector rules{
+    Rule(Class::Knight, Subject::Player, 0.0f, 1.0f),
+    Rule(Class::Guard, Subject::Warlock, 0.0f, 0.5f),
+    Rule(Class::Guard, Subject::Player, 0.0f, 0.5f),
+    Rule(Class::Guard, Subject::Warlock, 0.0f, 0.75f),
+    Rule(Class::Guard, Subject::Self, 0.0f, 2.0f),
+  };
+  const Policy::Table table{ Class::Guard, rules };
+  UT_CHECK((table.GetRules() == std::vector<std::size_t>{ 1, 2, 3, 4 }));
+
+  // The first rule wins across all subjects, not the first subject.
+  Inputs inputs;
+  inputs[static_cast<std::size_t>(Subject::Player)] = { true, 0.3f, 0.0f };
+  inputs[static_cast<std::size_t>(Subject::Warlock)] = { true, 0.3f, 0.0f };
+  inputs[static_cast<std::size_t>(Subject::Self)] = { true, 1.0f, 0.0f };
+  UT_CHECK(table.Evaluate(true, inputs) == 1);
+  inputs[static_cast<std::size_t>(Subject::Warlock)].health = 0.6f;
+  UT_CHECK(table.Evaluate(true, inputs) == 2);
+  inputs[static_cast<std::size_t>(Subject::Player)].health = 0.8f;
+  UT_CHECK(table.Evaluate(true, inputs) == 3);
+  inputs[static_cast<std::size_t>(Subject::Warlock)].health = 0.8f;
+  UT_CHECK(table.Evaluate(true, inputs) == 4);
+  inputs[static_cast<std::size_t>(Subject::Self)].present = false;
+  UT_CHECK(table.Evaluate(true, inputs) == Policy::None);
+
+  const Policy::Table knight{ Class::Knight, rules };
+  UT_CHECK(knight.Evaluate(true, Only(Subject::Player, 0.9f)) == 0);
+  UT_CHECK(knight.Evaluate(true, Only(Subject::Self, 0.9f)) == Policy::None);
+}
+
+void TestState()
+{
+  auto combat = Rule(Class::Warlock, Subject::Self, 0.0f, 0.5f);
+  combat.peace = false;
+  auto peace = Rule(Class::Warlock, Subject::Self, 0.0f, 0.5f);
+  peace.combat = false;
+  const auto any = Rule(Class::Warlock, Subject::Self, 0.0f, 0.5f);
+
+  const std::vector rules{ combat, peace, any };
+  const Policy::Table table{ Class::Warlock, rules };
+  UT_CHECK(table.Evaluate(true, Only(Subject::Self, 0.1f)) == 0);
+  UT_CHECK(table.Evaluate(false, Only(Subject::Self, 0.1f)) == 1);
+
+  const std::vector combatOnly{ combat };
+  const Policy::Table masked{ Class::Warlock, combatOnly };
+  UT_CHECK(masked.Evaluate(true, Only(Subject::Self, 0.1f)) == 0);
+  UT_CHECK(masked.Evaluate(false, Only(Subject::Self, 0.1f)) == Policy::None);
+
+  const std::vector anyOnly{ any };
+  const Policy::Table both{ Class::Warlock, anyOnly };
+  UT_CHECK(both.Evaluate(true, Only(Subject::Self, 0.1f)) == 0);
+  UT_CHECK(both.Evaluate(false, Only(Subject::Self, 0.1f)) == 0);
+}
+
+bool Throws(Class member, const std::vector<Policy::Rule>& rules)
+{
+  try {
+    Policy::Table{ member, rules };
+  }
+  catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+void TestLimits()
+{
+  // Rules that share their limits only count once.
+  std::vector<Policy::Rule> rules(Policy::Rules, Rule(Class::Guard, Subject::Self, 0.0f, 0.5f, 100.0f));
+  UT_CHECK(!Throws(Class::Guard, rules));
+  rules.push_back(rules.back());
+  UT_CHECK(Throws(Class::Guard, rules));
+  UT_CHECK(!Throws(Class::Knight, rules));
+
+  // Adjacent health ranges share a limit, so 14 ranges use 15 limits.
+  std::vector<Policy::Rule> health;
+  for (std::size_t i = 0; i < Policy::Limits - 1; i++) {
+    const auto min = static_cast<float>(i) * 0.0625f;
+    health.push_back(Rule(Class::Knight, Subject::Self, min, min + 0.0625f));
+  }
+  UT_CHECK(!Throws(Class::Knight, health));
+  const Policy::Table ranges{ Class::Knight, health };
+  UT_CHECK(ranges.Evaluate(false, Only(Subject::Self, 0.66f)) == 10);
+  UT_CHECK(ranges.Evaluate(false, Only(Subject::Self, 0.875f)) == Policy::None);
+  health.push_back(Rule(Class::Knight, Subject::Self, 0.9f, 0.95f));
+  UT_CHECK(Throws(Class::Knight, health));
+
+  std::vector<Policy::Rule> distance;
+  for (std::size_t i = 0; i < Policy::Limits; i++) {
+    distance.push_back(Rule(Class::Warlock, Subject::Player, 0.0f, 1.0f, static_cast<float>(i + 1) * 100.0f));
+  }
+  UT_CHECK(!Throws(Class::Warlock, distance));
+  distance.push_back(Rule(Class::Warlock, Subject::Player, 0.0f, 1.0f, 5000.0f));
+  UT_CHECK(Throws(Class::Warlock, distance));
+}
+
+}  // namespace
+
+int main()
+{
+  TestParse();
+  TestErrors();
+  TestBuckets();
+  TestOrder();
+  TestState();
+  TestLimits();
+  return UT::Test::Result();
+}
@@ -0,0 +1,220 @@
+// Writes recordings through a temporary file and checks that they decode to the same frames.
+#include "test.hpp"
+
+#include <record.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+using Target = Triage::Target;
+
+// Writes the frames to a temporary file and returns its contents.
+std::vector<std::uint8_t> Write(std::span<const Record::Frame> frames)
+{
+  const auto path = std::filesystem::temp_directory_path() / "undead_trinity_test_record.utr";
+  {
+    Record::Writer writer;
+    UT_CHECK(writer.Open(path));
+    UT_CHECK(writer.IsOpen());
+    for (const auto& frame : frames) {
+      writer.Write(frame);
+    }
+  }
+  std::ifstream file{ path, std::ios::binary };
+  std::vector<std::uint8_t> data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+  file.close();
+  std::filesystem::remove(path);
+  return data;
+}
+
+Record::Member Member(float health, float x, float y, float z, bool dead = false) noexcept
+{
+  return { true, dead, health, 0.0f, { x, y, z } };
+}
+
+std::vector<Record::Frame> GetFrames()
+{
+  std::vector<Record::Frame> frames;
+
+  // The knight is not summoned.
+  auto& first = frames.emplace_back();
+  first.time = 100.0;
+  first.target = Target::None;
+  first.members[Record::GetIndex(Target::Player)] = Member(1.0f, 100.0f, 200.0f, -50.0f);
+  first.members[Record::GetIndex(Target::Warlock)] = Member(0.5f, 110.0f, 190.0f, -50.0f);
+  first.members[Record::GetIndex(Target::Guard)] = Member(0.75f, 90.0f, 210.0f, -50.0f);
+
+  // Positions move back by more than they were before, health is clamped and the guard is healed.
+  auto second = first;
+  second.time = 100.25;
+  second.combat = true;
+  second.target = Target::Guard;
+  second.members[Record::GetIndex(Target::Player)] = Member(1.5f, -250.4f, 200.0f, -1200.6f);
+  second.members[Record::GetIndex(Target::Guard)] = Member(-0.2f, 90.0f, 210.0f, -50.0f, true);
+  frames.push_back(second);
+
+  // An ally takes damage and is healed.
+  auto ally = second;
+  ally.time = 100.28;
+  ally.target = Target::Ally;
+  ally.members[Record::GetIndex(Target::Ally)] = Member(0.3f, 300.0f, -400.0f, -50.0f);
+  ally.members[Record::GetIndex(Target::Ally)].rate = 0.2f;
+  frames.push_back(ally);
+
+  // Hits are recorded for the absent knight as well.
+  auto hit = ally;
+  hit.kind = Record::Kind::Hit;
+  hit.time = 100.3;
+  hit.member = static_cast<std::uint8_t>(Record::GetIndex(Target::Knight));
+  hit.source = 0x0001A2B3;
+  hit.members[hit.member].health = 0.25f;
+  frames.push_back(hit);
+
+  hit.time = 100.35;
+  hit.member = static_cast<std::uint8_t>(Record::GetIndex(Target::Warlock));
+  hit.source = 0xFF000800;
+  hit.members[hit.member].health = 0.125f;
+  frames.push_back(hit);
+
+  // Members that did not change are not stored.
+  auto unchanged = hit;
+  unchanged.kind = Record::Kind::Update;
+  unchanged.time = 101.0;
+  unchanged.combat = false;
+  unchanged.target = Target::None;
+  frames.push_back(unchanged);
+  return frames;
+}
+
+void TestRoundTrip()
+{
+  const auto frames = GetFrames();
+  const auto data = Write(frames);
+  Record::Reader reader{ data };
+  UT_CHECK(reader.Valid());
+
+  constexpr auto Step = 1.0f / 65535.0f;
+  Record::Frame frame;
+  std::size_t count = 0;
+  while (reader.Next(frame)) {
+    if (count >= frames.size()) {
+      count++;
+      break;
+    }
+    const auto& expected = frames[count];
+    UT_CHECK(frame.kind == expected.kind);
+    UT_CHECK(frame.combat == expected.combat);
+    UT_CHECK_NEAR(frame.time, expected.time - frames.front().time, 1e-9);
+    if (frame.kind == Record::Kind::Hit) {
+      UT_CHECK(frame.member == expected.member);
+      UT_CHECK(frame.source == expected.source);
+      UT_CHECK(frame.target == Target::None);
+    } else {
+      UT_CHECK(frame.target == expected.target);
+    }
+    count++;
+  }
+  UT_CHECK(count == frames.size());
+  UT_CHECK(reader.Valid());
+
+  // The last frame holds the full party state. Health is quantized to 1/65535 and clamped,
+  // and positions to whole units.
+  const auto& player = frame.members[Record::GetIndex(Target::Player)];
+  const auto& warlock = frame.members[Record::GetIndex(Target::Warlock)];
+  const auto& knight = frame.members[Record::GetIndex(Target::Knight)];
+  const auto& guard = frame.members[Record::GetIndex(Target::Guard)];
+  UT_CHECK(player.present && !player.dead);
+  UT_CHECK_NEAR(player.health, 1.0f, 0.0f);
+  UT_CHECK_NEAR(player.position[0], -250.0f, 0.0f);
+  UT_CHECK_NEAR(player.position[1], 200.0f, 0.0f);
+  UT_CHECK_NEAR(player.position[2], -1201.0f, 0.0f);
+  UT_CHECK_NEAR(warlock.health, 0.125f, Step / 2.0f);
+  UT_CHECK(warlock.health != 0.125f);
+  UT_CHECK(!knight.present);
+  UT_CHECK_NEAR(knight.health, 0.25f, Step / 2.0f);
+  UT_CHECK(guard.present && guard.dead);
+  UT_CHECK_NEAR(guard.health, 0.0f, 0.0f);
+
+  // The ally is the only member with a recorded rate.
+  const auto& ally = frame.members[Record::GetIndex(Target::Ally)];
+  UT_CHECK(ally.present && !ally.dead);
+  UT_CHECK_NEAR(ally.health, 0.3f, Step / 2.0f);
+  UT_CHECK_NEAR(ally.rate, 0.2f, Step / 2.0f);
+  UT_CHECK_NEAR(ally.position[1], -400.0f, 0.0f);
+  UT_CHECK_NEAR(player.rate, 0.0f, 0.0f);
+}
+
+void TestQuantization()
+{
+  // Every step of the health encoding survives a round trip.
+  std::vector<Record::Frame> frames;
+  for (auto step : { 0, 1, 2, 32767, 32768, 65534, 65535 }) {
+    auto& frame = frames.emplace_back();
+    frame.time = static_cast<double>(frames.size());
+    frame.members[0] = Member(static_cast<float>(step) / 65535.0f, 0.0f, 0.0f, 0.0f);
+  }
+  const auto data = Write(frames);
+  Record::Reader reader{ data };
+  Record::Frame frame;
+  for (const auto& expected : frames) {
+    UT_CHECK(reader.Next(frame));
+    UT_CHECK(frame.members[0].health == expected.members[0].health);
+  }
+  UT_CHECK(!reader.Next(frame));
+  UT_CHECK(reader.Valid());
+}
+
+void TestTruncated()
+{
+  const auto frames = GetFrames();
+  const auto data = Write(frames);
+
+  // Sizes of the recording after every frame.
+  std::vector<std::size_t> boundaries;
+  for (std::size_t i = 0; i <= frames.size(); i++) {
+    boundaries.push_back(Write(std::span{ frames }.first(i)).size());
+  }
+  UT_CHECK(boundaries.front() == 8);
+  UT_CHECK(boundaries.back() == data.size());
+
+  // A recording that ends inside a frame is invalid and returns no partial frame.
+  for (std::size_t size = 8; size < data.size(); size++) {
+    Record::Reader reader{ std::span{ data }.first(size) };
+    UT_CHECK(reader.Valid());
+    Record::Frame frame;
+    std::size_t count = 0;
+    while (reader.Next(frame)) {
+      count++;
+    }
+    UT_CHECK(boundaries[count] <= size && size < boundaries[count + 1]);
+    UT_CHECK(reader.Valid() == (size == boundaries[count]));
+  }
+
+  // Headers that are too short or from a newer version are rejected, older versions are read.
+  UT_CHECK(!Record::Reader{ std::span{ data }.first(7) }.Valid());
+  auto other = data;
+  other[4] = static_cast<std::uint8_t>(Record::Version + 1);
+  UT_CHECK(!Record::Reader{ other }.Valid());
+  other[4] = 0;
+  UT_CHECK(!Record::Reader{ other }.Valid());
+  other[4] = 1;
+  UT_CHECK(Record::Reader{ other }.Valid());
+}
+
+}  // namespace
+
+int main()
+{
+  TestRoundTrip();
+  TestQuantization();
+  TestTruncated();
+  return UT::Test::Result();
+}
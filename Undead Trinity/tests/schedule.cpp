@@ -0,0 +1,143 @@
+// Runs the scheduler against a simulated frame clock and checks that it keeps to the budget.
+#include "test.hpp"
+
+#include <schedule.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using namespace UT;
+using Priority = Scheduler::Priority;
+
+// Simulated clock in microseconds that only advances when a job runs.
+struct Frame {
+  std::int64_t now{ 0 };
+  std::string order;
+
+  // Returns a job that takes the given number of microseconds.
+  Scheduler::Job Job(char name, std::int64_t duration)
+  {
+    return [this, name, duration]() {
+      order += name;
+      now += duration;
+      return true;
+    };
+  }
+};
+
+void TestBudget()
+{
+  Frame frame;
+  Scheduler scheduler{ [&]() { return frame.now; } };
+  for (auto i = 0; i < 10; i++) {
+    scheduler.Post(Priority::Low, frame.Job('l', 300));
+  }
+
+  // The budget is checked after every job, so the job that crosses it still runs.
+  UT_CHECK(scheduler.Run(1000));
+  UT_CHECK(frame.order == "llll");
+  UT_CHECK(frame.now == 1200);
+
+  // Low priority work stops at the budget in every frame until the queue is empty.
+  frame.order.clear();
+  UT_CHECK(scheduler.Run(1000));
+  UT_CHECK(frame.order == "llll");
+  frame.order.clear();
+  UT_CHECK(!scheduler.Run(1000));
+  UT_CHECK(frame.order == "ll");
+  UT_CHECK(scheduler.Empty());
+}
+
+void TestPriority()
+{
+  Frame frame;
+  Scheduler scheduler{ [&]() { return frame.now; } };
+  for (auto i = 0; i < 4; i++) {
+    scheduler.Post(Priority::Low, frame.Job('l', 400));
+    scheduler.Post(Priority::Normal, frame.Job('n', 400));
+  }
+  scheduler.Post(Priority::High, frame.Job('h', 400));
+
+  // Higher priorities run first.
+  UT_CHECK(scheduler.Run(1000));
+  UT_CHECK(frame.order == "hnn");
+
+  // High priority work posted after the budget was spent runs first in the next frame.
+  scheduler.Post(Priority::High, frame.Job('h', 400));
+  frame.order.clear();
+  UT_CHECK(scheduler.Run(1000));
+  UT_CHECK(frame.order == "hnn");
+
+  // The first job always runs, even without a budget.
+  scheduler.Post(Priority::High, frame.Job('h', 400));
+  frame.order.clear();
+  UT_CHECK(scheduler.Run(0));
+  UT_CHECK(frame.order == "h");
+}
+
+void TestOverrun()
+{
+  // A long job is not interrupted and overruns the budget, but no other job runs after it.
+  Frame frame;
+  Scheduler scheduler{ [&]() { return frame.now; } };
+  scheduler.Post(Priority::High, frame.Job('L', 5000));
+  scheduler.Post(Priority::High, frame.Job('h', 100));
+  UT_CHECK(scheduler.Run(1000));
+  UT_CHECK(frame.order == "L");
+  UT_CHECK(frame.now == 5000);
+  frame.order.clear();
+  UT_CHECK(!scheduler.Run(1000));
+  UT_CHECK(frame.order == "h");
+}
+
+void TestJobs()
+{
+  Frame frame;
+  Scheduler scheduler{ [&]() { return frame.now; } };
+
+  // Jobs that yield are queued again behind the jobs of the same priority.
+  auto runs = 0;
+  scheduler.Post(Priority::Normal, [&]() {
+    frame.order += 'y';
+    frame.now += 100;
+    return ++runs == 2;
+  });
+  scheduler.Post(Priority::Normal, frame.Job('n', 100));
+
+  // Jobs that throw are dropped.
+  scheduler.Post(Priority::Normal, [&]() -> bool {
+    frame.order += 't';
+    frame.now += 100;
+    throw std::runtime_error("job");
+  });
+
+  // Jobs can post new jobs, which run in the same frame when the budget allows.
+  scheduler.Post(Priority::Low, [&]() {
+    frame.order += 'p';
+    scheduler.Post(Priority::High, frame.Job('h', 100));
+    return true;
+  });
+
+  UT_CHECK(!scheduler.Run(1000));
+  UT_CHECK(frame.order == "yntyph");
+  UT_CHECK(runs == 2);
+
+  scheduler.Post(Priority::Low, frame.Job('l', 100));
+  scheduler.Clear();
+  UT_CHECK(scheduler.Empty());
+  UT_CHECK(!scheduler.Run(1000));
+}
+
+}  // namespace
+
+int main()
+{
+  TestBudget();
+  TestPriority();
+  TestOverrun();
+  TestJobs();
+  return UT::Test::Result();
+}
@@ -0,0 +1,95 @@
+// Reads and writes snapshots from many threads. Built with the thread sanitizer where it is available.
+#include "test.hpp"
+
+#include <snapshot.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+// Writers keep every value equal to the version, so a torn or deleted version is detected.
+struct Value {
+  std::uint64_t version{ 0 };
+  std::vector<std::uint64_t> values = std::vector<std::uint64_t>(16);
+};
+
+template <std::size_t Slots>
+void Stress(std::size_t readers, std::size_t writers, std::uint64_t writes, bool nested)
+{
+  Snapshot<Value, Slots> snapshot;
+  std::atomic_bool done{ false };
+  std::atomic_size_t failures{ 0 };
+  std::atomic_size_t reads{ 0 };
+  {
+    std::vector<std::jthread> threads;
+    for (std::size_t i = 0; i < readers; i++) {
+      threads.emplace_back([&]() {
+        std::uint64_t last = 0;
+        std::size_t count = 0;
+        while (!done.load()) {
+          const auto reader = snapshot.Read();
+          if (reader->version < last) {
+            failures++;
+          }
+          last = reader->version;
+          for (const auto value : reader->values) {
+            if (value != last) {
+              failures++;
+            }
+          }
+
+          // Nested readers pin a second slot.
+          if (nested && snapshot.Read()->version < last) {
+            failures++;
+          }
+          count++;
+        }
+        reads += count;
+      });
+    }
+    {
+      std::vector<std::jthread> workers;
+      for (std::size_t i = 0; i < writers; i++) {
+        workers.emplace_back([&]() {
+          for (std::uint64_t j = 0; j < writes; j++) {
+            snapshot.Write([](Value& value) {
+              value.version++;
+              for (auto& e : value.values) {
+                e = value.version;
+              }
+            });
+            if (j % 16 == 0) {
+              snapshot.Reclaim();
+            }
+          }
+        });
+      }
+    }
+    done = true;
+  }
+  UT_CHECK(failures == 0);
+  UT_CHECK(reads > 0);
+  UT_CHECK(snapshot.Read()->version == writers * writes);
+}
+
+}  // namespace
+
+int main()
+{
+  const auto threads = std::max(std::thread::hardware_concurrency(), 2u);
+
+  // Enough slots for every reader.
+  Stress<64>(std::min(threads, 32u), 2, 2000, true);
+
+  // More readers than slots, so that Read has to wait for a free slot. Readers are not nested,
+  // because threads that all hold a slot while they wait for another one never finish.
+  Stress<4>(8, 2, 500, false);
+  return UT::Test::Result();
+}
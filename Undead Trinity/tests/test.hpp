@@ -0,0 +1,34 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace UT::Test {
+
+// Number of failed checks in the test executable.
+inline int Failures = 0;
+
+inline void Check(bool condition, const char* expression, const char* file, int line) noexcept
+{
+  if (!condition) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    Failures++;
+  }
+}
+
+inline int Result() noexcept
+{
+  if (Failures) {
+    std::fprintf(stderr, "%d checks failed\n", Failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+}  // namespace UT::Test
+
+#define UT_CHECK(condition) UT::Test::Check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#define UT_CHECK_NEAR(value, expected, tolerance) \
+  UT::Test::Check( \
+    std::abs((value) - (expected)) <= (tolerance), #value " near " #expected, __FILE__, __LINE__)
@@ -0,0 +1,184 @@
+// Tracks, audits and reclaims references and checks the table layout after every step.
+#include "test.hpp"
+
+#include <tracker.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+using Kind = Tracker::Kind;
+using State = Tracker::State;
+
+// Returns the number of entries that OnSave writes. It must match the size in the record.
+std::size_t Count(const Tracker& tracker) noexcept
+{
+  std::size_t count = 0;
+  for (const auto& entry : tracker.GetEntries()) {
+    if (entry.kind != Kind::None) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Returns the ids of the entries including holes with the id 0.
+std::vector<std::uint32_t> GetIds(const Tracker& tracker)
+{
+  std::vector<std::uint32_t> ids;
+  for (const auto& entry : tracker.GetEntries()) {
+    ids.push_back(entry.id);
+  }
+  return ids;
+}
+
+void TestHoles()
+{
+  Tracker tracker;
+  for (std::uint32_t id = 1; id <= 4; id++) {
+    tracker.Track(id, Kind::Actor);
+  }
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 2, 3, 4 }));
+
+  // Removed entries leave a hole and the other entries keep their index.
+  tracker.Untrack(2);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 0, 3, 4 }));
+  UT_CHECK(tracker.GetEntries()[1].kind == Kind::None);
+  UT_CHECK(tracker.GetSize() == 3 && Count(tracker) == 3);
+
+  // The next reference fills the hole.
+  tracker.Track(5, Kind::Visual);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 5, 3, 4 }));
+  UT_CHECK(tracker.GetEntries()[1].kind == Kind::Visual);
+
+  // Tracking a reference again updates it in place.
+  tracker.Track(3, Kind::Visual);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 5, 3, 4 }));
+  UT_CHECK(tracker.GetEntries()[2].kind == Kind::Visual);
+  UT_CHECK(tracker.GetSize() == 4 && Count(tracker) == 4);
+
+  // Unknown references are ignored.
+  tracker.Untrack(42);
+  UT_CHECK(tracker.GetSize() == 4 && Count(tracker) == 4);
+
+  tracker.Clear();
+  UT_CHECK(tracker.GetEntries().empty() && tracker.GetSize() == 0);
+}
+
+void TestTrim()
+{
+  Tracker tracker;
+  for (std::uint32_t id = 1; id <= 6; id++) {
+    tracker.Track(id, Kind::Actor);
+  }
+  tracker.Untrack(2);
+  tracker.Untrack(4);
+  tracker.Untrack(5);
+
+  // Removing the last entry also removes the holes before it, and their indices are not reused.
+  tracker.Untrack(6);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 0, 3 }));
+  UT_CHECK(tracker.GetSize() == 2 && Count(tracker) == 2);
+  tracker.Track(7, Kind::Actor);
+  tracker.Track(8, Kind::Actor);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 1, 7, 3, 8 }));
+
+  tracker.Untrack(8);
+  tracker.Untrack(3);
+  tracker.Untrack(7);
+  tracker.Untrack(1);
+  UT_CHECK(tracker.GetEntries().empty());
+  UT_CHECK(tracker.GetSize() == 0 && Count(tracker) == 0);
+  tracker.Track(9, Kind::Visual);
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 9 }));
+}
+
+void TestAudit()
+{
+  Tracker tracker;
+  for (std::uint32_t id = 1; id <= 6; id++) {
+    tracker.Track(id, id % 2 ? Kind::Actor : Kind::Visual);
+  }
+  tracker.Untrack(3);
+
+  // Holes are not passed to the predicate.
+  std::size_t calls = 0;
+  const auto even = [&](const Tracker::Entry& entry) {
+    calls++;
+    return entry.id % 2 == 0;
+  };
+  UT_CHECK(tracker.Audit(even) == 2);
+  UT_CHECK(calls == 5);
+  UT_CHECK(tracker.GetEntries()[0].state == State::Orphaned);
+  UT_CHECK(tracker.GetEntries()[1].state == State::Owned);
+
+  // Orphaned entries stay orphaned until they are tracked again.
+  UT_CHECK(tracker.Audit([](const Tracker::Entry&) { return true; }) == 2);
+  tracker.Track(1, Kind::Actor);
+  UT_CHECK(tracker.GetEntries()[0].state == State::Owned);
+  UT_CHECK(tracker.Audit([](const Tracker::Entry&) { return true; }) == 1);
+  UT_CHECK(tracker.Audit([](const Tracker::Entry&) { return false; }) == 5);
+}
+
+void TestReclaim()
+{
+  Tracker tracker;
+  for (std::uint32_t id = 100; id < 110; id++) {
+    tracker.Track(id, Kind::Actor);
+  }
+  UT_CHECK(tracker.Audit([](const Tracker::Entry& entry) { return entry.id == 105; }) == 9);
+
+  // Every call visits up to the budget of orphaned entries after the previous call. Owned entries
+  // and holes do not count against the budget. Entry 101 can not be reclaimed yet.
+  std::vector<std::uint32_t> visited;
+  const auto reclaim = [&](const Tracker::Entry& entry) {
+    UT_CHECK(entry.state == State::Orphaned);
+    visited.push_back(entry.id);
+    return entry.id != 101;
+  };
+  UT_CHECK(tracker.Reclaim(3, reclaim));
+  UT_CHECK((visited == std::vector<std::uint32_t>{ 101, 102, 103 }));
+  UT_CHECK(tracker.GetSize() == 8 && Count(tracker) == 8);
+
+  visited.clear();
+  UT_CHECK(tracker.Reclaim(3, reclaim));
+  UT_CHECK((visited == std::vector<std::uint32_t>{ 104, 106, 107 }));
+
+  // Removing the last entry trims the table to entry 105 and the cursor wraps around to entry 100.
+  visited.clear();
+  UT_CHECK(tracker.Reclaim(3, reclaim));
+  UT_CHECK((visited == std::vector<std::uint32_t>{ 108, 109, 100 }));
+  UT_CHECK((GetIds(tracker) == std::vector<std::uint32_t>{ 0, 101, 0, 0, 0, 105 }));
+  UT_CHECK(tracker.GetSize() == 2 && Count(tracker) == 2);
+
+  // Entries that could not be reclaimed are visited again.
+  visited.clear();
+  UT_CHECK(tracker.Reclaim(3, reclaim));
+  UT_CHECK((visited == std::vector<std::uint32_t>{ 101 }));
+
+  // A pass without orphaned entries returns false.
+  tracker.Track(101, Kind::Actor);
+  visited.clear();
+  UT_CHECK(!tracker.Reclaim(3, reclaim));
+  UT_CHECK(visited.empty());
+  UT_CHECK(tracker.GetSize() == 2 && Count(tracker) == 2);
+
+  // A budget of zero visits nothing.
+  tracker.Audit([](const Tracker::Entry&) { return false; });
+  UT_CHECK(!tracker.Reclaim(0, reclaim));
+  UT_CHECK(visited.empty());
+}
+
+}  // namespace
+
+int main()
+{
+  TestHoles();
+  TestTrim();
+  TestAudit();
+  TestReclaim();
+  return UT::Test::Result();
+}
@@ -0,0 +1,176 @@
+// Runs fixed damage traces through the health estimator and checks the heal target order.
+#include "test.hpp"
+
+#include <health.hpp>
+#include <triage.hpp>
+
+#include <limits>
+
+namespace {
+
+using namespace UT;
+
+// Samples a trace that loses the given health ratio per second every half second.
+float Run(Health& health, double start, double end, float value, float rate) noexcept
+{
+  for (auto time = start; time <= end + 1e-6; time += 0.5) {
+    health.Sample(time, value - static_cast<float>(time - start) * rate);
+  }
+  return value - static_cast<float>(end - start) * rate;
+}
+
+void TestEstimator()
+{
+  // The first sample has no slope, every other sample moves the average by the smoothing weight.
+  Health health;
+  health.Sample(0.0, 1.0f);
+  UT_CHECK_NEAR(health.GetRate(), 0.0f, 1e-6f);
+  health.Sample(0.5, 0.975f);
+  UT_CHECK_NEAR(health.GetRate(), Health::Smoothing * 0.05f, 1e-5f);
+  Run(health, 1.0, 10.0, 0.95f, 0.05f);
+  UT_CHECK_NEAR(health.GetRate(), 0.05f, 1e-4f);
+  UT_CHECK_NEAR(health.GetValue(), 0.5f, 1e-6f);
+
+  // Burst damage leaves the window and the rate decays.
+  health.Reset();
+  const auto value = Run(health, 0.0, 4.0, 1.0f, 0.2f);
+  UT_CHECK(health.GetRate() > 0.15f);
+  Run(health, 4.5, 14.0, value, 0.0f);
+  UT_CHECK_NEAR(health.GetRate(), 0.0f, 1e-3f);
+
+  // Healing is a negative rate.
+  health.Reset();
+  Run(health, 0.0, 4.0, 0.2f, -0.1f);
+  UT_CHECK(health.GetRate() < -0.09f);
+
+  // A hit event and an update at the same time are one sample.
+  health.Reset();
+  health.Sample(1.0, 0.8f);
+  health.Sample(1.005, 0.7f);
+  UT_CHECK_NEAR(health.GetValue(), 0.7f, 1e-6f);
+  UT_CHECK_NEAR(health.GetRate(), 0.0f, 1e-6f);
+
+  health.Reset();
+  UT_CHECK_NEAR(health.GetValue(), 1.0f, 1e-6f);
+}
+
+Triage::Member Member(float health, float rate = 0.0f, float distance = 300.0f) noexcept
+{
+  return { true, false, health, rate, distance };
+}
+
+Triage::Party Party() noexcept
+{
+  Triage::Party party;
+  party.combat = true;
+  party.player = Member(1.0f, 0.0f, 0.0f);
+  party.warlock = Member(1.0f);
+  return party;
+}
+
+void TestTime()
+{
+  UT_CHECK_NEAR(Triage::GetTime(Member(0.5f, 0.1f), 0.6f), 0.0f, 1e-6f);
+  UT_CHECK_NEAR(Triage::GetTime(Member(0.8f, 0.1f), 0.6f), 2.0f, 1e-5f);
+  UT_CHECK(Triage::GetTime(Member(0.8f), 0.6f) == std::numeric_limits<float>::infinity());
+  UT_CHECK(Triage::GetTime(Member(0.8f, -0.1f), 0.6f) == std::numeric_limits<float>::infinity());
+}
+
+void TestSelect()
+{
+  using Triage::Target;
+
+  auto party = Party();
+  UT_CHECK(Triage::Select(party) == Target::None);
+
+  // Members below their threshold rank before members that are predicted to drop below it.
+  party.player = Member(0.95f, 0.1f, 0.0f);
+  party.knight = Member(0.7f);
+  UT_CHECK(Triage::Select(party) == Target::Knight);
+
+  // The member that drops below its threshold first is healed first.
+  party = Party();
+  party.player = Member(0.95f, 0.1f, 0.0f);
+  party.guard = Member(0.7f, 0.1f);
+  UT_CHECK(Triage::Select(party) == Target::Player);
+  party.guard = Member(0.7f, 0.4f);
+  UT_CHECK(Triage::Select(party) == Target::Guard);
+
+  // Predicted damage starts a heal within the lookahead only.
+  party = Party();
+  party.guard = Member(0.8f, 0.2f);
+  UT_CHECK(Triage::Select(party) == Target::Guard);
+  party.guard = Member(0.8f, 0.1f);
+  UT_CHECK(Triage::Select(party) == Target::None);
+
+  // Ties are resolved in the order player, warlock, knight, guard, ally.
+  party = Party();
+  party.player = Member(0.5f, 0.0f, 0.0f);
+  party.warlock = Member(0.5f);
+  party.knight = Member(0.5f);
+  party.guard = Member(0.5f);
+  party.ally = Member(0.5f);
+  UT_CHECK(Triage::Select(party) == Target::Player);
+  party.player = Member(1.0f, 0.0f, 0.0f);
+  UT_CHECK(Triage::Select(party) == Target::Warlock);
+  party.warlock = Member(1.0f);
+  UT_CHECK(Triage::Select(party) == Target::Knight);
+  party.knight = Member(1.0f);
+  UT_CHECK(Triage::Select(party) == Target::Guard);
+  party.guard = Member(1.0f);
+  UT_CHECK(Triage::Select(party) == Target::Ally);
+
+  // Members out of range, below the floor or dead are not healed.
+  party = Party();
+  party.guard = Member(0.3f, 0.0f, 1000.0f);
+  party.knight = Member(0.05f);
+  party.ally = Member(0.3f);
+  party.ally.dead = true;
+  UT_CHECK(Triage::Select(party) == Target::None);
+
+  // Without a living warlock nobody is healed.
+  party = Party();
+  party.player = Member(0.5f, 0.0f, 0.0f);
+  party.warlock.dead = true;
+  UT_CHECK(Triage::Select(party) == Target::None);
+
+  // Outside of combat anyone below full health is healed.
+  party = Party();
+  party.combat = false;
+  party.knight = Member(0.99f);
+  UT_CHECK(Triage::Select(party) == Target::Knight);
+}
+
+void TestTrace()
+{
+  // The guard loses health fast and is healed before it drops below its threshold,
+  // while the knight takes no damage above its threshold.
+  Health guard;
+  Health knight;
+  auto target = Triage::Target::None;
+  auto selected = 0.0;
+  for (auto time = 0.0; time <= 3.0 + 1e-6; time += 0.5) {
+    guard.Sample(time, 1.0f - static_cast<float>(time) * 0.15f);
+    knight.Sample(time, 0.8f);
+    auto party = Party();
+    party.guard = Member(guard.GetValue(), guard.GetRate());
+    party.knight = Member(knight.GetValue(), knight.GetRate());
+    if (target == Triage::Target::None) {
+      target = Triage::Select(party);
+      selected = time;
+    }
+  }
+  UT_CHECK(target == Triage::Target::Guard);
+  UT_CHECK(1.0 - selected * 0.15 > 0.6);
+}
+
+}  // namespace
+
+int main()
+{
+  TestEstimator();
+  TestTime();
+  TestSelect();
+  TestTrace();
+  return UT::Test::Result();
+}
@@ -0,0 +1,244 @@
+// Runs trinity members against the in-memory engine and checks the script calls they dispatch.
+#include "test.hpp"
+
+#include "../tools/engine.hpp"
+
+#include <trinity.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+using Category = Equip::Category;
+
+constexpr std::uint32_t Guard = 0xFE000831;
+constexpr std::uint32_t Knight = 0xFE000832;
+constexpr std::uint32_t Warlock = 0xFE000833;
+
+constexpr std::uint32_t Heal = 0xFE000820;
+constexpr std::uint32_t Attack = 0xFE000821;
+constexpr std::uint32_t Defend = 0xFE000822;
+
+struct Member {
+  std::shared_ptr<Engine::MemoryActor> actor;
+  std::shared_ptr<Trinity> trinity;
+};
+
+Member Create(Engine::MemoryVM& vm, std::uint32_t base, Policy::Class member)
+{
+  auto actor = std::make_shared<Engine::MemoryActor>(0xFF000800 | (base & 0xFF), base);
+  auto trinity = std::make_shared<Trinity>(vm, actor, member, std::vector<std::uint32_t>{ Heal, Attack, Defend });
+  return { std::move(actor), std::move(trinity) };
+}
+
+// Returns the functions of the dispatched calls in order.
+std::vector<std::string> GetFunctions(const Engine::MemoryVM& vm)
+{
+  std::vector<std::string> functions;
+  for (const auto& call : vm.GetCalls()) {
+    functions.push_back(call.function);
+  }
+  return functions;
+}
+
+// Returns the form id of a form argument or zero.
+std::uint32_t GetForm(const Engine::Argument& argument) noexcept
+{
+  const auto form = std::get_if<Engine::Form>(&argument);
+  return form ? form->id : 0;
+}
+
+std::int32_t GetInt(const Engine::Argument& argument) noexcept
+{
+  const auto value = std::get_if<std::int32_t>(&argument);
+  return value ? *value : -1;
+}
+
+Engine::Item Item(std::uint32_t id, Category category) noexcept
+{
+  return { { id, category == Category::Spell ? Engine::FormType::Spell : Engine::FormType::Other }, category };
+}
+
+void TestInitialize()
+{
+  Engine::MemoryVM vm;
+  auto [actor, trinity] = Create(vm, Warlock, Policy::Class::Warlock);
+  UT_CHECK(trinity->GetClass() == Warlock && trinity->IsWarlock());
+  UT_CHECK(trinity->GetFormID() == actor->GetFormID());
+
+  // Packages are removed one after another and the package is evaluated after the last one.
+  trinity->Initialize();
+  UT_CHECK(vm.GetCalls().size() == 1);
+  UT_CHECK(vm.Run() == 3);
+  UT_CHECK((GetFunctions(vm) == std::vector<std::string>(3, "RemovePackageOverride")));
+  for (std::size_t i = 0; i < vm.GetCalls().size(); i++) {
+    const auto& call = vm.GetCalls()[i];
+    UT_CHECK(call.script == "ActorUtil");
+    UT_CHECK(call.arguments.size() == 2 && std::get<Engine::Actor*>(call.arguments[0]) == actor.get());
+    UT_CHECK(GetForm(call.arguments[1]) == (std::vector<std::uint32_t>{ Heal, Attack, Defend })[i]);
+    UT_CHECK(std::get<Engine::Form>(call.arguments[1]).type == Engine::FormType::Package);
+  }
+  UT_CHECK(actor->evaluations == 1);
+
+  // Members are only initialized once.
+  vm.ClearCalls();
+  trinity->Initialize();
+  trinity->Restore(Attack);
+  UT_CHECK(vm.GetCalls().empty());
+  UT_CHECK(trinity->GetCombatPackage() == 0);
+}
+
+void TestCombatPackage()
+{
+  Engine::MemoryVM vm;
+  auto [actor, trinity] = Create(vm, Guard, Policy::Class::Guard);
+  trinity->Restore(Attack);
+  UT_CHECK(trinity->GetCombatPackage() == Attack);
+  UT_CHECK(vm.GetCalls().empty());
+
+  // The restored override is removed before the new one is added with priority 2 and forced.
+  trinity->SetCombatPackage(Defend);
+  UT_CHECK(trinity->GetCombatPackage() == Defend);
+  vm.Run();
+  UT_CHECK((GetFunctions(vm) == std::vector<std::string>{ "RemovePackageOverride", "AddPackageOverride" }));
+  const auto& add = vm.GetCalls().back();
+  UT_CHECK(add.arguments.size() == 4);
+  UT_CHECK(GetForm(add.arguments[1]) == Defend && GetInt(add.arguments[2]) == 2 && GetInt(add.arguments[3]) == 1);
+  UT_CHECK(GetForm(vm.GetCalls().front().arguments[1]) == Attack);
+  UT_CHECK(actor->evaluations == 1);
+
+  // The same package is not added again and zero only removes the override.
+  vm.ClearCalls();
+  trinity->SetCombatPackage(Defend);
+  UT_CHECK(vm.GetCalls().empty());
+  trinity->SetCombatPackage(0);
+  vm.Run();
+  UT_CHECK((GetFunctions(vm) == std::vector<std::string>{ "RemovePackageOverride" }));
+  UT_CHECK(actor->evaluations == 2);
+
+  vm.ClearCalls();
+  trinity->SetCombatPackage(Heal);
+  vm.Run();
+  UT_CHECK((GetFunctions(vm) == std::vector<std::string>{ "AddPackageOverride" }));
+  UT_CHECK(actor->evaluations == 3);
+}
+
+void TestDestroy()
+{
+  // Destroyed members remove their packages even though the actor is only held by the calls.
+  Engine::MemoryVM vm;
+  {
+    auto [actor, trinity] = Create(vm, Knight, Policy::Class::Knight);
+    trinity->Initialize();
+    vm.Run();
+    vm.ClearCalls();
+  }
+  vm.Run();
+  UT_CHECK(vm.GetCalls().size() == 3);
+
+  // Members that were not initialized do not touch packages.
+  vm.ClearCalls();
+  Create(vm, Knight, Policy::Class::Knight);
+  UT_CHECK(vm.GetCalls().empty());
+
+  // Members of an unloaded game keep the packages that the loaded save restores, and callbacks of
+  // the unloaded game are dropped.
+  auto [actor, trinity] = Create(vm, Knight, Policy::Class::Knight);
+  trinity->Initialize();
+  vm.Invalidate();
+  UT_CHECK(vm.Run() == 0);
+  vm.ClearCalls();
+  trinity.reset();
+  UT_CHECK(vm.GetCalls().empty());
+  UT_CHECK(actor->evaluations == 0);
+}
+
+void TestEquip()
+{
+  Engine::MemoryVM vm;
+  auto [guard, trinity] = Create(vm, Guard, Policy::Class::Guard);
+  UT_CHECK(trinity->CanEquip(Item(0x12EB7, Category::Shield)));
+  UT_CHECK(!trinity->CanEquip(Item(0x12EB8, Category::TwoHanded)));
+  UT_CHECK(!trinity->CanEquip(Item(0x12EB9, Category::None)));
+
+  // Armor unequips conflicting slots before it is equipped in the default slot.
+  auto updated = 0;
+  trinity->EquipItem(Item(0x12EB7, Category::Shield), [&]() { updated++; });
+  UT_CHECK((guard->conflicts == std::vector<std::uint32_t>{ 0x12EB7 }));
+  const auto& call = vm.GetCalls().back();
+  UT_CHECK(call.script == "Actor" && call.function == "EquipItemEx" && call.object == guard->GetFormID());
+  UT_CHECK(call.arguments.size() == 4 && GetForm(call.arguments[0]) == 0x12EB7 && GetInt(call.arguments[1]) == 0);
+  vm.Run();
+  UT_CHECK(updated == 1);
+
+  // Guards do not dual wield.
+  guard->right = Item(0x1397E, Category::OneHanded);
+  trinity->EquipItem(Item(0x13980, Category::OneHanded));
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+
+  // Knights dual wield one-handed weapons, but not the weapon they already hold.
+  auto [knight, member] = Create(vm, Knight, Policy::Class::Knight);
+  member->EquipItem(Item(0x13980, Category::OneHanded));
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+  knight->right = Item(0x1397E, Category::OneHanded);
+  member->EquipItem(Item(0x1397E, Category::OneHanded));
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+  member->EquipItem(Item(0x13980, Category::Dagger));
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 2);
+  knight->right = Item(0x139A3, Category::Staff);
+  member->EquipItem(Item(0x13980, Category::Dagger));
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+  UT_CHECK(knight->conflicts.empty());
+
+  // Items that can not be equipped are ignored.
+  vm.ClearCalls();
+  member->EquipItem(Item(0x12EB9, Category::None));
+  UT_CHECK(vm.GetCalls().empty());
+}
+
+void TestSpells()
+{
+  Engine::MemoryVM vm;
+  auto [actor, trinity] = Create(vm, Warlock, Policy::Class::Warlock);
+  const auto flames = Item(0x12FCD, Category::Spell);
+
+  // Spells are learned and equipped in the right hand first, then in the left hand.
+  trinity->EquipItem(flames);
+  UT_CHECK((actor->spells == std::vector<std::uint32_t>{ 0x12FCD }));
+  UT_CHECK(vm.GetCalls().back().function == "EquipSpell");
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 1);
+  UT_CHECK(std::get<Engine::Form>(vm.GetCalls().back().arguments[0]).type == Engine::FormType::Spell);
+  actor->right = Item(0x1C789, Category::Spell);
+  trinity->EquipItem(flames);
+  UT_CHECK(vm.GetCalls().back().function == "EquipSpell");
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+
+  // Equipped spells are unequipped from their hand and stay in the spell list.
+  actor->left = flames;
+  trinity->EquipItem(flames);
+  UT_CHECK(vm.GetCalls().back().function == "UnequipSpell");
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 0);
+  actor->left.reset();
+  actor->right = flames;
+  trinity->EquipItem(flames);
+  UT_CHECK(vm.GetCalls().back().function == "UnequipSpell");
+  UT_CHECK(GetInt(vm.GetCalls().back().arguments[1]) == 1);
+  UT_CHECK(actor->spells.size() == 1);
+}
+
+}  // namespace
+
+int main()
+{
+  TestInitialize();
+  TestCombatPackage();
+  TestDestroy();
+  TestEquip();
+  TestSpells();
+  return UT::Test::Result();
+}
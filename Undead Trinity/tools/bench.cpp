@@ -0,0 +1,270 @@
+// Measures plugin code that runs against the in-memory engine layer.
+//
+//   undead_trinity_bench [-n iterations] [-p plugins]... [-f forms] [-a allies] [-m microseconds]
+//
+// Loads the skill, perk and spell tables for the vanilla and the Requiem load order, once with
+// only the masters and once for every number of synthetic plugins (default 250, 1000 and 4000).
+// Synthetic plugins are placed before Requiem and Undead Trinity, so that every file lookup
+// searches the whole load order. Plugins that do not fit into the 254 full slots are light.
+// Reports the mean and fastest time of Forms::Load, the heap memory held by the loaded tables,
+// and the peak resident set size of the process. The peak includes the synthetic load order
+// and never shrinks, so it measures the fixture rather than Forms::Load. Exits with a failure
+// when a mean time exceeds the -m limit.
+//
+// Also measures how long it takes to rank the allies around the player (default 24) in one
+// sample, with health ratios, damage rates and distances that change between samples, and how
+// long a trinity member takes to switch its combat package against the in-memory VM.
+#include "engine.hpp"
+
+#include <allies.hpp>
+#include <forms.hpp>
+#include <trinity.hpp>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+// Number of file indices for full plugins.
+constexpr std::size_t FullFiles = 0xFE;
+
+// Number of form ids in a light plugin.
+constexpr std::size_t LightForms = 0x800;
+
+struct Result {
+  std::size_t perks{ 0 };
+  double mean{ 0.0 };
+  double fastest{ 0.0 };
+  double memory{ 0.0 };  // heap memory held by the tables in KiB
+};
+
+// Builds a load order with the masters, synthetic plugins, the files of the requested forms and the forms.
+Engine::Memory GetLoadOrder(Forms::Mods mod, std::size_t plugins, std::size_t forms)
+{
+  std::vector<std::string_view> masters{ "Skyrim.esm", "Update.esm", "Dawnguard.esm", "HearthFires.esm",
+                                         "Dragonborn.esm" };
+  std::vector<std::string_view> files{ Forms::Trinity };
+  if (mod == Forms::Mods::Requiem) {
+    files.insert(files.begin(), Forms::Requiem);
+  }
+
+  Engine::Memory data;
+  std::vector<std::size_t> indices;
+  for (const auto file : masters) {
+    indices.push_back(data.AddFile(std::string{ file }));
+  }
+
+  // Synthetic plugins with forms of every checked type.
+  const auto full = std::min(plugins, FullFiles - masters.size() - files.size());
+  for (std::size_t i = 0; i < plugins; i++) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "Synthetic%04zu.esp", i);
+    const auto light = i >= full;
+    const auto file = data.AddFile(name, light);
+    for (std::size_t j = 0; j < std::min(forms, light ? LightForms : forms); j++) {
+      const auto type = static_cast<Engine::FormType>(j % 4);
+      data.AddForm(file, static_cast<std::uint32_t>(0x800 + j), type);
+    }
+  }
+
+  for (const auto file : files) {
+    indices.push_back(data.AddFile(std::string{ file }));
+  }
+  masters.insert(masters.end(), files.begin(), files.end());
+  for (const auto& request : Forms::GetRequests(mod)) {
+    const auto file = std::ranges::find(masters, request.file);
+    data.AddForm(indices[static_cast<std::size_t>(file - masters.begin())], request.id, request.type);
+  }
+  return data;
+}
+
+// Returns the number of heap bytes in use in KiB.
+double GetMemory() noexcept
+{
+  const auto info = mallinfo2();
+  return static_cast<double>(info.uordblks + info.hblkhd) / 1024.0;
+}
+
+Result Measure(const Engine::Data& data, std::size_t iterations)
+{
+  Result result;
+  auto total = 0.0;
+  for (std::size_t i = 0; i < iterations; i++) {
+    const auto memory = i ? 0.0 : GetMemory();
+    const auto start = std::chrono::steady_clock::now();
+    const auto tables = Forms::Load(data);
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!i) {
+      result.memory = GetMemory() - memory;
+    }
+    total += seconds;
+    result.fastest = i ? std::min(result.fastest, seconds) : seconds;
+    result.perks = 0;
+    for (const auto& [id, ladders] : tables.perks) {
+      for (const auto& [skill, ladder] : ladders) {
+        result.perks += ladder.size();
+      }
+    }
+  }
+  result.mean = total / static_cast<double>(iterations);
+  return result;
+}
+
+// Returns the mean number of seconds it takes to update, prune and query the queue for all allies.
+double MeasureAllies(std::size_t allies, std::size_t iterations, std::size_t& heals)
+{
+  std::mt19937 random{ 0 };
+  std::uniform_real_distribution<float> health{ 0.2f, 1.0f };
+  std::uniform_real_distribution<float> rate{ -0.05f, 0.2f };
+  std::uniform_real_distribution<float> distance{ 0.0f, 1200.0f };
+
+  // Few enough samples to stay in the cache, like the allies of a single game.
+  std::vector<std::vector<Triage::Member>> samples(64);
+  for (auto& sample : samples) {
+    for (std::size_t i = 0; i < allies; i++) {
+      sample.push_back({ true, false, health(random), rate(random), distance(random) });
+    }
+  }
+
+  Allies queue;
+  heals = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t iteration = 0; iteration < iterations; iteration++) {
+    const auto& sample = samples[iteration % samples.size()];
+    for (std::size_t i = 0; i < sample.size(); i++) {
+      queue.Update(static_cast<std::uint32_t>(0xFF000800 + i), sample[i]);
+    }
+    queue.Prune();
+    heals += queue.Top() ? 1 : 0;
+  }
+  const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds / static_cast<double>(iterations);
+}
+
+// Returns the mean number of seconds it takes a member to switch its combat package and run the
+// callbacks of the script calls.
+double MeasurePackages(std::size_t iterations, std::size_t& calls)
+{
+  const std::vector<std::uint32_t> packages{ 0xFE000820, 0xFE000821, 0xFE000822, 0xFE000823, 0 };
+  Engine::MemoryVM vm;
+  const auto actor = std::make_shared<Engine::MemoryActor>(0xFF000800, 0xFE000833);
+  const auto trinity = std::make_shared<Trinity>(vm, actor, Policy::Class::Warlock, packages);
+  trinity->Initialize();
+  vm.Run();
+  vm.ClearCalls();
+
+  calls = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t iteration = 0; iteration < iterations; iteration++) {
+    trinity->SetCombatPackage(packages[iteration % packages.size()]);
+    vm.Run();
+    calls += vm.GetCalls().size();
+    vm.ClearCalls();
+  }
+  const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds / static_cast<double>(iterations);
+}
+
+// Returns the peak resident set size of the process in MiB.
+double GetPeakMemory() noexcept
+{
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::size_t iterations = 100;
+  std::size_t forms = 200;
+  std::size_t allies = 24;
+  std::vector<std::size_t> counts;
+  auto limit = 0.0;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view option{ argv[i] };
+    if (option == "-n" && i + 1 < argc) {
+      iterations = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+    } else if (option == "-p" && i + 1 < argc) {
+      counts.push_back(std::strtoull(argv[++i], nullptr, 10));
+    } else if (option == "-f" && i + 1 < argc) {
+      forms = std::strtoull(argv[++i], nullptr, 10);
+    } else if (option == "-a" && i + 1 < argc) {
+      allies = std::strtoull(argv[++i], nullptr, 10);
+    } else if (option == "-m" && i + 1 < argc) {
+      limit = std::strtod(argv[++i], nullptr);
+    } else {
+      std::fprintf(
+        stderr, "usage: %s [-n iterations] [-p plugins]... [-f forms] [-a allies] [-m microseconds]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (counts.empty()) {
+    counts = { 250, 1000, 4000 };
+  }
+  counts.insert(counts.begin(), 0);
+
+  auto result = EXIT_SUCCESS;
+  for (const auto plugins : counts) {
+    for (const auto mod : { Forms::Mods::Skyrim, Forms::Mods::Requiem }) {
+      const auto data = GetLoadOrder(mod, plugins, forms);
+      Result measured;
+      try {
+        measured = Measure(data, iterations);
+      }
+      catch (const std::exception& e) {
+        std::fprintf(stderr, "Forms::Load: %s\n", e.what());
+        return EXIT_FAILURE;
+      }
+      const auto exceeded = limit > 0.0 && measured.mean * 1e6 > limit;
+      std::printf(
+        "Forms::Load %-7s %5zu files, %7zu forms, %zu perks: %9.2f us mean, %9.2f us fastest, %7.1f KiB loaded, "
+        "%7.1f MiB fixture peak%s\n",
+        mod == Forms::Mods::Requiem ? "Requiem" : "Skyrim",
+        data.GetFileCount(),
+        data.GetFormCount(),
+        measured.perks,
+        measured.mean * 1e6,
+        measured.fastest * 1e6,
+        measured.memory,
+        GetPeakMemory(),
+        exceeded ? " (over limit)" : "");
+      if (exceeded) {
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
+  std::size_t heals = 0;
+  const auto seconds = MeasureAllies(allies, std::max(iterations, std::size_t{ 10000 }), heals);
+  std::printf(
+    "Allies::Update %zu allies, %zu capacity: %9.3f us mean per sample, %zu heals\n",
+    allies,
+    Allies::Capacity,
+    seconds * 1e6,
+    heals);
+
+  std::size_t calls = 0;
+  const auto changes = std::max(iterations, std::size_t{ 10000 });
+  const auto switching = MeasurePackages(changes, calls);
+  std::printf(
+    "Trinity::SetCombatPackage %zu changes: %9.3f us mean per change, %zu script calls\n",
+    changes,
+    switching * 1e6,
+    calls);
+  return result;
+}
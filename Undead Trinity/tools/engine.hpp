@@ -0,0 +1,254 @@
+#pragma once
+#include <engine.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace UT::Engine {
+
+// In-memory data handler with a load order of plugin files.
+// Files are found by a case-insensitive linear search over the load order like in the game.
+// Light files share the 0xFE index and use the lower 12 bits of form ids.
+class Memory final : public Data {
+public:
+  // Appends a file to the load order and returns its index in the load order.
+  std::size_t AddFile(std::string name, bool light = false)
+  {
+    const auto index = light ? lights_++ : fulls_++;
+    files_.push_back({ std::move(name), light, index });
+    return files_.size() - 1;
+  }
+
+  // Adds a form with a file local id to a file.
+  void AddForm(std::size_t file, std::uint32_t id, FormType type, bool named = true)
+  {
+    const auto form = GetFormID(file, id);
+    forms_[form] = { form, type, named };
+  }
+
+  std::optional<Form> LookupForm(std::uint32_t id, std::string_view file) const override
+  {
+    const auto index = Find(file);
+    if (index == files_.size()) {
+      return std::nullopt;
+    }
+    if (const auto it = forms_.find(GetFormID(index, id)); it != forms_.end()) {
+      return it->second;
+    }
+    return std::nullopt;
+  }
+
+  bool IsLoaded(std::string_view file) const override
+  {
+    return Find(file) != files_.size();
+  }
+
+  std::size_t GetFileCount() const noexcept
+  {
+    return files_.size();
+  }
+
+  std::size_t GetFormCount() const noexcept
+  {
+    return forms_.size();
+  }
+
+private:
+  struct File {
+    std::string name;
+    bool light{ false };
+    std::uint32_t index{ 0 };
+  };
+
+  std::uint32_t GetFormID(std::size_t file, std::uint32_t id) const noexcept
+  {
+    const auto& entry = files_[file];
+    if (entry.light) {
+      return 0xFE000000 | entry.index << 12 | (id & 0xFFF);
+    }
+    return entry.index << 24 | (id & 0xFFFFFF);
+  }
+
+  std::size_t Find(std::string_view file) const noexcept
+  {
+    const auto equal = [](char a, char b) {
+      return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    };
+    const auto it = std::ranges::find_if(files_, [&](const File& entry) {
+      return std::ranges::equal(entry.name, file, equal);
+    });
+    return static_cast<std::size_t>(it - files_.begin());
+  }
+
+  std::vector<File> files_;
+  std::uint32_t fulls_{ 0 };
+  std::uint32_t lights_{ 0 };
+  std::unordered_map<std::uint32_t, Form> forms_;
+};
+
+// In-memory actor. The state is changed directly by tests and benchmarks.
+class MemoryActor final : public Actor {
+public:
+  MemoryActor(std::uint32_t id, std::uint32_t base) noexcept :
+    id_(id),
+    base_(base)
+  {}
+
+  std::uint32_t GetFormID() const override
+  {
+    return id_;
+  }
+
+  std::uint32_t GetBaseID() const override
+  {
+    return base_;
+  }
+
+  bool IsDead() const override
+  {
+    return dead;
+  }
+
+  float GetHealth() const override
+  {
+    return health;
+  }
+
+  Position GetPosition() const override
+  {
+    return position;
+  }
+
+  std::optional<Item> GetEquipped(bool left) const override
+  {
+    return left ? this->left : right;
+  }
+
+  bool AddSpell(const Form& spell) override
+  {
+    if (std::ranges::find(spells, spell.id) == spells.end()) {
+      spells.push_back(spell.id);
+    }
+    return true;
+  }
+
+  void UnequipConflicts(const Form& armor) override
+  {
+    conflicts.push_back(armor.id);
+  }
+
+  void EvaluatePackage() override
+  {
+    evaluations++;
+  }
+
+  bool dead{ false };
+  float health{ 1.0f };
+  Position position;
+  std::optional<Item> left;
+  std::optional<Item> right;
+  std::vector<std::uint32_t> spells;     // known spells
+  std::vector<std::uint32_t> conflicts;  // armor passed to UnequipConflicts
+  std::size_t evaluations{ 0 };          // number of package evaluations
+
+private:
+  std::uint32_t id_;
+  std::uint32_t base_;
+};
+
+// In-memory VM that records dispatched calls. Callbacks run when Run is called, like they would
+// on a script thread after the call returned.
+class MemoryVM final : public VM {
+public:
+  struct Call {
+    std::string script;
+    std::string function;
+    std::uint32_t object{ 0 };  // form id of the actor a method was called on or zero
+    std::vector<Argument> arguments;
+  };
+
+  std::uint32_t GetGeneration() const override
+  {
+    return generation_;
+  }
+
+  bool DispatchStaticCall(
+    std::string_view script,
+    std::string_view function,
+    std::span<const Argument> arguments,
+    Callback callback = {}) override
+  {
+    return Dispatch(0, script, function, arguments, std::move(callback));
+  }
+
+  bool DispatchMethodCall(
+    Actor& actor,
+    std::string_view script,
+    std::string_view function,
+    std::span<const Argument> arguments,
+    Callback callback = {}) override
+  {
+    return Dispatch(actor.GetFormID(), script, function, arguments, std::move(callback));
+  }
+
+  // Runs pending callbacks including the callbacks of calls they dispatch and returns how many ran.
+  std::size_t Run()
+  {
+    std::size_t count = 0;
+    while (!pending_.empty()) {
+      auto [generation, callback] = std::move(pending_.front());
+      pending_.pop_front();
+      if (generation == generation_ && callback) {
+        callback();
+        count++;
+      }
+    }
+    return count;
+  }
+
+  // Starts a new generation like a loaded game. Pending callbacks are dropped.
+  void Invalidate() noexcept
+  {
+    generation_++;
+  }
+
+  const std::vector<Call>& GetCalls() const noexcept
+  {
+    return calls_;
+  }
+
+  void ClearCalls() noexcept
+  {
+    calls_.clear();
+  }
+
+private:
+  bool Dispatch(
+    std::uint32_t object,
+    std::string_view script,
+    std::string_view function,
+    std::span<const Argument> arguments,
+    Callback callback)
+  {
+    calls_.push_back(
+      { std::string{ script }, std::string{ function }, object, { arguments.begin(), arguments.end() } });
+    pending_.emplace_back(generation_, std::move(callback));
+    return true;
+  }
+
+  std::uint32_t generation_{ 0 };
+  std::vector<Call> calls_;
+  std::deque<std::pair<std::uint32_t, Callback>> pending_;
+};
+
+}  // namespace UT::Engine
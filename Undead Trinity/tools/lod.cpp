@@ -0,0 +1,256 @@
+// Builds reduced detail variants of skinned Skyrim SE meshes.
+//
+//   undead_trinity_lod [-r ratio]... [-t threads] [-o directory] mesh.nif...
+//
+// Writes mesh_lod1.nif, mesh_lod2.nif, ... next to the input or to the output directory, one for every
+// ratio (default 0.5 and 0.25). Every skin partition is simplified on its own with quadric error metric
+// edge collapses that move a vertex onto a neighbor, so skin weights, bone indices and texture coordinates
+// are kept as they are. Vertices on partition boundaries, texture seams and open edges are never removed.
+// Partitions of all meshes and levels are simplified in parallel. A warning is printed when the kept
+// vertices do not allow a level to reach its ratio.
+//
+// Only the meshes are generated. Skyrim does not switch skinned actor meshes by distance, so the race and
+// the armor addons of the plugin do not reference the output; they have to be assigned by hand.
+#include "mapping.hpp"
+#include "mesh.hpp"
+#include "nif.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+struct Source {
+  Nif::Skin skin;
+  Nif::SkinPartition partitions;
+  Nif::SkinData data;
+  std::vector<std::array<float, 3>> positions;
+  std::vector<bool> shared;  // vertices used by more than one partition
+};
+
+struct Input {
+  const char* path{ nullptr };
+  std::unique_ptr<Mapping> mapping;
+  std::vector<Source> sources;
+};
+
+struct Job {
+  std::size_t input{ 0 };
+  std::size_t level{ 0 };
+  std::size_t source{ 0 };
+  std::size_t partition{ 0 };
+  std::vector<std::uint16_t> triangles;
+};
+
+bool Load(Input& input)
+{
+  input.mapping = std::make_unique<Mapping>(input.path);
+  Nif::File file;
+  if (!file.Parse(input.mapping->Data())) {
+    return false;
+  }
+  for (const auto& skin : Nif::GetSkins(file)) {
+    auto& source = input.sources.emplace_back();
+    source.skin = skin;
+    if (
+      !source.partitions.Parse(file.GetBlocks()[skin.partition].data) ||
+      !source.data.Parse(file.GetBlocks()[skin.data].data) || !Nif::IsIndexed(source.partitions, source.data))
+    {
+      return false;
+    }
+    source.positions = Nif::GetPositions(source.partitions);
+    if (source.positions.empty()) {
+      return false;
+    }
+    std::vector<std::uint8_t> uses(source.positions.size());
+    for (const auto& partition : source.partitions.partitions) {
+      for (const auto index : partition.vertex_map) {
+        uses[index]++;
+      }
+    }
+    source.shared.resize(uses.size());
+    for (std::size_t i = 0; i < uses.size(); i++) {
+      source.shared[i] = uses[i] > 1;
+    }
+  }
+  return true;
+}
+
+std::filesystem::path GetPath(const char* input, const std::filesystem::path& directory, std::size_t level)
+{
+  const std::filesystem::path path{ input };
+  const auto name = path.stem().string() + "_lod" + std::to_string(level + 1) + path.extension().string();
+  return (directory.empty() ? path.parent_path() : directory) / name;
+}
+
+// Difference to the requested ratio that is not reported.
+constexpr double Tolerance = 0.02;
+
+double GetRatio(std::size_t triangles, std::size_t original) noexcept
+{
+  return original ? static_cast<double>(triangles) / static_cast<double>(original) : 1.0;
+}
+
+bool Save(const std::filesystem::path& path, std::span<const std::uint8_t> data)
+{
+  std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  file.close();
+  return static_cast<bool>(file);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<double> ratios;
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::filesystem::path directory;
+  std::vector<Input> inputs;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view option{ argv[i] };
+    if (option == "-r" && i + 1 < argc) {
+      ratios.push_back(std::clamp(std::strtod(argv[++i], nullptr), 0.0, 1.0));
+    } else if (option == "-t" && i + 1 < argc) {
+      threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+    } else if (option == "-o" && i + 1 < argc) {
+      directory = argv[++i];
+    } else {
+      inputs.emplace_back().path = argv[i];
+    }
+  }
+  if (inputs.empty()) {
+    std::fprintf(stderr, "usage: %s [-r ratio]... [-t threads] [-o directory] mesh.nif...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (ratios.empty()) {
+    ratios = { 0.5, 0.25 };
+  }
+
+  auto result = EXIT_SUCCESS;
+  std::vector<Job> jobs;
+  for (std::size_t i = 0; i < inputs.size(); i++) {
+    if (!Load(inputs[i])) {
+      std::fprintf(stderr, "%s: not an indexed Skyrim SE skinned mesh\n", inputs[i].path);
+      inputs[i].sources.clear();
+      result = EXIT_FAILURE;
+      continue;
+    }
+    for (std::size_t level = 0; level < ratios.size(); level++) {
+      for (std::size_t source = 0; source < inputs[i].sources.size(); source++) {
+        for (std::size_t partition = 0; partition < inputs[i].sources[source].partitions.partitions.size(); partition++) {
+          jobs.push_back({ i, level, source, partition, {} });
+        }
+      }
+    }
+  }
+
+  // Large partitions first, so that they do not end up last on a single thread.
+  std::ranges::sort(jobs, std::greater<>{}, [&](const Job& job) {
+    return inputs[job.input].sources[job.source].partitions.partitions[job.partition].triangles.size();
+  });
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic_size_t next{ 0 };
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t i = 0; i < std::min(threads, jobs.size()); i++) {
+      workers.emplace_back([&]() {
+        for (auto index = next++; index < jobs.size(); index = next++) {
+          auto& job = jobs[index];
+          const auto& source = inputs[job.input].sources[job.source];
+          job.triangles = source.partitions.partitions[job.partition].triangles;
+          const auto target = static_cast<std::size_t>(static_cast<double>(job.triangles.size() / 3) * ratios[job.level]);
+          Mesh::Simplify(source.positions, source.shared, job.triangles, target);
+          Mesh::Optimize(job.triangles);
+        }
+      });
+    }
+  }
+  const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  for (std::size_t i = 0; i < inputs.size(); i++) {
+    const auto& input = inputs[i];
+    if (input.sources.empty()) {
+      continue;
+    }
+    for (std::size_t level = 0; level < ratios.size(); level++) {
+      Nif::File file;
+      if (!file.Parse(input.mapping->Data())) {
+        result = EXIT_FAILURE;
+        continue;
+      }
+      std::size_t triangles[2]{};
+      std::size_t vertices[2]{};
+      for (std::size_t source = 0; source < input.sources.size(); source++) {
+        auto partitions = input.sources[source].partitions;
+        auto data = input.sources[source].data;
+        vertices[0] += partitions.GetVertexCount();
+        for (const auto& job : jobs) {
+          if (job.input == i && job.level == level && job.source == source) {
+            auto& partition = partitions.partitions[job.partition];
+            triangles[0] += partition.triangles.size() / 3;
+            triangles[1] += job.triangles.size() / 3;
+            partition.triangles = job.triangles;
+            partition.triangles_copy = job.triangles;
+          }
+        }
+        Nif::Reorder(partitions, data);
+        Nif::Compact(partitions, data);
+        vertices[1] += partitions.GetVertexCount();
+        file.Replace(input.sources[source].skin.partition, partitions.Write());
+        file.Replace(input.sources[source].skin.data, data.Write());
+      }
+
+      const auto data = file.Write();
+      const auto path = GetPath(input.path, directory, level);
+      Nif::File written;
+      auto valid = written.Parse(data) && written.GetBlocks().size() == file.GetBlocks().size();
+      for (const auto& skin : valid ? Nif::GetSkins(written) : std::vector<Nif::Skin>{}) {
+        Nif::SkinPartition partitions;
+        Nif::SkinData skin_data;
+        valid = valid && partitions.Parse(written.GetBlocks()[skin.partition].data) &&
+                skin_data.Parse(written.GetBlocks()[skin.data].data) && Nif::IsIndexed(partitions, skin_data);
+      }
+      if (!valid || !Save(path, data)) {
+        std::fprintf(stderr, "%s: %s could not be written\n", input.path, path.c_str());
+        result = EXIT_FAILURE;
+        continue;
+      }
+      std::printf(
+        "%s: %.2f %zu -> %zu triangles, %zu -> %zu vertices, %zu -> %zu bytes\n",
+        path.c_str(),
+        ratios[level],
+        triangles[0],
+        triangles[1],
+        vertices[0],
+        vertices[1],
+        input.mapping->Data().size(),
+        data.size());
+      if (const auto reached = GetRatio(triangles[1], triangles[0]); reached > ratios[level] + Tolerance) {
+        std::fflush(stdout);
+        std::fprintf(
+          stderr,
+          "%s: warning: ratio %.2f not reached (%.2f), boundary and seam vertices are kept\n",
+          path.c_str(),
+          ratios[level],
+          reached);
+      }
+    }
+  }
+  std::printf("%zu partitions simplified in %.3f s on %zu threads\n", jobs.size(), seconds, threads);
+  return result;
+}
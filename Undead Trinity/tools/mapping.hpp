@@ -0,0 +1,56 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace UT {
+
+// Read-only memory map of a file. The data is empty when the file could not be mapped.
+class Mapping {
+public:
+  explicit Mapping(const char* path) noexcept
+  {
+    const auto fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      const auto size = static_cast<std::size_t>(st.st_size);
+      if (const auto data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED) {
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        data_ = static_cast<const std::uint8_t*>(data);
+        size_ = size;
+      }
+    }
+    ::close(fd);
+  }
+
+  Mapping(Mapping&& other) = delete;
+  Mapping(const Mapping& other) = delete;
+  Mapping& operator=(Mapping&& other) = delete;
+  Mapping& operator=(const Mapping& other) = delete;
+
+  ~Mapping()
+  {
+    if (data_) {
+      ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+  }
+
+  std::span<const std::uint8_t> Data() const noexcept
+  {
+    return { data_, size_ };
+  }
+
+private:
+  const std::uint8_t* data_{ nullptr };
+  std::size_t size_{ 0 };
+};
+
+}  // namespace UT
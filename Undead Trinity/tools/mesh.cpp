@@ -0,0 +1,407 @@
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+namespace UT::Mesh {
+namespace {
+
+constexpr float CacheDecayPower = 1.5f;
+constexpr float LastTriangleScore = 0.75f;
+constexpr float ValenceBoostScale = 2.0f;
+constexpr float ValenceBoostPower = 0.5f;
+
+struct Vertex {
+  std::uint32_t first{ 0 };      // offset of the first adjacent triangle
+  std::uint32_t remaining{ 0 };  // number of adjacent triangles that were not emitted
+  std::int32_t position{ -1 };   // position in the cache or -1
+  float score{ 0.0f };
+};
+
+float GetScore(const Vertex& vertex) noexcept
+{
+  if (!vertex.remaining) {
+    return -1.0f;
+  }
+  auto score = 0.0f;
+  if (vertex.position >= 0) {
+    if (vertex.position < 3) {
+      score = LastTriangleScore;
+    } else {
+      const auto scale = 1.0f / static_cast<float>(CacheSize - 3);
+      score = std::pow(1.0f - static_cast<float>(vertex.position - 3) * scale, CacheDecayPower);
+    }
+  }
+  return score + ValenceBoostScale * std::pow(static_cast<float>(vertex.remaining), -ValenceBoostPower);
+}
+
+using Vector = std::array<double, 3>;
+
+Vector Subtract(const std::array<float, 3>& a, const std::array<float, 3>& b) noexcept
+{
+  return { static_cast<double>(a[0]) - b[0], static_cast<double>(a[1]) - b[1], static_cast<double>(a[2]) - b[2] };
+}
+
+Vector Cross(const Vector& a, const Vector& b) noexcept
+{
+  return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+double Dot(const Vector& a, const Vector& b) noexcept
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Symmetric 4x4 matrix that sums the squared distances to planes.
+struct Quadric {
+  std::array<double, 10> m{};
+
+  void Add(const Vector& normal, double d, double weight) noexcept
+  {
+    const std::array<double, 4> p{ normal[0], normal[1], normal[2], d };
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+      for (std::size_t j = i; j < 4; j++) {
+        m[k++] += p[i] * p[j] * weight;
+      }
+    }
+  }
+
+  void Add(const Quadric& other) noexcept
+  {
+    for (std::size_t i = 0; i < m.size(); i++) {
+      m[i] += other.m[i];
+    }
+  }
+
+  double GetError(const std::array<float, 3>& position) const noexcept
+  {
+    const std::array<double, 4> v{ position[0], position[1], position[2], 1.0 };
+    double error = 0.0;
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+      for (std::size_t j = i; j < 4; j++) {
+        error += (i == j ? 1.0 : 2.0) * m[k++] * v[i] * v[j];
+      }
+    }
+    return error;
+  }
+};
+
+struct Collapse {
+  double cost{ 0.0 };
+  std::uint16_t from{ 0 };
+  std::uint16_t to{ 0 };
+  std::uint32_t from_version{ 0 };
+  std::uint32_t to_version{ 0 };
+
+  bool operator>(const Collapse& other) const noexcept
+  {
+    return cost > other.cost;
+  }
+};
+
+}  // namespace
+
+void Optimize(std::span<std::uint16_t> triangles)
+{
+  const auto count = triangles.size() / 3;
+  if (count < 2) {
+    return;
+  }
+  std::size_t size = 0;
+  for (const auto index : triangles) {
+    size = std::max<std::size_t>(size, index + 1u);
+  }
+
+  // Build the vertex to triangle adjacency.
+  std::vector<Vertex> vertices(size);
+  for (const auto index : triangles) {
+    vertices[index].remaining++;
+  }
+  std::uint32_t offset = 0;
+  for (auto& vertex : vertices) {
+    vertex.first = offset;
+    offset += vertex.remaining;
+    vertex.score = GetScore(vertex);
+  }
+  std::vector<std::uint32_t> adjacency(offset);
+  std::vector<std::uint32_t> fill(size, 0);
+  for (std::size_t i = 0; i < triangles.size(); i++) {
+    const auto index = triangles[i];
+    adjacency[vertices[index].first + fill[index]++] = static_cast<std::uint32_t>(i / 3);
+  }
+
+  std::vector<bool> emitted(count);
+  std::vector<std::uint16_t> output;
+  output.reserve(triangles.size());
+  std::array<std::int32_t, CacheSize + 3> cache{};
+  std::array<std::int32_t, CacheSize + 3> next{};
+  std::size_t cached = 0;
+  std::size_t cursor = 0;
+  auto best = -1;
+  while (output.size() < triangles.size()) {
+    if (best < 0) {
+      // Restart with the first triangle that was not emitted.
+      while (emitted[cursor]) {
+        cursor++;
+      }
+      best = static_cast<int>(cursor);
+    }
+    const auto triangle = static_cast<std::size_t>(best);
+    emitted[triangle] = true;
+
+    // Emit the triangle and remove it from the adjacency of its vertices.
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < 3; i++) {
+      const auto index = triangles[triangle * 3 + i];
+      output.push_back(index);
+      auto& vertex = vertices[index];
+      const auto begin = adjacency.begin() + vertex.first;
+      const auto end = begin + vertex.remaining;
+      std::iter_swap(std::find(begin, end, static_cast<std::uint32_t>(triangle)), end - 1);
+      vertex.remaining--;
+      if (std::find(next.begin(), next.begin() + added, index) == next.begin() + added) {
+        next[added++] = index;
+      }
+    }
+
+    // Move the triangle vertices to the front of the cache.
+    const auto front = next.begin() + static_cast<std::ptrdiff_t>(added);
+    for (std::size_t i = 0; i < cached; i++) {
+      const auto index = cache[i];
+      if (std::find(next.begin(), front, index) == front) {
+        next[added++] = index;
+      }
+    }
+    cache = next;
+    cached = added;
+    for (std::size_t i = 0; i < cached; i++) {
+      auto& vertex = vertices[static_cast<std::size_t>(cache[i])];
+      vertex.position = i < CacheSize ? static_cast<std::int32_t>(i) : -1;
+      vertex.score = GetScore(vertex);
+    }
+    cached = std::min(cached, CacheSize);
+
+    // Update the scores of triangles that use cached vertices and select the best one.
+    auto score = -1.0f;
+    best = -1;
+    for (std::size_t i = 0; i < added; i++) {
+      const auto& vertex = vertices[static_cast<std::size_t>(next[i])];
+      for (std::uint32_t j = 0; j < vertex.remaining; j++) {
+        const auto candidate = adjacency[vertex.first + j];
+        const auto value = vertices[triangles[candidate * 3]].score + vertices[triangles[candidate * 3 + 1]].score +
+                           vertices[triangles[candidate * 3 + 2]].score;
+        if (value > score) {
+          score = value;
+          best = static_cast<int>(candidate);
+        }
+      }
+    }
+  }
+  std::ranges::copy(output, triangles.begin());
+}
+
+std::size_t GetTransforms(std::span<const std::uint16_t> triangles, std::size_t cache)
+{
+  std::vector<std::uint16_t> fifo(std::max<std::size_t>(cache, 1), 0xFFFF);
+  std::size_t head = 0;
+  std::size_t transforms = 0;
+  for (const auto index : triangles) {
+    if (std::ranges::find(fifo, index) == fifo.end()) {
+      fifo[head] = index;
+      head = (head + 1) % fifo.size();
+      transforms++;
+    }
+  }
+  return transforms;
+}
+
+std::vector<std::uint16_t> GetVertexOrder(std::span<const std::uint16_t> triangles, std::size_t vertices)
+{
+  constexpr auto unused = std::uint16_t{ 0xFFFF };
+  std::vector<std::uint16_t> order(vertices, unused);
+  std::uint16_t next = 0;
+  for (const auto index : triangles) {
+    if (index < vertices && order[index] == unused) {
+      order[index] = next++;
+    }
+  }
+  for (auto& index : order) {
+    if (index == unused) {
+      index = next++;
+    }
+  }
+  return order;
+}
+
+void Simplify(
+  std::span<const std::array<float, 3>> positions,
+  const std::vector<bool>& locked,
+  std::vector<std::uint16_t>& triangles,
+  std::size_t target)
+{
+  auto count = triangles.size() / 3;
+  if (count <= target) {
+    return;
+  }
+  const auto vertices = positions.size();
+  std::vector<std::vector<std::uint32_t>> adjacency(vertices);
+  std::vector<Quadric> quadrics(vertices);
+  std::vector<bool> fixed(vertices);
+  std::unordered_map<std::uint32_t, std::uint32_t> edges;
+  for (std::size_t i = 0; i < count; i++) {
+    const auto a = triangles[i * 3];
+    const auto b = triangles[i * 3 + 1];
+    const auto c = triangles[i * 3 + 2];
+    const auto normal = Cross(Subtract(positions[b], positions[a]), Subtract(positions[c], positions[a]));
+    const auto area = std::sqrt(Dot(normal, normal));
+    for (const auto index : { a, b, c }) {
+      adjacency[index].push_back(static_cast<std::uint32_t>(i));
+      if (area > 0.0) {
+        const Vector unit{ normal[0] / area, normal[1] / area, normal[2] / area };
+        const Vector point{ positions[a][0], positions[a][1], positions[a][2] };
+        quadrics[index].Add(unit, -Dot(unit, point), area);
+      }
+    }
+    for (const auto& [u, v] : { std::pair{ a, b }, { b, c }, { c, a } }) {
+      edges[static_cast<std::uint32_t>(std::min(u, v)) << 16 | std::max(u, v)]++;
+    }
+  }
+
+  // Vertices on open edges, such as partition boundaries and texture seams, keep their position.
+  for (const auto& [edge, uses] : edges) {
+    if (uses != 2) {
+      fixed[edge >> 16] = true;
+      fixed[edge & 0xFFFF] = true;
+    }
+  }
+  for (std::size_t i = 0; i < vertices && i < locked.size(); i++) {
+    if (locked[i]) {
+      fixed[i] = true;
+    }
+  }
+
+  std::vector<bool> removed(count);
+  std::vector<std::uint32_t> versions(vertices);
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+  const auto push = [&](std::uint16_t from, std::uint16_t to) {
+    if (fixed[from]) {
+      return;
+    }
+    auto quadric = quadrics[from];
+    quadric.Add(quadrics[to]);
+    queue.push({ quadric.GetError(positions[to]), from, to, versions[from], versions[to] });
+  };
+  for (const auto& [edge, uses] : edges) {
+    const auto u = static_cast<std::uint16_t>(edge >> 16);
+    const auto v = static_cast<std::uint16_t>(edge & 0xFFFF);
+    push(u, v);
+    push(v, u);
+  }
+
+  const auto neighbors = [&](std::uint16_t vertex) {
+    std::vector<std::uint16_t> result;
+    for (const auto triangle : adjacency[vertex]) {
+      for (std::size_t i = 0; i < 3; i++) {
+        if (const auto index = triangles[triangle * 3 + i]; index != vertex) {
+          result.push_back(index);
+        }
+      }
+    }
+    std::ranges::sort(result);
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  };
+
+  const auto valid = [&](std::uint16_t from, std::uint16_t to) {
+    // The link condition keeps the surface manifold: the only shared neighbors are the
+    // vertices opposite of the collapsed edge.
+    const auto a = neighbors(from);
+    const auto b = neighbors(to);
+    std::vector<std::uint16_t> shared;
+    std::ranges::set_intersection(a, b, std::back_inserter(shared));
+    std::size_t opposite = 0;
+    for (const auto triangle : adjacency[from]) {
+      const auto* corners = &triangles[triangle * 3];
+      if (corners[0] == to || corners[1] == to || corners[2] == to) {
+        opposite++;
+      }
+    }
+    if (shared.size() != opposite) {
+      return false;
+    }
+
+    // Reject collapses that flip or degenerate the remaining triangles.
+    for (const auto triangle : adjacency[from]) {
+      const auto* corners = &triangles[triangle * 3];
+      if (corners[0] == to || corners[1] == to || corners[2] == to) {
+        continue;
+      }
+      std::array<std::array<float, 3>, 3> moved;
+      for (std::size_t i = 0; i < 3; i++) {
+        moved[i] = positions[corners[i] == from ? to : corners[i]];
+      }
+      const auto before = Cross(
+        Subtract(positions[corners[1]], positions[corners[0]]), Subtract(positions[corners[2]], positions[corners[0]]));
+      const auto after = Cross(Subtract(moved[1], moved[0]), Subtract(moved[2], moved[0]));
+      const auto length = std::sqrt(Dot(before, before) * Dot(after, after));
+      if (length <= 0.0 || Dot(before, after) < 0.2 * length) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  while (count > target && !queue.empty()) {
+    const auto collapse = queue.top();
+    queue.pop();
+    const auto from = collapse.from;
+    const auto to = collapse.to;
+    if (versions[from] != collapse.from_version || versions[to] != collapse.to_version || !valid(from, to)) {
+      continue;
+    }
+
+    // Move the triangles of the removed vertex to its neighbor and drop the collapsed ones.
+    for (const auto triangle : adjacency[from]) {
+      auto* corners = &triangles[triangle * 3];
+      if (corners[0] == to || corners[1] == to || corners[2] == to) {
+        removed[triangle] = true;
+        std::erase(adjacency[to], triangle);
+        for (std::size_t i = 0; i < 3; i++) {
+          if (corners[i] != from && corners[i] != to) {
+            std::erase(adjacency[corners[i]], triangle);
+          }
+        }
+        count--;
+        continue;
+      }
+      for (std::size_t i = 0; i < 3; i++) {
+        corners[i] = corners[i] == from ? to : corners[i];
+      }
+      adjacency[to].push_back(triangle);
+    }
+    adjacency[from].clear();
+    quadrics[to].Add(quadrics[from]);
+    versions[from]++;
+    versions[to]++;
+    for (const auto neighbor : neighbors(to)) {
+      push(to, neighbor);
+      push(neighbor, to);
+    }
+  }
+
+  std::vector<std::uint16_t> output;
+  output.reserve(count * 3);
+  for (std::size_t i = 0; i < removed.size(); i++) {
+    if (!removed[i]) {
+      output.insert(output.end(), triangles.begin() + i * 3, triangles.begin() + i * 3 + 3);
+    }
+  }
+  triangles = std::move(output);
+}
+
+}  // namespace UT::Mesh
@@ -0,0 +1,33 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace UT::Mesh {
+
+// Size of the simulated post-transform vertex cache.
+constexpr std::size_t CacheSize = 32;
+
+// Reorders triangles for a post-transform vertex cache without changing the winding.
+// Uses Tom Forsyth's linear-speed vertex cache optimisation with an LRU cache model.
+void Optimize(std::span<std::uint16_t> triangles);
+
+// Returns the number of vertex shader invocations with a FIFO cache of the given size.
+std::size_t GetTransforms(std::span<const std::uint16_t> triangles, std::size_t cache = CacheSize);
+
+// Returns a map from old to new vertex indices that orders vertices by first use.
+// Vertices that are not used keep their relative order at the end.
+std::vector<std::uint16_t> GetVertexOrder(std::span<const std::uint16_t> triangles, std::size_t vertices);
+
+// Removes triangles with quadric error metric edge collapses until the target is reached or no valid
+// collapse is left. Collapses move a vertex onto a neighbor, so no new vertices or attributes are created.
+// Locked vertices and vertices on open or non-manifold edges are never removed.
+void Simplify(
+  std::span<const std::array<float, 3>> positions,
+  const std::vector<bool>& locked,
+  std::vector<std::uint16_t>& triangles,
+  std::size_t target);
+
+}  // namespace UT::Mesh
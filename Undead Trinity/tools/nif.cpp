@@ -0,0 +1,807 @@
+#include "nif.hpp"
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <type_traits>
+
+namespace UT::Nif {
+namespace {
+
+static_assert(std::endian::native == std::endian::little);
+
+// Vertex attribute flags in the upper bits of the vertex description.
+constexpr std::uint64_t VertexFlagsShift = 44;
+constexpr std::uint64_t VertexFullPrecision = 0x400;
+
+float GetHalf(std::uint16_t value) noexcept
+{
+  const auto sign = static_cast<std::uint32_t>(value & 0x8000) << 16;
+  const auto exponent = static_cast<std::uint32_t>(value >> 10) & 0x1F;
+  const auto mantissa = static_cast<std::uint32_t>(value) & 0x3FF;
+  if (!exponent) {
+    const auto magnitude = static_cast<float>(mantissa) / static_cast<float>(1 << 24);
+    return sign ? -magnitude : magnitude;
+  }
+  if (exponent == 0x1F) {
+    return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+  }
+  return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+class Reader {
+public:
+  explicit Reader(Bytes data) noexcept :
+    data_(data)
+  {}
+
+  template <class T>
+  bool Read(T& value) noexcept
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (data_.size() - offset_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  template <class T>
+  bool Read(std::vector<T>& values, std::size_t count)
+  {
+    if ((data_.size() - offset_) / sizeof(T) < count) {
+      return false;
+    }
+    values.resize(count);
+    std::memcpy(values.data(), data_.data() + offset_, count * sizeof(T));
+    offset_ += count * sizeof(T);
+    return true;
+  }
+
+  bool Read(Bytes& bytes, std::size_t size) noexcept
+  {
+    if (data_.size() - offset_ < size) {
+      return false;
+    }
+    bytes = data_.subspan(offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  bool Read(std::string_view& string, std::size_t size) noexcept
+  {
+    Bytes bytes;
+    if (!Read(bytes, size)) {
+      return false;
+    }
+    string = { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+    return true;
+  }
+
+  bool Skip(std::size_t size) noexcept
+  {
+    if (data_.size() - offset_ < size) {
+      return false;
+    }
+    offset_ += size;
+    return true;
+  }
+
+  std::size_t GetOffset() const noexcept
+  {
+    return offset_;
+  }
+
+  bool Done() const noexcept
+  {
+    return offset_ == data_.size();
+  }
+
+private:
+  Bytes data_;
+  std::size_t offset_{ 0 };
+};
+
+template <class T>
+void Put(std::vector<std::uint8_t>& buffer, const T& value)
+{
+  static_assert(std::is_trivially_copyable_v<T>);
+  const auto data = reinterpret_cast<const std::uint8_t*>(&value);
+  buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+template <class T>
+void Put(std::vector<std::uint8_t>& buffer, const std::vector<T>& values)
+{
+  const auto data = reinterpret_cast<const std::uint8_t*>(values.data());
+  buffer.insert(buffer.end(), data, data + values.size() * sizeof(T));
+}
+
+void Put(std::vector<std::uint8_t>& buffer, Bytes bytes)
+{
+  buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+}
+
+void Put(std::vector<std::uint8_t>& buffer, std::string_view string)
+{
+  buffer.insert(buffer.end(), string.begin(), string.end());
+}
+
+// Reads a list of references with a 32-bit count.
+bool GetReferences(Reader& reader, std::vector<std::size_t>& offsets)
+{
+  std::uint32_t count = 0;
+  if (!reader.Read(count)) {
+    return false;
+  }
+  for (std::uint32_t i = 0; i < count; i++) {
+    offsets.push_back(reader.GetOffset());
+    if (!reader.Skip(4)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// NiObjectNET: name, extra data list and controller.
+bool GetObjectLinks(Reader& reader, Links& links)
+{
+  links.strings.push_back(reader.GetOffset());
+  if (!reader.Skip(4) || !GetReferences(reader, links.references)) {
+    return false;
+  }
+  links.references.push_back(reader.GetOffset());
+  return reader.Skip(4);
+}
+
+// NiAVObject: flags, transform and collision object.
+bool GetNodeLinks(Reader& reader, Links& links)
+{
+  if (!GetObjectLinks(reader, links) || !reader.Skip(4 + 12 + 36 + 4)) {
+    return false;
+  }
+  links.references.push_back(reader.GetOffset());
+  return reader.Skip(4);
+}
+
+}  // namespace
+
+bool GetLinks(std::string_view type, Bytes data, Links& links)
+{
+  Reader reader{ data };
+  if (type == "NiNode" || type == "BSFadeNode" || type == "BSLeafAnimNode") {
+    return GetNodeLinks(reader, links) && GetReferences(reader, links.references) &&
+           GetReferences(reader, links.references);
+  }
+  if (type == "BSTriShape") {
+    if (!GetNodeLinks(reader, links) || !reader.Skip(16)) {
+      return false;
+    }
+    for (auto i = 0; i < 3; i++) {
+      links.references.push_back(reader.GetOffset());
+      if (!reader.Skip(4)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (type == "NiSkinInstance" || type == "BSDismemberSkinInstance") {
+    for (auto i = 0; i < 2; i++) {
+      links.references.push_back(reader.GetOffset());
+      if (!reader.Skip(4)) {
+        return false;
+      }
+    }
+    links.pointers.push_back(reader.GetOffset());
+    return reader.Skip(4) && GetReferences(reader, links.pointers);
+  }
+  if (type == "BSLightingShaderProperty") {
+    if (!reader.Skip(4) || !GetObjectLinks(reader, links) || !reader.Skip(4 + 4 + 8 + 8)) {
+      return false;
+    }
+    links.references.push_back(reader.GetOffset());
+    return reader.Skip(4);
+  }
+  if (type == "BSEffectShaderProperty" || type == "NiAlphaProperty") {
+    return GetObjectLinks(reader, links);
+  }
+  if (type == "NiStringExtraData" || type == "BSBehaviorGraphExtraData") {
+    links.strings.push_back(0);
+    links.strings.push_back(4);
+    return data.size() >= 8;
+  }
+  if (
+    type == "BSXFlags" || type == "NiIntegerExtraData" || type == "NiFloatExtraData" ||
+    type == "NiBooleanExtraData" || type == "BSDecalPlacementVectorExtraData")
+  {
+    links.strings.push_back(0);
+    return data.size() >= 4;
+  }
+  return type == "NiSkinData" || type == "NiSkinPartition" || type == "BSShaderTextureSet";
+}
+
+bool File::Parse(Bytes data)
+{
+  *this = {};
+  const auto end = std::ranges::find(data, '\n');
+  if (end == data.end()) {
+    return false;
+  }
+  Reader reader{ data };
+  if (!reader.Read(header_.line, static_cast<std::size_t>(end - data.begin()) + 1)) {
+    return false;
+  }
+  std::uint32_t version = 0;
+  std::uint8_t endian = 0;
+  std::uint32_t count = 0;
+  if (
+    !reader.Read(version) || !reader.Read(endian) || !reader.Read(header_.user_version) || !reader.Read(count) ||
+    !reader.Read(header_.stream_version) || version != Version || endian != 1 ||
+    header_.user_version != UserVersion || header_.stream_version != StreamVersion)
+  {
+    return false;
+  }
+  for (auto& info : header_.export_info) {
+    std::uint8_t size = 0;
+    if (!reader.Read(size) || !reader.Read(info, size)) {
+      return false;
+    }
+  }
+
+  std::uint16_t types = 0;
+  if (!reader.Read(types)) {
+    return false;
+  }
+  for (std::uint16_t i = 0; i < types; i++) {
+    std::uint32_t size = 0;
+    if (!reader.Read(size) || !reader.Read(header_.types.emplace_back(), size)) {
+      return false;
+    }
+  }
+  std::vector<std::uint16_t> indices;
+  std::vector<std::uint32_t> sizes;
+  if (!reader.Read(indices, count) || !reader.Read(sizes, count)) {
+    return false;
+  }
+
+  std::uint32_t strings = 0;
+  std::uint32_t length = 0;
+  if (!reader.Read(strings) || !reader.Read(length)) {
+    return false;
+  }
+  for (std::uint32_t i = 0; i < strings; i++) {
+    std::uint32_t size = 0;
+    if (!reader.Read(size) || !reader.Read(header_.strings.emplace_back(), size)) {
+      return false;
+    }
+  }
+  std::uint32_t groups = 0;
+  if (!reader.Read(groups) || !reader.Read(header_.groups, groups)) {
+    return false;
+  }
+
+  blocks_.resize(count);
+  for (std::uint32_t i = 0; i < count; i++) {
+    blocks_[i].type = indices[i];
+    if (indices[i] >= types || !reader.Read(blocks_[i].data, sizes[i])) {
+      return false;
+    }
+  }
+  std::uint32_t roots = 0;
+  return reader.Read(roots) && reader.Read(roots_, roots) && reader.Done();
+}
+
+std::vector<std::uint8_t> File::Write() const
+{
+  std::size_t size = header_.line.size() + 64;
+  for (const auto& block : blocks_) {
+    size += block.data.size() + 6;
+  }
+  std::vector<std::uint8_t> buffer;
+  buffer.reserve(size);
+  Put(buffer, header_.line);
+  Put(buffer, Version);
+  Put(buffer, std::uint8_t{ 1 });
+  Put(buffer, header_.user_version);
+  Put(buffer, static_cast<std::uint32_t>(blocks_.size()));
+  Put(buffer, header_.stream_version);
+  for (const auto info : header_.export_info) {
+    Put(buffer, static_cast<std::uint8_t>(info.size()));
+    Put(buffer, info);
+  }
+  Put(buffer, static_cast<std::uint16_t>(header_.types.size()));
+  for (const auto type : header_.types) {
+    Put(buffer, static_cast<std::uint32_t>(type.size()));
+    Put(buffer, type);
+  }
+  for (const auto& block : blocks_) {
+    Put(buffer, block.type);
+  }
+  for (const auto& block : blocks_) {
+    Put(buffer, static_cast<std::uint32_t>(block.data.size()));
+  }
+  std::size_t length = 0;
+  for (const auto string : header_.strings) {
+    length = std::max(length, string.size());
+  }
+  Put(buffer, static_cast<std::uint32_t>(header_.strings.size()));
+  Put(buffer, static_cast<std::uint32_t>(length));
+  for (const auto string : header_.strings) {
+    Put(buffer, static_cast<std::uint32_t>(string.size()));
+    Put(buffer, string);
+  }
+  Put(buffer, static_cast<std::uint32_t>(header_.groups.size()));
+  Put(buffer, header_.groups);
+  for (const auto& block : blocks_) {
+    Put(buffer, block.data);
+  }
+  Put(buffer, static_cast<std::uint32_t>(roots_.size()));
+  Put(buffer, roots_);
+  return buffer;
+}
+
+std::string_view File::GetType(std::size_t block) const noexcept
+{
+  return header_.types[blocks_[block].type];
+}
+
+std::string_view File::GetString(std::uint32_t index) const noexcept
+{
+  return index < header_.strings.size() ? header_.strings[index] : std::string_view{};
+}
+
+void File::Replace(std::size_t block, std::vector<std::uint8_t> data)
+{
+  blocks_[block].data = storage_.emplace_back(std::move(data));
+}
+
+bool File::Strip(Stripped& stripped)
+{
+  std::vector<Links> links(blocks_.size());
+  for (std::size_t i = 0; i < blocks_.size(); i++) {
+    if (!GetLinks(GetType(i), blocks_[i].data, links[i])) {
+      return false;
+    }
+  }
+  const auto get = [&](std::size_t block, std::size_t offset) noexcept {
+    std::int32_t value = 0;
+    std::memcpy(&value, blocks_[block].data.data() + offset, sizeof(value));
+    return value;
+  };
+
+  // Mark blocks that are reachable from the roots.
+  std::vector<bool> reachable(blocks_.size());
+  std::vector<std::int32_t> pending;
+  for (const auto root : roots_) {
+    if (root >= 0 && static_cast<std::size_t>(root) < blocks_.size()) {
+      pending.push_back(root);
+    }
+  }
+  while (!pending.empty()) {
+    const auto block = static_cast<std::size_t>(pending.back());
+    pending.pop_back();
+    if (reachable[block]) {
+      continue;
+    }
+    reachable[block] = true;
+    for (const auto offset : links[block].references) {
+      if (const auto target = get(block, offset); target >= 0 && static_cast<std::size_t>(target) < blocks_.size()) {
+        pending.push_back(target);
+      }
+    }
+  }
+
+  stripped.blocks.assign(blocks_.size(), -1);
+  std::int32_t next = 0;
+  for (std::size_t i = 0; i < blocks_.size(); i++) {
+    if (reachable[i]) {
+      stripped.blocks[i] = next++;
+    }
+  }
+
+  // Assign new string indices in the order of the old string table.
+  std::vector<std::int64_t> strings(header_.strings.size(), -1);
+  for (std::size_t i = 0; i < blocks_.size(); i++) {
+    if (!reachable[i]) {
+      continue;
+    }
+    for (const auto offset : links[i].strings) {
+      if (const auto index = static_cast<std::uint32_t>(get(i, offset)); index < strings.size()) {
+        strings[index] = 0;
+      }
+    }
+  }
+  std::vector<std::string_view> table;
+  for (std::size_t i = 0; i < strings.size(); i++) {
+    if (strings[i] == 0) {
+      strings[i] = static_cast<std::int64_t>(table.size());
+      table.push_back(header_.strings[i]);
+    }
+  }
+  stripped.strings = header_.strings.size() - table.size();
+
+  // Patch links that changed and keep other blocks in place.
+  std::vector<Block> blocks;
+  std::vector<std::uint16_t> types(header_.types.size(), 0xFFFF);
+  std::vector<std::string_view> names;
+  for (std::size_t i = 0; i < blocks_.size(); i++) {
+    if (!reachable[i]) {
+      continue;
+    }
+    auto block = blocks_[i];
+    if (types[block.type] == 0xFFFF) {
+      types[block.type] = static_cast<std::uint16_t>(names.size());
+      names.push_back(header_.types[block.type]);
+    }
+    block.type = types[block.type];
+
+    std::vector<std::pair<std::size_t, std::int32_t>> patches;
+    for (const auto offset : links[i].references) {
+      const auto target = get(i, offset);
+      const auto value = target >= 0 && static_cast<std::size_t>(target) < blocks_.size() ? stripped.blocks[target] : -1;
+      if (value != target) {
+        patches.emplace_back(offset, value);
+      }
+    }
+    for (const auto offset : links[i].pointers) {
+      const auto target = get(i, offset);
+      const auto value = target >= 0 && static_cast<std::size_t>(target) < blocks_.size() ? stripped.blocks[target] : -1;
+      if (value != target) {
+        patches.emplace_back(offset, value);
+      }
+    }
+    for (const auto offset : links[i].strings) {
+      const auto index = static_cast<std::uint32_t>(get(i, offset));
+      if (index < strings.size() && strings[index] != index) {
+        patches.emplace_back(offset, static_cast<std::int32_t>(strings[index]));
+      }
+    }
+    if (!patches.empty()) {
+      std::vector<std::uint8_t> data{ block.data.begin(), block.data.end() };
+      for (const auto& [offset, value] : patches) {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+      }
+      block.data = storage_.emplace_back(std::move(data));
+    }
+    blocks.push_back(block);
+  }
+
+  std::vector<std::int32_t> roots;
+  for (const auto root : roots_) {
+    if (root >= 0 && static_cast<std::size_t>(root) < blocks_.size()) {
+      roots.push_back(stripped.blocks[root]);
+    }
+  }
+  blocks_ = std::move(blocks);
+  roots_ = std::move(roots);
+  header_.types = std::move(names);
+  header_.strings = std::move(table);
+  return true;
+}
+
+bool SkinPartition::Parse(Bytes data)
+{
+  *this = {};
+  Reader reader{ data };
+  std::uint32_t count = 0;
+  std::uint32_t size = 0;
+  if (
+    !reader.Read(count) || !reader.Read(size) || !reader.Read(vertex_size) || !reader.Read(vertex_desc) ||
+    !reader.Read(vertex_data, size) || (vertex_size && size % vertex_size))
+  {
+    return false;
+  }
+  const auto flag = [&](bool& value) noexcept {
+    std::uint8_t byte = 0;
+    if (!reader.Read(byte)) {
+      return false;
+    }
+    value = byte != 0;
+    return true;
+  };
+  for (std::uint32_t i = 0; i < count; i++) {
+    auto& partition = partitions.emplace_back();
+    std::uint16_t triangles = 0;
+    std::uint16_t bones = 0;
+    std::uint16_t strips = 0;
+    if (
+      !reader.Read(partition.vertices) || !reader.Read(triangles) || !reader.Read(bones) || !reader.Read(strips) ||
+      !reader.Read(partition.weights_per_vertex) || !reader.Read(partition.bones, bones))
+    {
+      return false;
+    }
+    const auto vertices = partition.vertices;
+    const std::size_t weights = static_cast<std::size_t>(vertices) * partition.weights_per_vertex;
+    if (!flag(partition.has_vertex_map) || !reader.Read(partition.vertex_map, partition.has_vertex_map ? vertices : 0)) {
+      return false;
+    }
+    if (
+      !flag(partition.has_vertex_weights) ||
+      !reader.Read(partition.vertex_weights, partition.has_vertex_weights ? weights : 0))
+    {
+      return false;
+    }
+    if (!reader.Read(partition.strip_lengths, strips) || !flag(partition.has_faces)) {
+      return false;
+    }
+    std::size_t points = 0;
+    for (const auto length : partition.strip_lengths) {
+      points += length;
+    }
+    if (partition.has_faces) {
+      if (strips ? !reader.Read(partition.strips, points) : !reader.Read(partition.triangles, triangles * 3u)) {
+        return false;
+      }
+    }
+    if (
+      !flag(partition.has_bone_indices) ||
+      !reader.Read(partition.bone_indices, partition.has_bone_indices ? weights : 0))
+    {
+      return false;
+    }
+    if (
+      !reader.Read(partition.lod_level) || !flag(partition.global_vertex_buffer) ||
+      !reader.Read(partition.vertex_desc) || !reader.Read(partition.triangles_copy, triangles * 3u))
+    {
+      return false;
+    }
+    if (partition.has_faces && !strips && partition.triangles.size() != partition.triangles_copy.size()) {
+      return false;
+    }
+  }
+  return reader.Done();
+}
+
+std::vector<std::uint8_t> SkinPartition::Write() const
+{
+  std::vector<std::uint8_t> buffer;
+  buffer.reserve(vertex_data.size() + 1024);
+  Put(buffer, static_cast<std::uint32_t>(partitions.size()));
+  Put(buffer, static_cast<std::uint32_t>(vertex_data.size()));
+  Put(buffer, vertex_size);
+  Put(buffer, vertex_desc);
+  Put(buffer, vertex_data);
+  for (const auto& partition : partitions) {
+    Put(buffer, partition.vertices);
+    Put(buffer, static_cast<std::uint16_t>(partition.triangles_copy.size() / 3));
+    Put(buffer, static_cast<std::uint16_t>(partition.bones.size()));
+    Put(buffer, static_cast<std::uint16_t>(partition.strip_lengths.size()));
+    Put(buffer, partition.weights_per_vertex);
+    Put(buffer, partition.bones);
+    Put(buffer, static_cast<std::uint8_t>(partition.has_vertex_map));
+    Put(buffer, partition.vertex_map);
+    Put(buffer, static_cast<std::uint8_t>(partition.has_vertex_weights));
+    Put(buffer, partition.vertex_weights);
+    Put(buffer, partition.strip_lengths);
+    Put(buffer, static_cast<std::uint8_t>(partition.has_faces));
+    Put(buffer, partition.strips);
+    Put(buffer, partition.triangles);
+    Put(buffer, static_cast<std::uint8_t>(partition.has_bone_indices));
+    Put(buffer, partition.bone_indices);
+    Put(buffer, partition.lod_level);
+    Put(buffer, static_cast<std::uint8_t>(partition.global_vertex_buffer));
+    Put(buffer, partition.vertex_desc);
+    Put(buffer, partition.triangles_copy);
+  }
+  return buffer;
+}
+
+bool SkinData::Parse(Bytes data)
+{
+  *this = {};
+  Reader reader{ data };
+  std::uint32_t count = 0;
+  std::uint8_t weights = 0;
+  if (!reader.Read(transform, 52) || !reader.Read(count) || !reader.Read(weights)) {
+    return false;
+  }
+  has_vertex_weights = weights != 0;
+  for (std::uint32_t i = 0; i < count; i++) {
+    auto& bone = bones.emplace_back();
+    std::uint16_t vertices = 0;
+    if (!reader.Read(bone.transform, 52 + 16) || !reader.Read(vertices)) {
+      return false;
+    }
+    bone.weights.resize(vertices);
+    if (has_vertex_weights) {
+      for (auto& weight : bone.weights) {
+        if (!reader.Read(weight.vertex) || !reader.Read(weight.weight)) {
+          return false;
+        }
+      }
+    }
+  }
+  return reader.Done();
+}
+
+std::vector<std::uint8_t> SkinData::Write() const
+{
+  std::vector<std::uint8_t> buffer;
+  buffer.reserve(transform.size() + bones.size() * 128);
+  Put(buffer, transform);
+  Put(buffer, static_cast<std::uint32_t>(bones.size()));
+  Put(buffer, static_cast<std::uint8_t>(has_vertex_weights));
+  for (const auto& bone : bones) {
+    Put(buffer, bone.transform);
+    Put(buffer, static_cast<std::uint16_t>(bone.weights.size()));
+    if (has_vertex_weights) {
+      for (const auto& weight : bone.weights) {
+        Put(buffer, weight.vertex);
+        Put(buffer, weight.weight);
+      }
+    }
+  }
+  return buffer;
+}
+
+std::vector<Skin> GetSkins(const File& file)
+{
+  std::vector<Skin> skins;
+  const auto blocks = file.GetBlocks();
+  const auto get = [&](std::size_t block, std::size_t offset) noexcept {
+    std::int32_t value = 0;
+    std::memcpy(&value, blocks[block].data.data() + offset, sizeof(value));
+    return value;
+  };
+  for (std::size_t i = 0; i < blocks.size(); i++) {
+    Links links;
+    const auto type = file.GetType(i);
+    if (type != "NiSkinInstance" && type != "BSDismemberSkinInstance") {
+      continue;
+    }
+    if (!GetLinks(type, blocks[i].data, links) || links.references.size() < 2) {
+      continue;
+    }
+    const auto data = get(i, links.references[0]);
+    const auto partition = get(i, links.references[1]);
+    if (
+      data >= 0 && partition >= 0 && static_cast<std::size_t>(data) < blocks.size() &&
+      static_cast<std::size_t>(partition) < blocks.size() && file.GetType(data) == "NiSkinData" &&
+      file.GetType(partition) == "NiSkinPartition")
+    {
+      skins.push_back({ static_cast<std::size_t>(data), static_cast<std::size_t>(partition) });
+    }
+  }
+  return skins;
+}
+
+bool IsIndexed(const SkinPartition& partitions, const SkinData& data) noexcept
+{
+  const auto vertices = partitions.GetVertexCount();
+  const auto check = [&](std::uint16_t index) noexcept { return index < vertices; };
+  for (const auto& partition : partitions.partitions) {
+    if (
+      !partition.strip_lengths.empty() || !partition.has_vertex_map || partition.vertex_map.size() != partition.vertices ||
+      partition.triangles != partition.triangles_copy || !std::ranges::all_of(partition.vertex_map, check) ||
+      !std::ranges::all_of(partition.triangles, check))
+    {
+      return false;
+    }
+  }
+  if (data.has_vertex_weights) {
+    for (const auto& bone : data.bones) {
+      if (!std::ranges::all_of(bone.weights, [&](const Weight& weight) noexcept { return check(weight.vertex); })) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<std::array<float, 3>> GetPositions(const SkinPartition& partitions)
+{
+  const auto precise = (partitions.vertex_desc >> VertexFlagsShift) & VertexFullPrecision;
+  if (partitions.vertex_size < (precise ? 12u : 6u)) {
+    return {};
+  }
+  std::vector<std::array<float, 3>> positions(partitions.GetVertexCount());
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    const auto vertex = partitions.GetVertex(i);
+    for (std::size_t j = 0; j < 3; j++) {
+      if (precise) {
+        std::memcpy(&positions[i][j], vertex.data() + j * 4, 4);
+      } else {
+        std::uint16_t half = 0;
+        std::memcpy(&half, vertex.data() + j * 2, 2);
+        positions[i][j] = GetHalf(half);
+      }
+    }
+  }
+  return positions;
+}
+
+void Reorder(SkinPartition& partitions, SkinData& data)
+{
+  std::vector<std::uint16_t> triangles;
+  for (const auto& partition : partitions.partitions) {
+    triangles.insert(triangles.end(), partition.triangles.begin(), partition.triangles.end());
+  }
+  const auto vertices = partitions.GetVertexCount();
+  const auto order = Mesh::GetVertexOrder(triangles, vertices);
+  std::vector<std::uint8_t> vertex_data(partitions.vertex_data.size());
+  for (std::size_t i = 0; i < vertices; i++) {
+    std::ranges::copy(partitions.GetVertex(i), vertex_data.begin() + order[i] * partitions.vertex_size);
+  }
+  partitions.vertex_data = std::move(vertex_data);
+  const auto remap = [&](std::vector<std::uint16_t>& indices) {
+    for (auto& index : indices) {
+      index = order[index];
+    }
+  };
+  for (auto& partition : partitions.partitions) {
+    remap(partition.vertex_map);
+    remap(partition.triangles);
+    remap(partition.triangles_copy);
+  }
+  if (data.has_vertex_weights) {
+    for (auto& bone : data.bones) {
+      for (auto& weight : bone.weights) {
+        weight.vertex = order[weight.vertex];
+      }
+    }
+  }
+}
+
+void Compact(SkinPartition& partitions, SkinData& data)
+{
+  constexpr auto unused = std::uint16_t{ 0xFFFF };
+  const auto vertices = partitions.GetVertexCount();
+  std::vector<std::uint16_t> map(vertices, unused);
+  std::vector<std::uint8_t> vertex_data;
+  std::uint16_t next = 0;
+  for (const auto& partition : partitions.partitions) {
+    for (const auto index : partition.triangles) {
+      if (map[index] == unused) {
+        map[index] = next++;
+        const auto vertex = partitions.GetVertex(index);
+        vertex_data.insert(vertex_data.end(), vertex.begin(), vertex.end());
+      }
+    }
+  }
+
+  for (auto& partition : partitions.partitions) {
+    std::vector<bool> used(vertices);
+    for (const auto index : partition.triangles) {
+      used[index] = true;
+    }
+    const std::size_t count = partition.weights_per_vertex;
+    Partition compact;
+    for (std::size_t i = 0; i < partition.vertex_map.size(); i++) {
+      const auto index = partition.vertex_map[i];
+      if (!used[index]) {
+        continue;
+      }
+      compact.vertex_map.push_back(map[index]);
+      if (partition.has_vertex_weights) {
+        const auto weights = partition.vertex_weights.begin() + static_cast<std::ptrdiff_t>(i * count);
+        compact.vertex_weights.insert(compact.vertex_weights.end(), weights, weights + static_cast<std::ptrdiff_t>(count));
+      }
+      if (partition.has_bone_indices) {
+        const auto indices = partition.bone_indices.begin() + static_cast<std::ptrdiff_t>(i * count);
+        compact.bone_indices.insert(compact.bone_indices.end(), indices, indices + static_cast<std::ptrdiff_t>(count));
+      }
+    }
+    partition.vertices = static_cast<std::uint16_t>(compact.vertex_map.size());
+    partition.vertex_map = std::move(compact.vertex_map);
+    partition.vertex_weights = std::move(compact.vertex_weights);
+    partition.bone_indices = std::move(compact.bone_indices);
+    for (auto& index : partition.triangles) {
+      index = map[index];
+    }
+    partition.triangles_copy = partition.triangles;
+  }
+
+  if (data.has_vertex_weights) {
+    for (auto& bone : data.bones) {
+      std::erase_if(bone.weights, [&](const Weight& weight) { return map[weight.vertex] == unused; });
+      for (auto& weight : bone.weights) {
+        weight.vertex = map[weight.vertex];
+      }
+    }
+  }
+  partitions.vertex_data = std::move(vertex_data);
+}
+
+}  // namespace UT::Nif
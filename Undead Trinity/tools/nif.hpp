@@ -0,0 +1,176 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace UT::Nif {
+
+// Gamebryo 20.2.0.7 files with the Skyrim SE user and stream version.
+constexpr std::uint32_t Version = 0x14020007;
+constexpr std::uint32_t UserVersion = 12;
+constexpr std::uint32_t StreamVersion = 100;
+
+using Bytes = std::span<const std::uint8_t>;
+
+struct Header {
+  std::string_view line;                      // format description including the newline
+  std::uint32_t user_version{ 0 };
+  std::uint32_t stream_version{ 0 };
+  std::array<std::string_view, 3> export_info;  // author, process script and export script
+  std::vector<std::string_view> types;
+  std::vector<std::string_view> strings;
+  std::vector<std::uint32_t> groups;
+};
+
+struct Block {
+  std::uint16_t type{ 0 };
+  Bytes data;
+};
+
+// Offsets of block references, block pointers and string table indices in a block.
+// References keep the target alive, pointers do not.
+struct Links {
+  std::vector<std::size_t> references;
+  std::vector<std::size_t> pointers;
+  std::vector<std::size_t> strings;
+};
+
+// Returns false when the block type is unknown or the block is too small.
+bool GetLinks(std::string_view type, Bytes data, Links& links);
+
+struct Stripped {
+  std::vector<std::int32_t> blocks;  // new index for every old block or -1
+  std::size_t strings{ 0 };          // number of removed strings
+};
+
+// File that references the parsed data without copying it.
+// Blocks that are replaced or modified are stored in the file.
+class File {
+public:
+  bool Parse(Bytes data);
+
+  // Serializes the header, blocks and footer.
+  std::vector<std::uint8_t> Write() const;
+
+  const Header& GetHeader() const noexcept
+  {
+    return header_;
+  }
+
+  std::span<const Block> GetBlocks() const noexcept
+  {
+    return blocks_;
+  }
+
+  std::span<const std::int32_t> GetRoots() const noexcept
+  {
+    return roots_;
+  }
+
+  std::string_view GetType(std::size_t block) const noexcept;
+
+  // Returns an empty string for invalid indices.
+  std::string_view GetString(std::uint32_t index) const noexcept;
+
+  void Replace(std::size_t block, std::vector<std::uint8_t> data);
+
+  // Removes blocks that are not reachable from the roots through references and strings
+  // that are not used by a block. Returns false without changes when a block has no schema.
+  bool Strip(Stripped& stripped);
+
+private:
+  Header header_;
+  std::vector<Block> blocks_;
+  std::vector<std::int32_t> roots_;
+  std::deque<std::vector<std::uint8_t>> storage_;
+};
+
+// Skin partition with the vertex data used by the renderer. Triangles in Skyrim SE files
+// index the shared vertex data, the vertex map translates partition vertices to it.
+struct Partition {
+  std::uint16_t vertices{ 0 };
+  std::uint16_t weights_per_vertex{ 0 };
+  std::vector<std::uint16_t> bones;
+  bool has_vertex_map{ false };
+  std::vector<std::uint16_t> vertex_map;
+  bool has_vertex_weights{ false };
+  std::vector<float> vertex_weights;
+  std::vector<std::uint16_t> strip_lengths;
+  bool has_faces{ false };
+  std::vector<std::uint16_t> strips;
+  std::vector<std::uint16_t> triangles;
+  bool has_bone_indices{ false };
+  std::vector<std::uint8_t> bone_indices;
+  std::uint8_t lod_level{ 0 };
+  bool global_vertex_buffer{ false };
+  std::uint64_t vertex_desc{ 0 };
+  std::vector<std::uint16_t> triangles_copy;
+};
+
+struct SkinPartition {
+  std::uint32_t vertex_size{ 0 };
+  std::uint64_t vertex_desc{ 0 };
+  std::vector<std::uint8_t> vertex_data;
+  std::vector<Partition> partitions;
+
+  bool Parse(Bytes data);
+  std::vector<std::uint8_t> Write() const;
+
+  std::size_t GetVertexCount() const noexcept
+  {
+    return vertex_size ? vertex_data.size() / vertex_size : 0;
+  }
+
+  Bytes GetVertex(std::size_t index) const noexcept
+  {
+    return Bytes{ vertex_data }.subspan(index * vertex_size, vertex_size);
+  }
+};
+
+struct Weight {
+  std::uint16_t vertex{ 0 };
+  float weight{ 0.0f };
+};
+
+struct Bone {
+  Bytes transform;              // skin transform and bounding sphere
+  std::vector<Weight> weights;  // only the size is valid without vertex weights
+};
+
+struct SkinData {
+  Bytes transform;
+  bool has_vertex_weights{ false };
+  std::vector<Bone> bones;
+
+  bool Parse(Bytes data);
+  std::vector<std::uint8_t> Write() const;
+};
+
+// Skin data and skin partition blocks of a skin instance.
+struct Skin {
+  std::size_t data{ 0 };
+  std::size_t partition{ 0 };
+};
+
+std::vector<Skin> GetSkins(const File& file);
+
+// Returns false when a partition uses strips or an index is out of range.
+bool IsIndexed(const SkinPartition& partitions, const SkinData& data) noexcept;
+
+// Returns the vertex positions. Vertices without full precision store half floats.
+std::vector<std::array<float, 3>> GetPositions(const SkinPartition& partitions);
+
+// Orders the vertex data by first use in the partition triangles.
+// Requires indexed partitions.
+void Reorder(SkinPartition& partitions, SkinData& data);
+
+// Removes vertices that are not used by the partition triangles from the vertex data,
+// the partition vertex maps, weights and bone indices, and the bone weights.
+// Requires indexed partitions.
+void Compact(SkinPartition& partitions, SkinData& data);
+
+}  // namespace UT::Nif
@@ -0,0 +1,424 @@
+// Optimizes skinned Skyrim SE meshes for the post-transform vertex cache.
+//
+//   undead_trinity_optimize [-c cache] [-o directory] [-k] [-n] mesh.nif...
+//
+// Reorders the triangles of every skin partition and the shared vertex data by first use, strips blocks
+// that are not reachable from the roots and unused strings, and writes the file in place or to the output
+// directory. Every written file is mapped again and compared to the original before it replaces the target.
+//
+//   -c  FIFO cache size used for the reported ACMR (default 32)
+//   -k  keep the vertex order, only reorder triangles
+//   -n  report without writing files
+#include "mapping.hpp"
+#include "mesh.hpp"
+#include "nif.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+struct Statistics {
+  std::size_t triangles{ 0 };
+  std::size_t transforms{ 0 };
+};
+
+Statistics GetStatistics(const Nif::File& file, std::size_t cache)
+{
+  Statistics statistics;
+  for (const auto& skin : Nif::GetSkins(file)) {
+    Nif::SkinPartition partitions;
+    if (!partitions.Parse(file.GetBlocks()[skin.partition].data)) {
+      continue;
+    }
+    for (const auto& partition : partitions.partitions) {
+      statistics.triangles += partition.triangles.size() / 3;
+      statistics.transforms += Mesh::GetTransforms(partition.triangles, cache);
+    }
+  }
+  return statistics;
+}
+
+// Reorders triangles and vertices of all skin partitions.
+bool Optimize(Nif::File& file, bool keep)
+{
+  for (const auto& skin : Nif::GetSkins(file)) {
+    Nif::SkinPartition partitions;
+    Nif::SkinData data;
+    if (!partitions.Parse(file.GetBlocks()[skin.partition].data) || !data.Parse(file.GetBlocks()[skin.data].data)) {
+      return false;
+    }
+    if (!Nif::IsIndexed(partitions, data)) {
+      continue;
+    }
+    for (auto& partition : partitions.partitions) {
+      Mesh::Optimize(partition.triangles);
+      partition.triangles_copy = partition.triangles;
+    }
+    if (!keep) {
+      Nif::Reorder(partitions, data);
+      file.Replace(skin.data, data.Write());
+    }
+    file.Replace(skin.partition, partitions.Write());
+  }
+  return true;
+}
+
+std::string GetKey(Nif::Bytes bytes)
+{
+  return { reinterpret_cast<const char*>(bytes.data()), bytes.size() };
+}
+
+// Returns triangles as vertex contents rotated to the smallest vertex, which keeps the winding.
+std::vector<std::string> GetTriangles(const Nif::SkinPartition& partitions, std::span<const std::uint16_t> triangles)
+{
+  std::vector<std::string> keys;
+  for (std::size_t i = 0; i + 2 < triangles.size(); i += 3) {
+    std::array<std::string, 3> corners;
+    for (std::size_t j = 0; j < 3; j++) {
+      corners[j] = GetKey(partitions.GetVertex(triangles[i + j]));
+    }
+    std::ranges::rotate(corners, std::ranges::min_element(corners));
+    keys.push_back(corners[0] + corners[1] + corners[2]);
+  }
+  std::ranges::sort(keys);
+  return keys;
+}
+
+// Returns partition vertices as vertex contents with their weights and bone indices.
+std::vector<std::string> GetVertices(const Nif::SkinPartition& partitions, const Nif::Partition& partition)
+{
+  std::vector<std::string> keys;
+  const std::size_t weights = partition.weights_per_vertex;
+  for (std::size_t i = 0; i < partition.vertex_map.size(); i++) {
+    auto key = GetKey(partitions.GetVertex(partition.vertex_map[i]));
+    if (partition.has_vertex_weights) {
+      key.append(reinterpret_cast<const char*>(partition.vertex_weights.data() + i * weights), weights * sizeof(float));
+    }
+    if (partition.has_bone_indices) {
+      key.append(reinterpret_cast<const char*>(partition.bone_indices.data() + i * weights), weights);
+    }
+    keys.push_back(std::move(key));
+  }
+  std::ranges::sort(keys);
+  return keys;
+}
+
+// Returns bone weights as vertex contents and weights.
+std::vector<std::string> GetWeights(const Nif::SkinPartition& partitions, const Nif::Bone& bone)
+{
+  std::vector<std::string> keys;
+  for (const auto& weight : bone.weights) {
+    auto key = GetKey(partitions.GetVertex(weight.vertex));
+    key.append(reinterpret_cast<const char*>(&weight.weight), sizeof(weight.weight));
+    keys.push_back(std::move(key));
+  }
+  std::ranges::sort(keys);
+  return keys;
+}
+
+// Compares the skin geometry of two blocks by vertex contents.
+const char* CompareSkin(const Nif::File& a, const Nif::Skin& as, const Nif::File& b, const Nif::Skin& bs)
+{
+  Nif::SkinPartition ap;
+  Nif::SkinPartition bp;
+  Nif::SkinData ad;
+  Nif::SkinData bd;
+  if (
+    !ap.Parse(a.GetBlocks()[as.partition].data) || !ad.Parse(a.GetBlocks()[as.data].data) ||
+    !bp.Parse(b.GetBlocks()[bs.partition].data) || !bd.Parse(b.GetBlocks()[bs.data].data))
+  {
+    return "skin blocks could not be parsed";
+  }
+  if (!Nif::IsIndexed(ap, ad)) {
+    // Compare the original bytes, which is the case for files that were not optimized.
+    return ap.Write() == bp.Write() && ad.Write() == bd.Write() ? nullptr : "skin blocks differ";
+  }
+  if (!Nif::IsIndexed(bp, bd)) {
+    return "vertex index out of range";
+  }
+  if (ap.vertex_size != bp.vertex_size || ap.vertex_desc != bp.vertex_desc || ap.GetVertexCount() != bp.GetVertexCount()) {
+    return "vertex format differs";
+  }
+  std::vector<std::string> av;
+  std::vector<std::string> bv;
+  for (std::size_t i = 0; i < ap.GetVertexCount(); i++) {
+    av.push_back(GetKey(ap.GetVertex(i)));
+    bv.push_back(GetKey(bp.GetVertex(i)));
+  }
+  std::ranges::sort(av);
+  std::ranges::sort(bv);
+  if (av != bv) {
+    return "vertex data differs";
+  }
+  if (ap.partitions.size() != bp.partitions.size()) {
+    return "partition count differs";
+  }
+  for (std::size_t i = 0; i < ap.partitions.size(); i++) {
+    const auto& x = ap.partitions[i];
+    const auto& y = bp.partitions[i];
+    if (
+      x.vertices != y.vertices || x.weights_per_vertex != y.weights_per_vertex || x.bones != y.bones ||
+      x.has_vertex_map != y.has_vertex_map || x.has_vertex_weights != y.has_vertex_weights ||
+      x.has_faces != y.has_faces || x.has_bone_indices != y.has_bone_indices || x.lod_level != y.lod_level ||
+      x.global_vertex_buffer != y.global_vertex_buffer || x.vertex_desc != y.vertex_desc)
+    {
+      return "partition header differs";
+    }
+    if (
+      GetTriangles(ap, x.triangles) != GetTriangles(bp, y.triangles) ||
+      GetTriangles(ap, x.triangles_copy) != GetTriangles(bp, y.triangles_copy))
+    {
+      return "partition triangles differ";
+    }
+    if (GetVertices(ap, x) != GetVertices(bp, y)) {
+      return "partition vertices differ";
+    }
+  }
+  if (
+    ad.has_vertex_weights != bd.has_vertex_weights || ad.bones.size() != bd.bones.size() ||
+    !std::ranges::equal(ad.transform, bd.transform))
+  {
+    return "skin data header differs";
+  }
+  for (std::size_t i = 0; i < ad.bones.size(); i++) {
+    if (
+      !std::ranges::equal(ad.bones[i].transform, bd.bones[i].transform) ||
+      ad.bones[i].weights.size() != bd.bones[i].weights.size())
+    {
+      return "bone differs";
+    }
+    if (ad.has_vertex_weights && GetWeights(ap, ad.bones[i]) != GetWeights(bp, bd.bones[i])) {
+      return "bone weights differ";
+    }
+  }
+  return nullptr;
+}
+
+// Compares an optimized file to the original. Returns an error or nullptr.
+const char* Verify(const Nif::File& a, const Nif::File& b, std::span<const std::int32_t> map)
+{
+  const auto& ah = a.GetHeader();
+  const auto& bh = b.GetHeader();
+  if (
+    ah.line != bh.line || ah.user_version != bh.user_version || ah.stream_version != bh.stream_version ||
+    ah.export_info != bh.export_info || ah.groups != bh.groups)
+  {
+    return "header differs";
+  }
+  const auto ab = a.GetBlocks();
+  const auto bb = b.GetBlocks();
+  if (map.size() != ab.size()) {
+    return "block map size differs";
+  }
+  const auto get = [](Nif::Bytes data, std::size_t offset) {
+    std::int32_t value = 0;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+  };
+  const auto target = [&](std::int32_t block) {
+    return block >= 0 && static_cast<std::size_t>(block) < map.size() ? map[block] : -1;
+  };
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < ab.size(); i++) {
+    if (map[i] < 0) {
+      continue;
+    }
+    kept++;
+    const auto j = static_cast<std::size_t>(map[i]);
+    if (j >= bb.size() || a.GetType(i) != b.GetType(j)) {
+      return "block type differs";
+    }
+    const auto type = a.GetType(i);
+    if (type == "NiSkinData" || type == "NiSkinPartition") {
+      continue;
+    }
+    Nif::Links al;
+    Nif::Links bl;
+    const auto known = Nif::GetLinks(type, ab[i].data, al);
+    if (known != Nif::GetLinks(type, bb[j].data, bl) || ab[i].data.size() != bb[j].data.size()) {
+      return "block size differs";
+    }
+    std::vector<std::uint8_t> x{ ab[i].data.begin(), ab[i].data.end() };
+    std::vector<std::uint8_t> y{ bb[j].data.begin(), bb[j].data.end() };
+    if (known) {
+      for (const auto& [ao, bo] : { std::pair{ &al.references, &bl.references }, { &al.pointers, &bl.pointers } }) {
+        for (std::size_t k = 0; k < ao->size(); k++) {
+          if (k >= bo->size() || (*ao)[k] != (*bo)[k] || target(get(x, (*ao)[k])) != get(y, (*bo)[k])) {
+            return "block link differs";
+          }
+          std::memset(x.data() + (*ao)[k], 0, 4);
+          std::memset(y.data() + (*bo)[k], 0, 4);
+        }
+      }
+      for (std::size_t k = 0; k < al.strings.size(); k++) {
+        const auto offset = al.strings[k];
+        if (
+          k >= bl.strings.size() || offset != bl.strings[k] ||
+          a.GetString(static_cast<std::uint32_t>(get(x, offset))) !=
+            b.GetString(static_cast<std::uint32_t>(get(y, offset))))
+        {
+          return "block string differs";
+        }
+        std::memset(x.data() + offset, 0, 4);
+        std::memset(y.data() + offset, 0, 4);
+      }
+    }
+    if (x != y) {
+      return "block data differs";
+    }
+  }
+  if (kept != bb.size()) {
+    return "block count differs";
+  }
+
+  const auto ar = a.GetRoots();
+  const auto br = b.GetRoots();
+  if (ar.size() != br.size()) {
+    return "root count differs";
+  }
+  for (std::size_t i = 0; i < ar.size(); i++) {
+    if (target(ar[i]) != br[i]) {
+      return "root differs";
+    }
+  }
+
+  auto as = Nif::GetSkins(a);
+  std::erase_if(as, [&](const Nif::Skin& skin) { return map[skin.data] < 0 || map[skin.partition] < 0; });
+  const auto bs = Nif::GetSkins(b);
+  if (as.size() != bs.size()) {
+    return "skin count differs";
+  }
+  for (std::size_t i = 0; i < as.size(); i++) {
+    if (const auto error = CompareSkin(a, as[i], b, bs[i])) {
+      return error;
+    }
+  }
+  return nullptr;
+}
+
+bool Save(const std::filesystem::path& path, std::span<const std::uint8_t> data)
+{
+  std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  file.close();
+  return static_cast<bool>(file);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::size_t cache = Mesh::CacheSize;
+  std::filesystem::path directory;
+  auto keep = false;
+  auto dry = false;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view option{ argv[i] };
+    if (option == "-c" && i + 1 < argc) {
+      cache = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+    } else if (option == "-o" && i + 1 < argc) {
+      directory = argv[++i];
+    } else if (option == "-k") {
+      keep = true;
+    } else if (option == "-n") {
+      dry = true;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    std::fprintf(stderr, "usage: %s [-c cache] [-o directory] [-k] [-n] mesh.nif...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto result = EXIT_SUCCESS;
+  for (const auto file : files) {
+    const Mapping mapping{ file };
+    Nif::File original;
+    Nif::File nif;
+    if (!original.Parse(mapping.Data()) || !nif.Parse(mapping.Data())) {
+      std::fprintf(stderr, "%s: not a Skyrim SE mesh\n", file);
+      result = EXIT_FAILURE;
+      continue;
+    }
+    const auto before = GetStatistics(original, cache);
+    if (!Optimize(nif, keep)) {
+      std::fprintf(stderr, "%s: skin blocks could not be parsed\n", file);
+      result = EXIT_FAILURE;
+      continue;
+    }
+    Nif::Stripped stripped;
+    const auto strip = nif.Strip(stripped);
+    if (!strip) {
+      // Blocks without a schema may contain links, keep every block and string.
+      stripped.blocks.resize(original.GetBlocks().size());
+      for (std::size_t i = 0; i < stripped.blocks.size(); i++) {
+        stripped.blocks[i] = static_cast<std::int32_t>(i);
+      }
+      stripped.strings = 0;
+    }
+    const auto data = nif.Write();
+
+    // Map the written file again, so that the verification covers the serialization.
+    const auto target = directory.empty() ? std::filesystem::path{ file }
+                                          : directory / std::filesystem::path{ file }.filename();
+    auto temporary = target;
+    temporary += ".tmp";
+    Nif::File written;
+    const char* error = nullptr;
+    if (dry) {
+      error = written.Parse(data) ? Verify(original, written, stripped.blocks) : "file could not be parsed";
+    } else if (!Save(temporary, data)) {
+      error = "file could not be written";
+    } else {
+      const Mapping output{ temporary.c_str() };
+      error = written.Parse(output.Data()) ? Verify(original, written, stripped.blocks) : "file could not be parsed";
+    }
+    std::error_code ec;
+    if (!dry && !error) {
+      std::filesystem::rename(temporary, target, ec);
+      if (ec) {
+        error = "file could not be renamed";
+      }
+    }
+    if (error) {
+      if (!dry) {
+        std::filesystem::remove(temporary, ec);
+      }
+      std::fprintf(stderr, "%s: %s\n", file, error);
+      result = EXIT_FAILURE;
+      continue;
+    }
+
+    const auto after = GetStatistics(nif, cache);
+    const auto acmr = [](const Statistics& statistics) {
+      return statistics.triangles ? static_cast<double>(statistics.transforms) / statistics.triangles : 0.0;
+    };
+    const auto blocks = std::ranges::count(stripped.blocks, -1);
+    std::printf(
+      "%s: %zu -> %zu bytes, %zu triangles, acmr %.3f -> %.3f, %zu blocks and %zu strings stripped%s\n",
+      file,
+      mapping.Data().size(),
+      data.size(),
+      before.triangles,
+      acmr(before),
+      acmr(after),
+      static_cast<std::size_t>(blocks),
+      stripped.strings,
+      strip ? "" : " (unknown block types)");
+  }
+  return result;
+}
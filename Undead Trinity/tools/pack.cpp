@@ -0,0 +1,594 @@
+// Packs files into a Skyrim SE archive (BSA version 105) with LZ4 frame compression.
+//
+//   undead_trinity_pack [-C directory] [-c level] [-t threads] [-x extension]... -o archive.bsa path...
+//   undead_trinity_pack -v archive.bsa...
+//   undead_trinity_pack -e directory archive.bsa...
+//
+// Paths are files or directories relative to the -C directory and keep their relative path in the
+// archive. Files are compressed in parallel and stored uncompressed when compression does not help.
+// The written archive is read back and every file is compared to its source.
+//
+//   -c  LZ4 compression level, 3 and above use the high compression mode (default 9)
+//   -x  skip files with the extension, for example .psc
+//   -v  verify the index and decompress every file
+//   -e  extract all files to the directory
+#include <lz4frame.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint32_t Magic = 0x00415342;  // BSA
+constexpr std::uint32_t Version = 105;
+constexpr std::uint32_t HeaderSize = 36;
+
+// Archive flags.
+constexpr std::uint32_t DirectoryNames = 0x1;
+constexpr std::uint32_t FileNames = 0x2;
+constexpr std::uint32_t Compressed = 0x4;
+
+// File size bit that inverts the archive compression flag for a file.
+constexpr std::uint32_t Toggle = 0x40000000;
+
+struct Entry {
+  std::filesystem::path source;
+  std::string folder;  // lower case with backslashes
+  std::string name;    // lower case
+  std::uint64_t folder_hash{ 0 };
+  std::uint64_t hash{ 0 };
+  std::vector<std::uint8_t> data;  // stored data
+  std::uint32_t size{ 0 };         // original size
+  bool compressed{ false };
+};
+
+std::uint64_t GetHash(std::string_view path, bool folder)
+{
+  auto stem = path;
+  std::string_view extension;
+  if (!folder) {
+    if (const auto dot = path.rfind('.'); dot != std::string_view::npos) {
+      stem = path.substr(0, dot);
+      extension = path.substr(dot);
+    }
+  }
+  const auto at = [&](std::size_t i) { return static_cast<std::uint32_t>(static_cast<unsigned char>(stem[i])); };
+  std::uint32_t low = 0;
+  if (!stem.empty()) {
+    low = at(stem.size() - 1) | (stem.size() > 2 ? at(stem.size() - 2) << 8 : 0) |
+          static_cast<std::uint32_t>(stem.size()) << 16 | at(0) << 24;
+  }
+  if (extension == ".kf") {
+    low |= 0x80;
+  } else if (extension == ".nif") {
+    low |= 0x8000;
+  } else if (extension == ".dds") {
+    low |= 0x8080;
+  } else if (extension == ".wav") {
+    low |= 0x80000000;
+  }
+  std::uint32_t name = 0;
+  for (std::size_t i = 1; i + 2 < stem.size(); i++) {
+    name = name * 0x1003F + at(i);
+  }
+  std::uint32_t type = 0;
+  for (const auto c : extension) {
+    type = type * 0x1003F + static_cast<unsigned char>(c);
+  }
+  return static_cast<std::uint64_t>(name + type) << 32 | low;
+}
+
+std::string Normalize(std::string path)
+{
+  for (auto& c : path) {
+    c = c == '/' ? '\\' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return path;
+}
+
+// Returns the content type flags of a folder.
+std::uint16_t GetFileFlags(std::string_view folder)
+{
+  const auto top = folder.substr(0, folder.find('\\'));
+  if (top == "meshes") {
+    return 0x1;
+  }
+  if (top == "textures") {
+    return 0x2;
+  }
+  if (top == "interface") {
+    return 0x4;
+  }
+  if (top == "sound") {
+    return folder.starts_with("sound\\voice") ? 0x10 : 0x8;
+  }
+  if (top == "shadersfx") {
+    return 0x20;
+  }
+  return 0x100;
+}
+
+bool Read(const std::filesystem::path& path, std::vector<std::uint8_t>& data)
+{
+  std::ifstream file{ path, std::ios::binary | std::ios::ate };
+  if (!file) {
+    return false;
+  }
+  data.resize(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())));
+}
+
+bool Write(const std::filesystem::path& path, std::span<const std::uint8_t> data)
+{
+  std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  file.close();
+  return static_cast<bool>(file);
+}
+
+// Runs the function for every index on the given number of threads.
+void Parallel(std::size_t count, std::size_t threads, const std::function<void(std::size_t)>& function)
+{
+  std::atomic_size_t next{ 0 };
+  std::vector<std::jthread> workers;
+  for (std::size_t i = 0; i < std::min(threads, count); i++) {
+    workers.emplace_back([&]() {
+      for (auto index = next++; index < count; index = next++) {
+        function(index);
+      }
+    });
+  }
+}
+
+bool Compress(Entry& entry, int level)
+{
+  std::vector<std::uint8_t> source;
+  if (!Read(entry.source, source) || source.size() >= Toggle) {
+    return false;
+  }
+  entry.size = static_cast<std::uint32_t>(source.size());
+  LZ4F_preferences_t preferences{};
+  preferences.compressionLevel = level;
+  preferences.frameInfo.contentSize = source.size();
+  std::vector<std::uint8_t> frame(LZ4F_compressFrameBound(source.size(), &preferences));
+  const auto size = LZ4F_compressFrame(frame.data(), frame.size(), source.data(), source.size(), &preferences);
+  if (LZ4F_isError(size)) {
+    return false;
+  }
+  if (size + 4 < source.size()) {
+    entry.data.resize(4 + size);
+    std::memcpy(entry.data.data(), &entry.size, 4);
+    std::memcpy(entry.data.data() + 4, frame.data(), size);
+    entry.compressed = true;
+  } else {
+    entry.data = std::move(source);
+  }
+  return true;
+}
+
+bool Decompress(std::span<const std::uint8_t> frame, std::vector<std::uint8_t>& data)
+{
+  LZ4F_dctx* context = nullptr;
+  if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION))) {
+    return false;
+  }
+  auto source = frame.data();
+  auto remaining = frame.size();
+  std::size_t offset = 0;
+  auto hint = std::size_t{ 1 };
+  while (hint && remaining) {
+    auto written = data.size() - offset;
+    auto read = remaining;
+    hint = LZ4F_decompress(context, data.data() + offset, &written, source, &read, nullptr);
+    if (LZ4F_isError(hint) || (!written && !read)) {
+      LZ4F_freeDecompressionContext(context);
+      return false;
+    }
+    offset += written;
+    source += read;
+    remaining -= read;
+  }
+  LZ4F_freeDecompressionContext(context);
+  return !hint && offset == data.size();
+}
+
+template <class T>
+void Put(std::vector<std::uint8_t>& buffer, const T& value)
+{
+  const auto data = reinterpret_cast<const std::uint8_t*>(&value);
+  buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+std::vector<std::uint8_t> Build(std::vector<Entry>& entries)
+{
+  std::ranges::sort(entries, [](const Entry& a, const Entry& b) {
+    return a.folder_hash != b.folder_hash ? a.folder_hash < b.folder_hash : a.hash < b.hash;
+  });
+
+  std::vector<std::pair<std::size_t, std::size_t>> folders;  // first entry and count
+  std::uint32_t folder_names = 0;
+  std::uint32_t file_names = 0;
+  std::uint16_t flags = 0;
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    if (folders.empty() || entries[i].folder_hash != entries[folders.back().first].folder_hash) {
+      folders.emplace_back(i, 0);
+      folder_names += static_cast<std::uint32_t>(entries[i].folder.size() + 1);
+      flags |= GetFileFlags(entries[i].folder);
+    }
+    folders.back().second++;
+    file_names += static_cast<std::uint32_t>(entries[i].name.size() + 1);
+  }
+
+  const auto records = HeaderSize + folders.size() * 24;
+  const auto blocks = records + folders.size() + folder_names + entries.size() * 16;
+  auto offset = blocks + file_names;
+
+  std::vector<std::uint8_t> buffer;
+  Put(buffer, Magic);
+  Put(buffer, Version);
+  Put(buffer, HeaderSize);
+  Put(buffer, DirectoryNames | FileNames | Compressed);
+  Put(buffer, static_cast<std::uint32_t>(folders.size()));
+  Put(buffer, static_cast<std::uint32_t>(entries.size()));
+  Put(buffer, folder_names);
+  Put(buffer, file_names);
+  Put(buffer, flags);
+  Put(buffer, std::uint16_t{ 0 });
+
+  auto block = records;
+  for (const auto& [first, count] : folders) {
+    Put(buffer, entries[first].folder_hash);
+    Put(buffer, static_cast<std::uint32_t>(count));
+    Put(buffer, std::uint32_t{ 0 });
+    Put(buffer, static_cast<std::uint64_t>(block + file_names));
+    block += 1 + entries[first].folder.size() + 1 + count * 16;
+  }
+  for (const auto& [first, count] : folders) {
+    const auto& folder = entries[first].folder;
+    Put(buffer, static_cast<std::uint8_t>(folder.size() + 1));
+    buffer.insert(buffer.end(), folder.begin(), folder.end());
+    buffer.push_back(0);
+    for (std::size_t i = first; i < first + count; i++) {
+      const auto& entry = entries[i];
+      Put(buffer, entry.hash);
+      Put(buffer, static_cast<std::uint32_t>(entry.data.size()) | (entry.compressed ? 0 : Toggle));
+      Put(buffer, static_cast<std::uint32_t>(offset));
+      offset += entry.data.size();
+    }
+  }
+  for (const auto& entry : entries) {
+    buffer.insert(buffer.end(), entry.name.begin(), entry.name.end());
+    buffer.push_back(0);
+  }
+  for (const auto& entry : entries) {
+    buffer.insert(buffer.end(), entry.data.begin(), entry.data.end());
+  }
+  return buffer;
+}
+
+struct File {
+  std::string path;  // folder and name
+  std::uint64_t hash{ 0 };
+  std::span<const std::uint8_t> data;
+  bool compressed{ false };
+};
+
+// Reads and checks the archive index. Returns an error or nullptr.
+const char* Parse(std::span<const std::uint8_t> archive, std::vector<File>& files)
+{
+  std::size_t position = 0;
+  const auto read = [&](auto& value) {
+    if (archive.size() - position < sizeof(value)) {
+      return false;
+    }
+    std::memcpy(&value, archive.data() + position, sizeof(value));
+    position += sizeof(value);
+    return true;
+  };
+  std::uint32_t magic = 0;
+  std::uint32_t version = 0;
+  std::uint32_t header = 0;
+  std::uint32_t flags = 0;
+  std::uint32_t folders = 0;
+  std::uint32_t count = 0;
+  std::uint32_t folder_names = 0;
+  std::uint32_t file_names = 0;
+  std::uint32_t types = 0;
+  if (
+    !read(magic) || !read(version) || !read(header) || !read(flags) || !read(folders) || !read(count) ||
+    !read(folder_names) || !read(file_names) || !read(types) || magic != Magic || version != Version ||
+    header != HeaderSize || (flags & (DirectoryNames | FileNames)) != (DirectoryNames | FileNames))
+  {
+    return "unsupported archive";
+  }
+
+  struct Folder {
+    std::uint64_t hash{ 0 };
+    std::uint32_t count{ 0 };
+    std::uint64_t offset{ 0 };
+  };
+  std::vector<Folder> records(folders);
+  for (auto& record : records) {
+    std::uint32_t padding = 0;
+    if (!read(record.hash) || !read(record.count) || !read(padding) || !read(record.offset)) {
+      return "truncated folder records";
+    }
+  }
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < records.size(); i++) {
+    if (i && records[i - 1].hash >= records[i].hash) {
+      return "folders are not sorted by hash";
+    }
+    if (position + file_names != records[i].offset) {
+      return "folder offset mismatch";
+    }
+    std::uint8_t length = 0;
+    if (!read(length) || !length || archive.size() - position < length) {
+      return "truncated folder name";
+    }
+    const std::string folder{ reinterpret_cast<const char*>(archive.data() + position), length - 1u };
+    position += length;
+    if (GetHash(folder, true) != records[i].hash) {
+      return "folder hash mismatch";
+    }
+    for (std::uint32_t j = 0; j < records[i].count; j++) {
+      std::uint32_t size = 0;
+      std::uint32_t offset = 0;
+      auto& file = files.emplace_back();
+      if (!read(file.hash) || !read(size) || !read(offset)) {
+        return "truncated file records";
+      }
+      if (j && files[files.size() - 2].hash >= file.hash) {
+        return "files are not sorted by hash";
+      }
+      file.compressed = ((flags & Compressed) != 0) != ((size & Toggle) != 0);
+      size &= ~Toggle;
+      if (offset > archive.size() || archive.size() - offset < size) {
+        return "file data out of range";
+      }
+      file.data = archive.subspan(offset, size);
+      file.path = folder + '\\';
+    }
+  }
+  if (files.size() != count) {
+    return "file count mismatch";
+  }
+  for (auto& file : files) {
+    const auto begin = reinterpret_cast<const char*>(archive.data() + position);
+    const auto end = std::find(begin, reinterpret_cast<const char*>(archive.data() + archive.size()), '\0');
+    if (end == reinterpret_cast<const char*>(archive.data() + archive.size())) {
+      return "truncated file names";
+    }
+    const std::string_view name{ begin, static_cast<std::size_t>(end - begin) };
+    if (GetHash(name, false) != file.hash) {
+      return "file hash mismatch";
+    }
+    file.path += name;
+    position += name.size() + 1;
+  }
+  return nullptr;
+}
+
+// Returns the original file data.
+bool Extract(const File& file, std::vector<std::uint8_t>& data)
+{
+  if (!file.compressed) {
+    data.assign(file.data.begin(), file.data.end());
+    return true;
+  }
+  std::uint32_t size = 0;
+  if (file.data.size() < 4) {
+    return false;
+  }
+  std::memcpy(&size, file.data.data(), 4);
+  data.resize(size);
+  return Decompress(file.data.subspan(4), data);
+}
+
+int Create(
+  const std::filesystem::path& directory,
+  const std::vector<std::string>& paths,
+  const std::vector<std::string>& excluded,
+  const std::filesystem::path& output,
+  int level,
+  std::size_t threads)
+{
+  std::vector<Entry> entries;
+  const auto add = [&](const std::filesystem::path& path) {
+    const auto extension = Normalize(path.extension().string());
+    if (std::ranges::find(excluded, extension) != excluded.end()) {
+      return;
+    }
+    auto& entry = entries.emplace_back();
+    entry.source = path;
+    const auto relative = path.lexically_relative(directory);
+    entry.folder = Normalize(relative.parent_path().generic_string());
+    entry.name = Normalize(relative.filename().string());
+    entry.folder_hash = GetHash(entry.folder, true);
+    entry.hash = GetHash(entry.name, false);
+  };
+  for (const auto& path : paths) {
+    const auto source = directory / path;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(source, ec)) {
+      add(source);
+      continue;
+    }
+    for (const auto& item : std::filesystem::recursive_directory_iterator{ source, ec }) {
+      if (item.is_regular_file()) {
+        add(item.path());
+      }
+    }
+    if (ec) {
+      std::fprintf(stderr, "%s: %s\n", source.string().c_str(), ec.message().c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  for (const auto& entry : entries) {
+    if (entry.folder.empty() || entry.folder.size() > 254 || entry.folder.starts_with("..")) {
+      std::fprintf(stderr, "%s: not in a folder below the archive root\n", entry.source.string().c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::atomic_bool failed{ false };
+  Parallel(entries.size(), threads, [&](std::size_t index) {
+    if (!Compress(entries[index], level)) {
+      std::fprintf(stderr, "%s: could not be compressed\n", entries[index].source.string().c_str());
+      failed = true;
+    }
+  });
+  if (failed) {
+    return EXIT_FAILURE;
+  }
+  const auto archive = Build(entries);
+  for (std::size_t i = 1; i < entries.size(); i++) {
+    if (entries[i].folder_hash == entries[i - 1].folder_hash && entries[i].hash == entries[i - 1].hash) {
+      std::fprintf(stderr, "%s: hash collision\n", entries[i].source.string().c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  if (!Write(output, archive)) {
+    std::fprintf(stderr, "%s: could not be written\n", output.string().c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Read the archive back and compare every file to its source.
+  std::vector<std::uint8_t> written;
+  std::vector<File> files;
+  const char* error = Read(output, written) ? Parse(written, files) : "could not be read";
+  if (!error && files.size() != entries.size()) {
+    error = "file count mismatch";
+  }
+  for (std::size_t i = 0; !error && i < files.size(); i++) {
+    std::vector<std::uint8_t> data;
+    std::vector<std::uint8_t> source;
+    if (!Extract(files[i], data) || !Read(entries[i].source, source) || data != source) {
+      error = "file data mismatch";
+    }
+  }
+  if (error) {
+    std::fprintf(stderr, "%s: %s\n", output.string().c_str(), error);
+    return EXIT_FAILURE;
+  }
+
+  std::size_t original = 0;
+  std::size_t compressed = 0;
+  for (const auto& entry : entries) {
+    original += entry.size;
+    compressed += entry.compressed ? 1 : 0;
+  }
+  std::printf(
+    "%s: %zu files, %zu compressed, %zu -> %zu bytes\n",
+    output.string().c_str(),
+    entries.size(),
+    compressed,
+    original,
+    archive.size());
+  return EXIT_SUCCESS;
+}
+
+int Open(const char* path, const std::filesystem::path& directory, std::size_t threads)
+{
+  std::vector<std::uint8_t> archive;
+  std::vector<File> files;
+  const char* error = Read(path, archive) ? Parse(archive, files) : "could not be read";
+  if (error) {
+    std::fprintf(stderr, "%s: %s\n", path, error);
+    return EXIT_FAILURE;
+  }
+  std::atomic_size_t failed{ 0 };
+  std::atomic_size_t size{ 0 };
+  Parallel(files.size(), threads, [&](std::size_t index) {
+    const auto& file = files[index];
+    std::vector<std::uint8_t> data;
+    if (!Extract(file, data)) {
+      std::fprintf(stderr, "%s: %s could not be decompressed\n", path, file.path.c_str());
+      failed++;
+      return;
+    }
+    size += data.size();
+    if (directory.empty()) {
+      return;
+    }
+    auto relative = file.path;
+    std::ranges::replace(relative, '\\', '/');
+    const auto target = directory / relative;
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+    if (!Write(target, data)) {
+      std::fprintf(stderr, "%s: %s could not be written\n", path, target.string().c_str());
+      failed++;
+    }
+  });
+  std::printf("%s: %zu files, %zu bytes, %zu errors\n", path, files.size(), size.load(), failed.load());
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::filesystem::path directory{ "." };
+  std::filesystem::path output;
+  std::filesystem::path extract;
+  std::vector<std::string> excluded;
+  std::vector<std::string> paths;
+  auto level = 9;
+  auto verify = false;
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  for (int i = 1; i < argc; i++) {
+    const std::string_view option{ argv[i] };
+    if (option == "-C" && i + 1 < argc) {
+      directory = argv[++i];
+    } else if (option == "-c" && i + 1 < argc) {
+      level = std::atoi(argv[++i]);
+    } else if (option == "-t" && i + 1 < argc) {
+      threads = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+    } else if (option == "-x" && i + 1 < argc) {
+      excluded.push_back(Normalize(argv[++i]));
+    } else if (option == "-o" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (option == "-e" && i + 1 < argc) {
+      extract = argv[++i];
+    } else if (option == "-v") {
+      verify = true;
+    } else {
+      paths.emplace_back(argv[i]);
+    }
+  }
+  if (paths.empty() || (output.empty() && !verify && extract.empty())) {
+    std::fprintf(
+      stderr,
+      "usage: %s [-C directory] [-c level] [-t threads] [-x extension]... -o archive.bsa path...\n"
+      "       %s -v archive.bsa...\n"
+      "       %s -e directory archive.bsa...\n",
+      argv[0],
+      argv[0],
+      argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (!output.empty()) {
+    return Create(directory, paths, excluded, output, level, threads);
+  }
+  auto result = EXIT_SUCCESS;
+  for (const auto& path : paths) {
+    if (Open(path.c_str(), extract, threads) != EXIT_SUCCESS) {
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,141 @@
+// Replays combat recordings through the heal triage at full speed.
+//
+//   undead_trinity_replay [-r repeat] recording.utr...
+//
+// Reports decoded frames, heal targets that differ from the recorded selection and throughput.
+// The health rates of trinity members and the player are estimated from the recorded health,
+// the ally is replayed with its recorded rate, because the plugin samples allies that are not
+// recorded before one of them needs healing the most.
+#include "mapping.hpp"
+
+#include <health.hpp>
+#include <record.hpp>
+#include <triage.hpp>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+struct Statistics {
+  std::size_t updates{ 0 };
+  std::size_t hits{ 0 };
+  std::size_t mismatches{ 0 };
+  double duration{ 0.0 };
+  bool valid{ true };
+};
+
+float GetDistance(const Record::Member& a, const Record::Member& b) noexcept
+{
+  const auto x = a.position[0] - b.position[0];
+  const auto y = a.position[1] - b.position[1];
+  const auto z = a.position[2] - b.position[2];
+  return std::sqrt(x * x + y * y + z * z);
+}
+
+Statistics Replay(std::span<const std::uint8_t> data) noexcept
+{
+  Statistics statistics;
+  Record::Reader reader{ data };
+  std::array<Health, Record::Members> health;
+  Record::Frame frame;
+  while (reader.Next(frame)) {
+    statistics.duration = frame.time;
+    if (frame.kind == Record::Kind::Hit) {
+      health[frame.member].Sample(frame.time, frame.members[frame.member].health);
+      statistics.hits++;
+      continue;
+    }
+    statistics.updates++;
+
+    Triage::Party party;
+    party.combat = frame.combat;
+    const auto& warlock = frame.members[Record::GetIndex(Triage::Target::Warlock)];
+    const auto member = [&](Triage::Target target) noexcept -> Triage::Member {
+      const auto index = Record::GetIndex(target);
+      const auto& state = frame.members[index];
+      if (!state.present) {
+        return {};
+      }
+      health[index].Sample(frame.time, state.health);
+      const auto distance = target == Triage::Target::Player ? 0.0f : GetDistance(warlock, state);
+      return { true, state.dead, health[index].GetValue(), health[index].GetRate(), distance };
+    };
+    party.player = member(Triage::Target::Player);
+    party.warlock = member(Triage::Target::Warlock);
+    party.knight = member(Triage::Target::Knight);
+    party.guard = member(Triage::Target::Guard);
+    if (const auto& ally = frame.members[Record::GetIndex(Triage::Target::Ally)]; ally.present) {
+      party.ally = { true, ally.dead, ally.health, ally.rate, GetDistance(warlock, ally) };
+    }
+
+    if (Triage::Select(party) != frame.target) {
+      statistics.mismatches++;
+    }
+  }
+  statistics.valid = reader.Valid();
+  return statistics;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::size_t repeat = 1;
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (std::string_view{ argv[i] } == "-r" && i + 1 < argc) {
+      repeat = std::max(std::strtoull(argv[++i], nullptr, 10), 1ull);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    std::fprintf(stderr, "usage: %s [-r repeat] recording.utr...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto result = EXIT_SUCCESS;
+  for (const auto file : files) {
+    const Mapping mapping{ file };
+    const auto data = mapping.Data();
+    if (data.empty() || !Record::Reader{ data }.Valid()) {
+      std::fprintf(stderr, "%s: not a recording\n", file);
+      result = EXIT_FAILURE;
+      continue;
+    }
+
+    Statistics statistics;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < repeat; i++) {
+      statistics = Replay(data);
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto frames = static_cast<double>(statistics.updates + statistics.hits) * static_cast<double>(repeat);
+    const auto gameplay = statistics.duration * static_cast<double>(repeat);
+    std::printf(
+      "%s: %zu updates, %zu hits, %zu mismatches, %.1f s gameplay, %.0f frames/s, %.0fx real time%s\n",
+      file,
+      statistics.updates,
+      statistics.hits,
+      statistics.mismatches,
+      statistics.duration,
+      frames / seconds,
+      gameplay / seconds,
+      statistics.valid ? "" : " (truncated)");
+    if (statistics.mismatches || !statistics.valid) {
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
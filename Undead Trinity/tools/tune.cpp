@@ -0,0 +1,413 @@
+// Searches heal thresholds by simulating fights through the heal triage.
+//
+//   undead_trinity_tune [-c candidates] [-f fights] [-t threads] [-s seed]
+//
+// Every candidate is scored on the same simulated fights. The score is the weighted share of
+// party members that survive a fight, with the player counting three times.
+#include <health.hpp>
+#include <triage.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace UT;
+
+// Simulation step in seconds.
+constexpr float Step = 0.25f;
+
+// Fight duration in seconds.
+constexpr float Duration = 45.0f;
+
+// Interval between triage updates (UT_Actor registers for updates every second).
+constexpr float Interval = 1.0f;
+
+// Delay between a package change and the first heal (package override dispatch and cast time).
+constexpr float Latency = 1.25f;
+
+// Health ratio restored per second while the warlock heals a target.
+constexpr float Heal = 0.12f;
+
+// Maximum distance of a heal spell.
+constexpr float Reach = 1000.0f;
+
+class Random {
+public:
+  explicit Random(std::uint64_t seed) noexcept :
+    state_(seed)
+  {}
+
+  std::uint64_t Next() noexcept
+  {
+    auto z = (state_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  float Uniform() noexcept
+  {
+    return static_cast<float>(Next() >> 40) / static_cast<float>(1 << 24);
+  }
+
+  float Uniform(float min, float max) noexcept
+  {
+    return min + (max - min) * Uniform();
+  }
+
+private:
+  std::uint64_t state_;
+};
+
+struct Member {
+  float health{ 1.0f };
+  float distance{ 0.0f };
+  float exposure{ 0.0f };  // damage per second relative to the party average
+  Health estimator;
+};
+
+// Simulates one fight and returns the weighted share of surviving members.
+float Simulate(const Triage::Thresholds& thresholds, std::uint64_t seed) noexcept
+{
+  constexpr std::array weights{ 3.0f, 1.0f, 1.5f, 1.5f };  // player, warlock, knight, guard
+
+  Random random{ seed };
+  std::array<Member, 4> members;
+  members[0].exposure = random.Uniform(0.6f, 1.0f);
+  members[1].exposure = random.Uniform(0.4f, 0.8f);
+  members[2].exposure = random.Uniform(0.9f, 1.4f);
+  members[3].exposure = random.Uniform(1.0f, 1.6f);
+  for (std::size_t i = 1; i < members.size(); i++) {
+    members[i].distance = random.Uniform(100.0f, 700.0f);
+  }
+
+  // Average health ratio lost per second and burst damage multiplier.
+  const auto intensity = random.Uniform(0.02f, 0.07f);
+  auto burst = 1.0f;
+
+  auto target = Triage::Target::None;
+  auto healing = Triage::Target::None;
+  auto ready = 0.0f;
+  auto update = 0.0f;
+  for (auto time = 0.0f; time < Duration; time += Step) {
+    // Apply damage and sample health on hits.
+    if (random.Uniform() < 0.02f) {
+      burst = random.Uniform(2.0f, 4.0f);
+    } else if (burst > 1.0f && random.Uniform() < 0.1f) {
+      burst = 1.0f;
+    }
+    for (auto& member : members) {
+      if (member.health <= 0.0f || random.Uniform() > 0.5f) {
+        continue;
+      }
+      const auto damage = intensity * member.exposure * burst * Step * 2.0f * -std::log(1.0f - random.Uniform());
+      member.health = std::max(member.health - damage, 0.0f);
+      member.estimator.Sample(time, member.health);
+    }
+    if (members[0].health <= 0.0f || members[1].health <= 0.0f) {
+      break;
+    }
+
+    // Move the knight and guard around the warlock.
+    for (std::size_t i = 2; i < members.size(); i++) {
+      members[i].distance = std::clamp(members[i].distance + random.Uniform(-60.0f, 60.0f), 50.0f, 1500.0f);
+    }
+
+    // Select a heal target.
+    if (time >= update) {
+      update = time + Interval;
+      Triage::Party party;
+      party.combat = true;
+      std::array<Triage::Member*, 4> states{ &party.player, &party.warlock, &party.knight, &party.guard };
+      for (std::size_t i = 0; i < members.size(); i++) {
+        auto& member = members[i];
+        member.estimator.Sample(time, member.health);
+        *states[i] = { true, member.health <= 0.0f, member.health, member.estimator.GetRate(), member.distance };
+      }
+      if (const auto selected = Triage::Select(party, thresholds); selected != target) {
+        target = selected;
+        ready = time + Latency;
+      }
+    }
+
+    // Heal the target once the package is active.
+    healing = time >= ready ? target : Triage::Target::None;
+    if (healing != Triage::Target::None) {
+      auto& member = members[static_cast<std::size_t>(healing) - 1];
+      if (member.health > 0.0f && member.distance < Reach) {
+        member.health = std::min(member.health + Heal * Step, 1.0f);
+      }
+    }
+  }
+
+  auto score = 0.0f;
+  auto total = 0.0f;
+  for (std::size_t i = 0; i < members.size(); i++) {
+    score += members[i].health > 0.0f ? weights[i] : 0.0f;
+    total += weights[i];
+  }
+  return score / total;
+}
+
+// Runs tasks on a fixed number of threads. Each worker owns a deque and pops from its back;
+// idle workers steal from the front of other deques.
+class Pool {
+public:
+  explicit Pool(std::size_t threads) :
+    queues_(std::max<std::size_t>(threads, 1))
+  {
+    for (std::size_t i = 0; i < queues_.size(); i++) {
+      threads_.emplace_back([this, i]() { Run(i); });
+    }
+  }
+
+  Pool(Pool&& other) = delete;
+  Pool(const Pool& other) = delete;
+  Pool& operator=(Pool&& other) = delete;
+  Pool& operator=(const Pool& other) = delete;
+
+  ~Pool()
+  {
+    {
+      std::lock_guard lock{ mutex_ };
+      stop_ = true;
+    }
+    condition_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  // Distributes tasks round-robin and waits until all of them finished.
+  void Run(std::vector<std::function<void()>> tasks)
+  {
+    pending_.store(tasks.size(), std::memory_order_release);
+    for (std::size_t i = 0; i < tasks.size(); i++) {
+      auto& queue = queues_[i % queues_.size()];
+      std::lock_guard lock{ queue.mutex };
+      queue.tasks.push_back(std::move(tasks[i]));
+    }
+    {
+      std::lock_guard lock{ mutex_ };
+      generation_++;
+    }
+    condition_.notify_all();
+
+    std::unique_lock lock{ mutex_ };
+    done_.wait(lock, [this]() { return pending_.load(std::memory_order_acquire) == 0; });
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool Pop(std::size_t index, std::function<void()>& task)
+  {
+    {
+      auto& queue = queues_[index];
+      std::lock_guard lock{ queue.mutex };
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+      }
+    }
+    for (std::size_t i = 1; i < queues_.size(); i++) {
+      auto& queue = queues_[(index + i) % queues_.size()];
+      std::lock_guard lock{ queue.mutex };
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Run(std::size_t index)
+  {
+    std::uint64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock lock{ mutex_ };
+        condition_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+        if (stop_) {
+          return;
+        }
+        generation = generation_;
+      }
+      std::function<void()> task;
+      while (Pop(index, task)) {
+        task();
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          std::lock_guard lock{ mutex_ };
+          done_.notify_all();
+        }
+      }
+    }
+  }
+
+  std::vector<Queue> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable done_;
+  std::atomic<std::size_t> pending_{ 0 };
+  std::uint64_t generation_{ 0 };
+  bool stop_{ false };
+};
+
+struct Candidate {
+  Triage::Thresholds thresholds;
+  double score{ 0.0 };
+};
+
+Triage::Thresholds Sample(Random& random, const Triage::Thresholds* center, float spread) noexcept
+{
+  const auto pick = [&](float value, float min, float max) noexcept {
+    if (!center) {
+      return random.Uniform(min, max);
+    }
+    const auto range = (max - min) * spread;
+    return std::clamp(value + random.Uniform(-range, range), min, max);
+  };
+  const auto base = center ? *center : Triage::Thresholds{};
+  Triage::Thresholds thresholds;
+  thresholds.player = pick(base.player, 0.5f, 1.0f);
+  thresholds.warlock = pick(base.warlock, 0.3f, 1.0f);
+  thresholds.knight = pick(base.knight, 0.3f, 1.0f);
+  thresholds.guard = pick(base.guard, 0.3f, 1.0f);
+  thresholds.floor = pick(base.floor, 0.0f, 0.3f);
+  thresholds.range = pick(base.range, 300.0f, 1500.0f);
+  thresholds.lookahead = pick(base.lookahead, 0.0f, 3.0f);
+  return thresholds;
+}
+
+void Print(const char* name, const Candidate& candidate) noexcept
+{
+  const auto& t = candidate.thresholds;
+  std::printf(
+    "%-8s %.4f  player %.2f  warlock %.2f  knight %.2f  guard %.2f  floor %.2f  range %4.0f  lookahead %.2f\n",
+    name,
+    candidate.score,
+    t.player,
+    t.warlock,
+    t.knight,
+    t.guard,
+    t.floor,
+    t.range,
+    t.lookahead);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::size_t candidates = 256;
+  std::size_t fights = 2000;
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::uint64_t seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string_view option{ argv[i] };
+    const auto value = std::strtoull(argv[i + 1], nullptr, 10);
+    if (option == "-c") {
+      candidates = std::max(value, 1ull);
+    } else if (option == "-f") {
+      fights = std::max(value, 1ull);
+    } else if (option == "-t") {
+      threads = std::max(value, 1ull);
+    } else if (option == "-s") {
+      seed = value;
+    } else {
+      std::fprintf(stderr, "usage: %s [-c candidates] [-f fights] [-t threads] [-s seed]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Start with the current thresholds, then sample the whole space and refine around the best candidate.
+  Random random{ seed };
+  std::vector<Candidate> population;
+  population.emplace_back();
+  for (std::size_t i = 1; i < candidates / 2; i++) {
+    population.push_back({ Sample(random, nullptr, 1.0f) });
+  }
+
+  Pool pool{ threads };
+  std::size_t simulated = 0;
+  const auto evaluate = [&](std::span<Candidate> batch) {
+    constexpr std::size_t Chunk = 250;
+    std::vector<std::function<void()>> tasks;
+    std::vector<std::vector<double>> scores(batch.size());
+    for (std::size_t c = 0; c < batch.size(); c++) {
+      scores[c].resize((fights + Chunk - 1) / Chunk);
+      for (std::size_t f = 0; f < fights; f += Chunk) {
+        tasks.emplace_back([&, c, f]() {
+          auto sum = 0.0;
+          for (auto i = f; i < std::min(f + Chunk, fights); i++) {
+            sum += Simulate(batch[c].thresholds, seed * 0x100000000ull + i);
+          }
+          scores[c][f / Chunk] = sum;
+        });
+      }
+    }
+    pool.Run(std::move(tasks));
+    for (std::size_t c = 0; c < batch.size(); c++) {
+      auto sum = 0.0;
+      for (const auto score : scores[c]) {
+        sum += score;
+      }
+      batch[c].score = sum / static_cast<double>(fights);
+    }
+    simulated += batch.size() * fights;
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  evaluate(population);
+  const auto baseline = population.front();
+  auto best = *std::max_element(population.begin(), population.end(), [](const auto& a, const auto& b) {
+    return a.score < b.score;
+  });
+
+  for (auto spread = 0.2f; population.size() < candidates; spread *= 0.7f) {
+    std::vector<Candidate> batch;
+    for (std::size_t i = 0; i < std::min<std::size_t>(candidates / 8 + 1, candidates - population.size()); i++) {
+      batch.push_back({ Sample(random, &best.thresholds, spread) });
+    }
+    evaluate(batch);
+    for (const auto& candidate : batch) {
+      if (candidate.score > best.score) {
+        best = candidate;
+      }
+      population.push_back(candidate);
+    }
+  }
+  const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Print("current", baseline);
+  Print("best", best);
+  std::printf(
+    "%zu candidates, %zu fights in %.2f s (%.0f fights/s on %zu threads)\n",
+    population.size(),
+    simulated,
+    seconds,
+    static_cast<double>(simulated) / seconds,
+    threads);
+  return EXIT_SUCCESS;
+}